@@ -0,0 +1,80 @@
+#include "Bench.h"
+
+#if HOST_BUILD
+#include <chrono>
+#endif
+
+const char *Bench::unit()
+{
+#if HOST_BUILD
+    return "ns";
+#else
+    return "cycles";
+#endif
+}
+
+Bench::Stamp Bench::now()
+{
+#if HOST_BUILD
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#else
+    return ESP.getCycleCount();
+#endif
+}
+
+void Bench::elapseUs(uint32_t us)
+{
+#if HOST_BUILD
+    HostClock::advanceUs(us);
+#else
+    (void)us;
+#endif
+}
+
+float Bench::callsPerUs(float perCall)
+{
+    if (perCall <= 0.0f)
+        return 0.0f;
+#if HOST_BUILD
+    return 1000.0f / perCall;
+#else
+    return ESP.getCpuFreqMHz() / perCall;
+#endif
+}
+
+const char *Bench::modeName(MetronomeMode mode)
+{
+    return mode == POLYRHYTHM ? "polyrhythm" : "polymeter";
+}
+
+// Host builds mute the engine's Serial chatter while measuring, so the
+// results go straight to stdout there
+#if HOST_BUILD
+#define BENCH_PRINTF printf
+#else
+#define BENCH_PRINTF Serial.printf
+#endif
+
+void Bench::printHeader()
+{
+    BENCH_PRINTF("bench,channels,length,mode,calls,unit,per_call\n");
+}
+
+void Bench::print(const BenchResult &result)
+{
+    BENCH_PRINTF("%s,%u,%u,%s,%lu,%s,%.1f\n",
+                 result.name,
+                 result.layout.channels,
+                 result.layout.barLength,
+                 modeName(result.layout.mode),
+                 (unsigned long)result.calls,
+                 unit(),
+                 result.perCall);
+    if (result.pixels)
+    {
+        BENCH_PRINTF("%s length %u: %.1f pixels/us\n", result.name, result.layout.barLength,
+                     result.pixels * callsPerUs(result.perCall));
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <Arduino.h>
+#include "MetronomeState.h"
+
+// Microbenchmark harness for the hot paths.
+// On the ESP32 a call is timed in CPU cycles from the CCOUNT register;
+// on host builds in nanoseconds from the steady clock. Each case runs in
+// batches and keeps the fastest batch, which filters out interrupts and
+// scheduler noise. Results are CSV, one line per case and layout:
+//
+//   bench,channels,length,mode,calls,unit,per_call
+//
+// Lines that are not results (engine chatter, summaries such as the
+// pixels per microsecond of throughput cases) never have that shape, so
+// a captured serial log can be compared as it is.
+
+struct BenchLayout
+{
+    uint8_t channels;   // Enabled channels
+    uint8_t barLength;  // Bar length of every enabled channel
+    MetronomeMode mode;
+};
+
+struct BenchResult
+{
+    char name[24];
+    BenchLayout layout;
+    uint32_t calls;
+    float perCall;      // Cycles on target, nanoseconds on host
+    uint16_t pixels;    // Pixels per call of a throughput case, else 0
+};
+
+class Bench
+{
+public:
+#if HOST_BUILD
+    typedef uint64_t Stamp;
+#else
+    typedef uint32_t Stamp;
+#endif
+
+    static const char *unit();
+    static Stamp now();
+
+    // Let `us` of device time pass between calls: the virtual clock on
+    // host (a few ns, counted in the result), nothing on target where
+    // time passes by itself
+    static void elapseUs(uint32_t us);
+
+    static const char *modeName(MetronomeMode mode);
+
+    // Calls per microsecond at `perCall` cycles or nanoseconds
+    static float callsPerUs(float perCall);
+
+    // Per-call cost of `fn`: the fastest of `batches` runs of `calls`
+    template <typename Fn>
+    static float measure(Fn &&fn, uint32_t calls, uint8_t batches = 5)
+    {
+        float best = 0.0f;
+        for (uint8_t b = 0; b < batches; b++)
+        {
+            Stamp start = now();
+            for (uint32_t i = 0; i < calls; i++)
+            {
+                fn();
+            }
+            Stamp elapsed = now() - start;
+            float perCall = float(elapsed) / float(calls);
+            if (b == 0 || perCall < best)
+            {
+                best = perCall;
+            }
+        }
+        return best;
+    }
+
+    static void printHeader();
+    static void print(const BenchResult &result);
+};
+
+// Runs every case over the layout sweep and collects the results
+void runBenchmarks(const char *filter, void (*onResult)(const BenchResult &result));
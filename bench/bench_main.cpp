@@ -0,0 +1,222 @@
+#include "Bench.h"
+
+#if HOST_BUILD
+#include <map>
+#include <string>
+#include <vector>
+
+// Host runner. Runs the suite (or reads results captured from a device
+// with --results), prints them as CSV and compares them with a baseline:
+//
+//   program [--filter NAME] [--runs N] [--baseline FILE] [--results FILE]
+//           [--write-baseline FILE] [--threshold PCT]
+//
+// Each case keeps its fastest of N runs of the suite (3 by default), as
+// nanosecond timings of the short cases wander with the host's clock
+// speed. Exits non-zero when any case is slower than its baseline by
+// more than the threshold (10% by default).
+
+struct BenchRow
+{
+    std::string unit;
+    float perCall;
+};
+
+static std::vector<BenchResult> results;
+static size_t collected = 0;
+
+static void collect(const BenchResult &result)
+{
+    if (collected < results.size())
+    {
+        BenchResult &best = results[collected];
+        best.perCall = min(best.perCall, result.perCall);
+    }
+    else
+    {
+        results.push_back(result);
+    }
+    collected++;
+}
+
+static std::string rowKey(const BenchResult &result)
+{
+    char key[64];
+    snprintf(key, sizeof(key), "%s,%u,%u,%s", result.name, result.layout.channels,
+             result.layout.barLength, Bench::modeName(result.layout.mode));
+    return key;
+}
+
+// Reads every result line of a CSV file or captured serial log; anything
+// else in the file is skipped
+static bool readResults(const char *path, std::vector<BenchResult> &out, std::map<std::string, BenchRow> *rows)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), file))
+    {
+        char name[24], mode[16], unit[16];
+        unsigned channels, length;
+        unsigned long calls;
+        float perCall;
+        if (sscanf(line, "%23[^,],%u,%u,%15[^,],%lu,%15[^,],%f", name, &channels, &length,
+                   mode, &calls, unit, &perCall) != 7)
+            continue;
+
+        BenchResult result = {};
+        snprintf(result.name, sizeof(result.name), "%s", name);
+        result.layout.channels = channels;
+        result.layout.barLength = length;
+        result.layout.mode = strcmp(mode, "polyrhythm") == 0 ? POLYRHYTHM : POLYMETER;
+        result.calls = calls;
+        result.perCall = perCall;
+        out.push_back(result);
+        if (rows)
+        {
+            (*rows)[rowKey(result)] = {unit, perCall};
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static bool writeBaseline(const char *path, const std::string &unit)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return false;
+    }
+    fprintf(file, "bench,channels,length,mode,calls,unit,per_call\n");
+    for (const BenchResult &result : results)
+    {
+        fprintf(file, "%s,%lu,%s,%.1f\n", rowKey(result).c_str(), (unsigned long)result.calls,
+                unit.c_str(), result.perCall);
+    }
+    fclose(file);
+    return true;
+}
+
+// Returns the number of cases slower than their baseline
+static int compare(const std::map<std::string, BenchRow> &baseline, const std::string &unit, float thresholdPct)
+{
+    int regressions = 0;
+    int compared = 0;
+    for (const BenchResult &result : results)
+    {
+        auto row = baseline.find(rowKey(result));
+        if (row == baseline.end() || row->second.unit != unit || row->second.perCall <= 0.0f)
+            continue;
+
+        compared++;
+        float change = (result.perCall / row->second.perCall - 1.0f) * 100.0f;
+        if (change > thresholdPct)
+        {
+            regressions++;
+            fprintf(stderr, "REGRESSION %s: %.1f -> %.1f %s (+%.0f%%)\n", rowKey(result).c_str(),
+                    row->second.perCall, result.perCall, unit.c_str(), change);
+        }
+    }
+    fprintf(stderr, "%d of %d cases within %.0f%% of the baseline\n", compared - regressions,
+            compared, thresholdPct);
+    return regressions;
+}
+
+int main(int argc, char **argv)
+{
+    const char *filter = nullptr;
+    const char *baselinePath = nullptr;
+    const char *resultsPath = nullptr;
+    const char *writePath = nullptr;
+    float thresholdPct = 10.0f;
+    int runs = 3;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--filter") && hasValue)
+            filter = argv[++i];
+        else if (!strcmp(argv[i], "--baseline") && hasValue)
+            baselinePath = argv[++i];
+        else if (!strcmp(argv[i], "--results") && hasValue)
+            resultsPath = argv[++i];
+        else if (!strcmp(argv[i], "--write-baseline") && hasValue)
+            writePath = argv[++i];
+        else if (!strcmp(argv[i], "--runs") && hasValue)
+            runs = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--threshold") && hasValue)
+            thresholdPct = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--filter NAME] [--runs N] [--baseline FILE] [--results FILE] "
+                            "[--write-baseline FILE] [--threshold PCT]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    // Captured device results are compared in cycles, host runs in ns
+    std::string unit = Bench::unit();
+    if (resultsPath)
+    {
+        std::map<std::string, BenchRow> rows;
+        if (!readResults(resultsPath, results, &rows))
+            return 2;
+        if (!rows.empty())
+            unit = rows.begin()->second.unit;
+    }
+    else
+    {
+        Serial.mute(true);
+        for (int run = 0; run < runs; run++)
+        {
+            collected = 0;
+            runBenchmarks(filter, collect);
+        }
+        Bench::printHeader();
+        for (const BenchResult &result : results)
+        {
+            Bench::print(result);
+        }
+    }
+
+    if (writePath && !writeBaseline(writePath, unit))
+        return 2;
+
+    if (!baselinePath)
+        return 0;
+
+    std::vector<BenchResult> baselineResults;
+    std::map<std::string, BenchRow> baseline;
+    if (!readResults(baselinePath, baselineResults, &baseline))
+        return 2;
+    return compare(baseline, unit, thresholdPct) ? 1 : 0;
+}
+
+#else
+
+// Device runner: prints the results once over serial, then idles. Capture
+// the log and compare it on the host with `--results`.
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000);
+    Serial.println("Benchmarks starting");
+    Bench::printHeader();
+    runBenchmarks(nullptr, Bench::print);
+    Serial.println("Benchmarks done");
+}
+
+void loop()
+{
+    delay(1000);
+}
+
+#endif
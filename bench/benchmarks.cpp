@@ -0,0 +1,229 @@
+#include "Bench.h"
+#include "config.h"
+#include "SolenoidController.h"
+#include "WirelessSync.h"
+#include "Timing.h"
+#include "LEDController.h"
+#include "LEDColor.h"
+#include "FrameClock.h"
+#include "Display.h"
+
+// The engine under test. There is no buzzer, and on the device the
+// solenoids are left unconfigured so nothing moves on the bench: Timing's
+// cost includes deciding and scheduling the strikes, not the pulses.
+static MetronomeState state;
+static SolenoidController solenoidController(SOLENOID_PIN, SOLENOID_PIN2);
+static WirelessSync wirelessSync;
+static Timing timing(state, wirelessSync, solenoidController, nullptr);
+static LEDController ledController;
+static Display display;
+
+// MetronomeState persists through the global config store; not here
+class ConfigStore;
+ConfigStore *globalConfigStore = nullptr;
+
+// Keeps the compiler from dropping results nobody reads
+static volatile uint8_t beatSink;
+
+static const uint8_t LENGTHS[] = {4, 7, 16};
+static const uint32_t FRAME_PERIOD_US = 1000000 / FRAME_RATE_HZ;
+
+static void applyLayout(const BenchLayout &layout)
+{
+    state.setRhythmMode(layout.mode);
+    for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++)
+    {
+        MetronomeChannel &channel = state.getChannel(i);
+        bool enabled = i < layout.channels;
+        if (channel.isEnabled() != enabled)
+        {
+            channel.toggleEnabled();
+        }
+        channel.setBarLength(layout.barLength);
+        // Every other step sounding
+        channel.setPattern(0x5555 & channel.getMaxPattern());
+    }
+    state.isRunning = true;
+    state.isPaused = false;
+}
+
+// Frame at 120 BPM, as FrameClock would hand it to the renderers
+static void advanceFrame(FrameInfo &frame)
+{
+    const uint32_t beatPeriodUs = 500000;
+    frame.frameIndex++;
+    frame.nowUs += FRAME_PERIOD_US;
+    if (frame.nowUs - frame.beatStartUs >= beatPeriodUs)
+    {
+        frame.beatNumber++;
+        frame.beatStartUs += beatPeriodUs;
+        for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++)
+        {
+            ledController.onChannelBeat(i, frame.beatStartUs);
+        }
+    }
+    frame.beatPeriodUs = beatPeriodUs;
+    frame.beatPhase = uint16_t((uint64_t(frame.nowUs - frame.beatStartUs) << 16) / beatPeriodUs);
+    frame.locked = true;
+}
+
+struct BenchCase
+{
+    const char *name;
+    uint32_t calls;
+    bool usesLayout;        // Depends on channel count and rhythm mode
+    float (*run)(const BenchLayout &layout, uint32_t calls);
+    uint16_t pixels;        // Pixels per call, for a pixels/us figure
+};
+
+static float benchClockPulse(const BenchLayout &, uint32_t calls)
+{
+    // One PPQN tick at 120 BPM
+    const uint32_t tickPeriodUs = 60000000 / (120 * 96);
+    static uint32_t tick = 0;
+    return Bench::measure([]()
+    {
+        timing.onClockPulse(tick++);
+        Bench::elapseUs(tickPeriodUs);
+    }, calls);
+}
+
+// Beat lookup for every channel over one tick, as the scheduler does it
+static float benchBeatState(const BenchLayout &, uint32_t calls)
+{
+    static int64_t tick = 0;
+    return Bench::measure([]()
+    {
+        uint8_t beats = 0;
+        for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++)
+        {
+            beats += state.getChannel(i).getBeatStateBetween(tick, tick + 1, state);
+        }
+        beatSink = beats;
+        tick++;
+    }, calls);
+}
+
+static float benchEuclidean(const BenchLayout &layout, uint32_t calls)
+{
+    MetronomeChannel &channel = state.getChannel(0);
+    uint8_t beats = layout.barLength / 2 + 1;
+    return Bench::measure([&]() { channel.generateEuclidean(beats); }, calls);
+}
+
+static float benchLedUpdate(const BenchLayout &, uint32_t calls)
+{
+    static FrameInfo frame = {};
+    return Bench::measure([]()
+    {
+        advanceFrame(frame);
+        Bench::elapseUs(FRAME_PERIOD_US);
+        ledController.update(state, frame);
+    }, calls);
+}
+
+// One frame of the colour pipeline over a strip of LED_COUNT pixels
+// showing a `length`-step pattern: the per-frame fade and gamma pass,
+// then a role lookup for every pixel
+static float benchColorPipeline(const BenchLayout &layout, uint32_t calls)
+{
+    static ColorPipeline pipeline;
+    static CRGB pixels[LED_COUNT];
+    static FrameInfo frame = {};
+    uint8_t length = layout.barLength;
+    uint16_t pattern = 0x5555;
+    return Bench::measure([&]()
+    {
+        advanceFrame(frame);
+        uint16_t flashPhase[PALETTE_COUNT];
+        for (uint8_t p = 0; p < PALETTE_COUNT; p++)
+        {
+            flashPhase[p] = frame.beatPhase;
+        }
+        pipeline.prepare(frame, flashPhase);
+
+        uint8_t current = frame.beatNumber % length;
+        const CRGB *colors = pipeline.colors(1);
+        for (uint16_t i = 0; i < LED_COUNT; i++)
+        {
+            uint8_t step = i * length / LED_COUNT;
+            bool active = pattern & (1 << step);
+            PixelRole role = step == current ? (active ? ROLE_CURRENT_ACTIVE : ROLE_CURRENT)
+                                             : (active ? ROLE_ACTIVE : ROLE_BACKGROUND);
+            pixels[i] = colors[role];
+        }
+        beatSink = pixels[frame.frameIndex % LED_COUNT].r;
+    }, calls);
+}
+
+static float benchDisplayUpdate(const BenchLayout &, uint32_t calls)
+{
+    static FrameInfo frame = {};
+    return Bench::measure([]()
+    {
+        advanceFrame(frame);
+        display.update(state, frame);
+    }, calls);
+}
+
+// Call counts are sized for the device; the host is fast enough for many
+// more, which keeps its timings steady enough to compare
+#if HOST_BUILD
+static const uint32_t CALL_SCALE = 50;
+#else
+static const uint32_t CALL_SCALE = 1;
+#endif
+
+static const BenchCase CASES[] = {
+    {"onClockPulse", 2000, true, benchClockPulse},
+    {"beatStateBetween", 5000, true, benchBeatState},
+    {"generateEuclidean", 200, false, benchEuclidean},
+    {"LEDController::update", 200, true, benchLedUpdate},
+    {"Display::update", 20, true, benchDisplayUpdate},
+    {"ColorPipeline", 500, false, benchColorPipeline, LED_COUNT},
+};
+
+void runBenchmarks(const char *filter, void (*onResult)(const BenchResult &result))
+{
+    static bool initialized = false;
+    if (!initialized)
+    {
+        initialized = true;
+#if HOST_BUILD
+        solenoidController.init();
+#endif
+        timing.init();
+        ledController.init();
+        display.begin();
+    }
+
+    for (const BenchCase &bench : CASES)
+    {
+        if (filter && !strstr(bench.name, filter))
+            continue;
+
+        for (uint8_t channels = 1; channels <= MetronomeState::CHANNEL_COUNT; channels++)
+        {
+            for (MetronomeMode mode : {POLYMETER, POLYRHYTHM})
+            {
+                // Layout-independent cases run once per length
+                if (!bench.usesLayout && (channels > 1 || mode != POLYMETER))
+                    continue;
+
+                for (uint8_t length : LENGTHS)
+                {
+                    BenchLayout layout = {channels, length, mode};
+                    applyLayout(layout);
+
+                    BenchResult result = {};
+                    strncpy(result.name, bench.name, sizeof(result.name) - 1);
+                    result.layout = layout;
+                    result.calls = bench.calls * CALL_SCALE;
+                    result.perCall = bench.run(layout, result.calls);
+                    result.pixels = bench.pixels;
+                    onResult(result);
+                }
+            }
+        }
+    }
+}
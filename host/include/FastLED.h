@@ -0,0 +1,160 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+// Host stand-in for the FastLED subset the LED pipeline uses: CRGB, the
+// 8-bit scaling helpers and a FastLED object whose show() only counts
+// frames and keeps the last one for inspection.
+
+inline uint8_t scale8(uint8_t value, uint8_t scale)
+{
+    return uint8_t((uint16_t(value) * (1 + uint16_t(scale))) >> 8);
+}
+
+inline uint8_t scale8_video(uint8_t value, uint8_t scale)
+{
+    return uint8_t(((uint16_t(value) * uint16_t(scale)) >> 8) + ((value && scale) ? 1 : 0));
+}
+
+inline uint8_t qadd8(uint8_t a, uint8_t b)
+{
+    uint16_t sum = uint16_t(a) + b;
+    return sum > 255 ? 255 : uint8_t(sum);
+}
+
+inline uint8_t qsub8(uint8_t a, uint8_t b)
+{
+    return a > b ? uint8_t(a - b) : 0;
+}
+
+struct CRGB
+{
+    union
+    {
+        struct
+        {
+            uint8_t r;
+            uint8_t g;
+            uint8_t b;
+        };
+        uint8_t raw[3];
+    };
+
+    enum HTMLColorCode : uint32_t
+    {
+        Black = 0x000000,
+        Blue = 0x0000FF,
+        Green = 0x008000,
+        Red = 0xFF0000,
+        White = 0xFFFFFF,
+    };
+
+    CRGB() = default;
+    constexpr CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+    constexpr CRGB(uint32_t colorcode)
+        : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b(colorcode & 0xFF) {}
+    constexpr CRGB(HTMLColorCode colorcode) : CRGB(uint32_t(colorcode)) {}
+
+    uint8_t &operator[](uint8_t index) { return raw[index]; }
+    const uint8_t &operator[](uint8_t index) const { return raw[index]; }
+
+    CRGB &nscale8(uint8_t scale)
+    {
+        r = scale8(r, scale);
+        g = scale8(g, scale);
+        b = scale8(b, scale);
+        return *this;
+    }
+
+    CRGB &operator+=(const CRGB &rhs)
+    {
+        r = qadd8(r, rhs.r);
+        g = qadd8(g, rhs.g);
+        b = qadd8(b, rhs.b);
+        return *this;
+    }
+
+    bool operator==(const CRGB &rhs) const { return r == rhs.r && g == rhs.g && b == rhs.b; }
+    bool operator!=(const CRGB &rhs) const { return !(*this == rhs); }
+};
+
+inline void fill_solid(CRGB *leds, int count, const CRGB &color)
+{
+    for (int i = 0; i < count; i++)
+    {
+        leds[i] = color;
+    }
+}
+
+enum EOrder
+{
+    RGB = 0012,
+    RBG = 0021,
+    GRB = 0102,
+    GBR = 0120,
+    BRG = 0201,
+    BGR = 0210
+};
+
+enum LEDColorCorrection : uint32_t
+{
+    TypicalLEDStrip = 0xFFB0F0,
+    UncorrectedColor = 0xFFFFFF
+};
+
+// Chipset tags for addLeds<>
+enum HostChipset
+{
+    WS2812,
+    WS2812B,
+    WS2811,
+    SK6812,
+    NEOPIXEL
+};
+
+class CLEDController
+{
+public:
+    CRGB *leds = nullptr;
+    int count = 0;
+
+    CLEDController &setCorrection(uint32_t) { return *this; }
+};
+
+class CFastLED
+{
+private:
+    CLEDController controller;
+    uint8_t brightness = 255;
+    uint32_t shows = 0;
+
+public:
+    template <int CHIPSET, int DATA_PIN, EOrder RGB_ORDER>
+    CLEDController &addLeds(CRGB *leds, int count)
+    {
+        controller.leds = leds;
+        controller.count = count;
+        return controller;
+    }
+
+    void setBrightness(uint8_t value) { brightness = value; }
+    uint8_t getBrightness() const { return brightness; }
+    void show() { shows++; }
+    void clear(bool writeData = false)
+    {
+        if (controller.leds)
+        {
+            fill_solid(controller.leds, controller.count, CRGB::Black);
+        }
+        if (writeData)
+        {
+            show();
+        }
+    }
+
+    // Host only
+    uint32_t getShowCount() const { return shows; }
+    const CLEDController &getController() const { return controller; }
+};
+
+extern CFastLED FastLED;
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+// Virtual time for host builds.
+// Nothing advances on its own: a test, benchmark or the simulator moves
+// the clock, and every shim timer that falls due on the way (uClock
+// ticks, esp_timer, Ticker, RMT frames, ESP-NOW delivery) runs at its own
+// timestamp, in order. Runs are therefore exactly repeatable.
+class HostClock
+{
+public:
+    using Callback = std::function<void()>;
+
+    static uint64_t nowUs();
+
+    // Run every event due up to `us` from now, or up to an absolute time
+    static void advanceUs(uint64_t us);
+    static void runUntilUs(uint64_t atUs);
+
+    // One-shot event at absolute time `atUs` (now if already past);
+    // returns an id for cancel()
+    static uint32_t schedule(uint64_t atUs, Callback callback);
+    static void cancel(uint32_t id);
+
+    // Time of the next pending event, or UINT64_MAX
+    static uint64_t nextEventUs();
+
+    // True while an event callback runs. A delay() inside one only moves
+    // the clock; the events it skips over run when the callback returns,
+    // late, as they would behind a busy task on the device.
+    static bool isDispatching();
+    static void skipUs(uint64_t us);
+
+    // Drop every event and go back to power-on
+    static void reset();
+};
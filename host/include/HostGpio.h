@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+// Pin and LEDC state written by the engine on host builds.
+// digitalWrite() and the GPIO set/clear registers both land here, so a
+// test can watch solenoid pulses and buzzer tones with their virtual
+// timestamps.
+class HostGpio
+{
+public:
+    static const uint8_t PIN_COUNT = 40;
+    static const uint8_t LEDC_CHANNELS = 16;
+
+    using PinListener = std::function<void(uint8_t pin, bool level, uint64_t us)>;
+    using LedcListener = std::function<void(uint8_t channel, double frequency, uint32_t duty, uint64_t us)>;
+
+    static bool level(uint8_t pin);
+    static void setInput(uint8_t pin, bool level);   // Drive an input pin
+    static void setAnalog(uint8_t pin, uint16_t value);
+
+    static uint32_t ledcDuty(uint8_t channel);
+    static double ledcFrequency(uint8_t channel);
+
+    static void onPinChange(PinListener listener);
+
+    // Every write to an output, before it takes effect, including writes
+    // that leave the level as it was (a pulse restarted while on)
+    static void onPinWrite(PinListener listener);
+    static void onLedcChange(LedcListener listener);
+
+    static void reset();
+
+    // Used by the shims
+    static void writeMask(uint8_t bank, uint32_t mask, bool level);
+    static void write(uint8_t pin, bool level);
+    static uint32_t readBank(uint8_t bank);
+    static uint16_t readAnalog(uint8_t pin);
+    static void setLedc(uint8_t channel, double frequency, uint32_t duty);
+};
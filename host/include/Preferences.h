@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Host stand-in for the arduino-esp32 Preferences (NVS) API.
+// Namespaces live in process memory and survive end()/begin(), so a test
+// can "reboot" the engine against what it wrote. HostNvs wipes the store
+// and counts writes for wear checks.
+class Preferences
+{
+private:
+    const char *name = nullptr;
+    bool readOnly = false;
+
+    bool putValue(const char *key, const void *value, size_t length);
+    bool getValue(const char *key, void *value, size_t length) const;
+
+public:
+    bool begin(const char *name, bool readOnly = false, const char *partitionLabel = nullptr);
+    void end();
+
+    bool clear();
+    bool remove(const char *key);
+    bool isKey(const char *key);
+
+    size_t putBool(const char *key, bool value);
+    size_t putUChar(const char *key, uint8_t value);
+    size_t putUShort(const char *key, uint16_t value);
+    size_t putUInt(const char *key, uint32_t value);
+    size_t putULong(const char *key, uint32_t value);
+    size_t putBytes(const char *key, const void *value, size_t length);
+
+    bool getBool(const char *key, bool defaultValue = false);
+    uint8_t getUChar(const char *key, uint8_t defaultValue = 0);
+    uint16_t getUShort(const char *key, uint16_t defaultValue = 0);
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+    uint32_t getULong(const char *key, uint32_t defaultValue = 0);
+    size_t getBytesLength(const char *key);
+    size_t getBytes(const char *key, void *buffer, size_t maxLength);
+};
+
+class HostNvs
+{
+public:
+    static void wipe();
+    static uint32_t writes(); // Successful put/remove/clear calls since wipe()
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+
+// Host stand-in for the arduino-esp32 Ticker on the virtual clock
+class Ticker
+{
+private:
+    typedef void (*callback_t)();
+
+    uint32_t event = 0;
+    uint32_t periodUs = 0;
+    callback_t callback = nullptr;
+
+    void arm(uint32_t us, bool repeat, callback_t function);
+    void fire();
+
+public:
+    ~Ticker() { detach(); }
+
+    void once(float seconds, callback_t function) { arm(uint32_t(seconds * 1e6f), false, function); }
+    void once_ms(uint32_t ms, callback_t function) { arm(ms * 1000, false, function); }
+    void attach(float seconds, callback_t function) { arm(uint32_t(seconds * 1e6f), true, function); }
+    void attach_ms(uint32_t ms, callback_t function) { arm(ms * 1000, true, function); }
+    void detach();
+    bool active() const { return event != 0; }
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+// Host stand-in for the U8g2 full-buffer SH1106 driver: draws into a real
+// 128x64 page buffer so rendering costs what it does on the device, minus
+// the I2C transfer. Text advances the cursor but renders no glyphs.
+
+#define U8G2_R0 0
+#define U8X8_PIN_NONE 255
+
+extern const uint8_t u8g2_font_t0_11_tr[];
+
+class U8G2_SH1106_128X64_NONAME_F_HW_I2C
+{
+public:
+    static const uint8_t WIDTH = 128;
+    static const uint8_t HEIGHT = 64;
+
+private:
+    uint8_t buffer[WIDTH * HEIGHT / 8] = {};
+    uint8_t drawColor = 1;
+    uint32_t frames = 0;
+
+public:
+    U8G2_SH1106_128X64_NONAME_F_HW_I2C(int rotation, int reset) { (void)rotation; (void)reset; }
+
+    bool begin() { return true; }
+    void setFont(const uint8_t *font) { (void)font; }
+    void setDrawColor(uint8_t color) { drawColor = color; }
+    void setBusClock(uint32_t hz) { (void)hz; }
+    void setPowerSave(uint8_t on) { (void)on; }
+
+    void clearBuffer() { memset(buffer, 0, sizeof(buffer)); }
+    void sendBuffer() { frames++; }
+
+    void drawPixel(int x, int y);
+    void drawHLine(int x, int y, int w);
+    void drawVLine(int x, int y, int h);
+    void drawBox(int x, int y, int w, int h);
+    void drawFrame(int x, int y, int w, int h);
+    void drawCircle(int x0, int y0, int r);
+    void drawDisc(int x0, int y0, int r);
+    int drawStr(int x, int y, const char *text);
+
+    // Host only
+    const uint8_t *getBuffer() const { return buffer; }
+    uint32_t getFrameCount() const { return frames; }
+};
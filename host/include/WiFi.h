@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <Arduino.h>
+
+#define WIFI_OFF 0
+#define WIFI_STA 1
+#define WIFI_AP 2
+
+// Host stand-in for the WiFi object: only the station MAC matters
+class WiFiClass
+{
+private:
+    uint8_t mac[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x01};
+
+public:
+    bool mode(int value) { (void)value; return true; }
+    uint8_t *macAddress(uint8_t *out);
+    String macAddress();
+
+    // Host only: give each simulated device its own address
+    void setMacAddress(const uint8_t *value);
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Host stand-in for ESP-NOW. Every send is a broadcast on a loopback
+// "air": after HostEspNow's latency the frame is handed to the receive
+// callback (the engine drops its own frames by device ID) and to a tap.
+// Tests inject frames from simulated peers and can drop a share of the
+// traffic to exercise lossy links.
+
+typedef int esp_err_t;
+#ifndef ESP_OK
+#define ESP_OK 0
+#endif
+#define ESP_ERR_ESPNOW_NOT_INIT 0x3069
+#define ESP_ERR_ESPNOW_ARG 0x306A
+#define ESP_NOW_ETH_ALEN 6
+#define ESP_NOW_MAX_DATA_LEN 250
+
+typedef struct
+{
+    uint8_t peer_addr[ESP_NOW_ETH_ALEN];
+    uint8_t lmk[16];
+    uint8_t channel;
+    int ifidx;
+    bool encrypt;
+    void *priv;
+} esp_now_peer_info_t;
+
+typedef void (*esp_now_recv_cb_t)(const uint8_t *mac, const uint8_t *data, int len);
+
+esp_err_t esp_now_init();
+esp_err_t esp_now_deinit();
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t callback);
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer);
+esp_err_t esp_now_send(const uint8_t *peerAddr, const uint8_t *data, size_t len);
+
+class HostEspNow
+{
+public:
+    using Tap = std::function<void(const uint8_t *mac, const uint8_t *data, int len, uint64_t us)>;
+
+    // Air time from send to receive (default 300 us)
+    static void setLatencyUs(uint32_t us);
+
+    // Drop this percentage of frames, from a seeded generator
+    static void setLossPercent(uint8_t percent, uint32_t seed = 1);
+
+    // See every frame this device sends, as it lands
+    static void setTap(Tap tap);
+
+    // Deliver a frame from a simulated peer after the latency
+    static void inject(const uint8_t *mac, const uint8_t *data, int len);
+
+    static uint32_t sentFrames();
+    static uint32_t droppedFrames();
+
+    static void reset();
+};
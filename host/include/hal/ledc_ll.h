@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <Arduino.h>
+
+// Host stand-in for the LEDC low-level register helpers, as far as a duty
+// update goes: the duty is latched when the update is started, landing
+// where ledcWrite() would. Channel numbering follows Arduino's, eight
+// channels per speed mode.
+
+typedef enum
+{
+    LEDC_HIGH_SPEED_MODE,
+    LEDC_LOW_SPEED_MODE
+} ledc_mode_t;
+
+typedef enum
+{
+    LEDC_DUTY_DIR_DECREASE,
+    LEDC_DUTY_DIR_INCREASE
+} ledc_duty_direction_t;
+
+typedef int ledc_channel_t;
+
+typedef struct
+{
+    uint32_t duty[2][8];    // Integer part of the pending duty
+} ledc_dev_t;
+
+extern ledc_dev_t LEDC;
+
+#define LEDC_LL_GET_HW() (&LEDC)
+
+static inline void ledc_ll_set_duty_int_part(ledc_dev_t *hw, ledc_mode_t mode, ledc_channel_t channel, uint32_t duty)
+{
+    hw->duty[mode][channel] = duty;
+}
+
+static inline void ledc_ll_set_duty_direction(ledc_dev_t *, ledc_mode_t, ledc_channel_t, ledc_duty_direction_t) {}
+static inline void ledc_ll_set_duty_num(ledc_dev_t *, ledc_mode_t, ledc_channel_t, uint32_t) {}
+static inline void ledc_ll_set_duty_cycle(ledc_dev_t *, ledc_mode_t, ledc_channel_t, uint32_t) {}
+static inline void ledc_ll_set_duty_scale(ledc_dev_t *, ledc_mode_t, ledc_channel_t, uint32_t) {}
+static inline void ledc_ll_set_sig_out_en(ledc_dev_t *, ledc_mode_t, ledc_channel_t, bool) {}
+static inline void ledc_ll_ls_channel_update(ledc_dev_t *, ledc_mode_t, ledc_channel_t) {}
+
+static inline void ledc_ll_set_duty_start(ledc_dev_t *hw, ledc_mode_t mode, ledc_channel_t channel, bool start)
+{
+    if (start)
+    {
+        ledcWrite(uint8_t(mode * 8 + channel), hw->duty[mode][channel]);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include "HostGpio.h"
+
+// Register-level GPIO access as the engine uses it: write-1-to-set and
+// write-1-to-clear masks per bank, and the input levels
+
+template <uint8_t Bank, bool Level>
+struct HostGpioWriteReg
+{
+    void operator=(uint32_t mask) volatile { HostGpio::writeMask(Bank, mask, Level); }
+};
+
+template <uint8_t Bank, bool Level>
+struct HostGpioWriteReg1
+{
+    HostGpioWriteReg<Bank, Level> val;
+};
+
+struct HostGpioInReg
+{
+    operator uint32_t() const volatile { return HostGpio::readBank(0); }
+};
+
+struct HostGpioIn1Reg
+{
+    struct Data
+    {
+        operator uint32_t() const volatile { return HostGpio::readBank(1) & 0xFF; }
+    } data;
+};
+
+typedef struct
+{
+    HostGpioWriteReg<0, true> out_w1ts;
+    HostGpioWriteReg<0, false> out_w1tc;
+    HostGpioWriteReg1<1, true> out1_w1ts;
+    HostGpioWriteReg1<1, false> out1_w1tc;
+    HostGpioInReg in;
+    HostGpioIn1Reg in1;
+} gpio_dev_t;
+
+extern volatile gpio_dev_t GPIO;
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+
+// Host stand-in for midilab/uClock 2.x on the virtual clock.
+// In internal mode the PPQN ticks are scheduled at the tempo's period;
+// in external mode each clockMe() is a 24 PPQN pulse that releases the
+// PPQN ticks in between, spread over the last measured pulse interval.
+// Callbacks run from HostClock events, as they run from uClock's task
+// on the device.
+
+#define MIN_BPM 1
+#define MAX_BPM 400
+
+class uClockClass
+{
+public:
+    enum ClockMode
+    {
+        INTERNAL_CLOCK = 0,
+        EXTERNAL_CLOCK
+    };
+
+    enum PPQNResolution
+    {
+        PPQN_4 = 4,
+        PPQN_8 = 8,
+        PPQN_12 = 12,
+        PPQN_24 = 24,
+        PPQN_48 = 48,
+        PPQN_96 = 96,
+        PPQN_384 = 384,
+        PPQN_480 = 480,
+        PPQN_960 = 960
+    };
+
+    using Callback = void (*)(uint32_t tick);
+
+    void init();
+    void setMode(ClockMode mode);
+    ClockMode getMode() const { return mode; }
+    void setPPQN(PPQNResolution resolution);
+    void setTempo(float bpm);
+    float getTempo();
+
+    void start();
+    void stop();
+    void pause(); // Toggles pause/resume
+    void clockMe();
+
+    void setOnPPQN(Callback callback) { onPPQN = callback; }
+    void setOnSync24(Callback callback) { onSync24 = callback; }
+    void setOnStep(Callback callback) { onStep = callback; }
+
+    uint32_t bpmToMicroSeconds(float bpm);
+
+    // Host only: ticks generated since start()
+    uint32_t getTick() const { return tick; }
+    bool isRunning() const { return state == RUNNING; }
+
+private:
+    enum RunState
+    {
+        STOPPED,
+        RUNNING,
+        PAUSED
+    };
+
+    ClockMode mode = INTERNAL_CLOCK;
+    RunState state = STOPPED;
+    uint16_t ppqn = PPQN_96;
+    float tempo = 120.0f;
+
+    Callback onPPQN = nullptr;
+    Callback onSync24 = nullptr;
+    Callback onStep = nullptr;
+
+    uint32_t tick = 0;
+    double nextTickUs = 0;
+    uint32_t pendingEvent = 0;
+
+    uint64_t lastPulseUs = 0;
+    uint32_t pulseIntervalUs = 0;
+    uint32_t releasedTicks = 0;   // External mode: ticks allowed so far
+
+    double tickPeriodUs() const;
+    void emitTick();
+    void scheduleNext();
+    void cancelPending();
+};
+
+extern uClockClass uClock;
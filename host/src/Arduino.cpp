@@ -0,0 +1,363 @@
+#include <Arduino.h>
+#include <soc/gpio_struct.h>
+#include <hal/ledc_ll.h>
+#include "HostGpio.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+volatile gpio_dev_t GPIO;
+ledc_dev_t LEDC;
+
+namespace
+{
+    bool outputs[HostGpio::PIN_COUNT] = {};
+    bool inputs[HostGpio::PIN_COUNT] = {};
+    uint16_t analog[HostGpio::PIN_COUNT] = {};
+    uint8_t modes[HostGpio::PIN_COUNT] = {};
+
+    struct LedcChannel
+    {
+        double frequency;
+        uint8_t resolutionBits;
+        uint32_t duty;
+    };
+    LedcChannel ledc[HostGpio::LEDC_CHANNELS] = {};
+
+    HostGpio::PinListener pinListener;
+    HostGpio::PinListener writeListener;
+    HostGpio::LedcListener ledcListener;
+
+    uint64_t randomState = 0x853C49E6748FEA9BULL;
+}
+
+// Time
+
+uint32_t millis()
+{
+    return uint32_t(HostClock::nowUs() / 1000);
+}
+
+uint32_t micros()
+{
+    return uint32_t(HostClock::nowUs());
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    if (HostClock::isDispatching())
+    {
+        HostClock::skipUs(us);
+    }
+    else
+    {
+        HostClock::advanceUs(us);
+    }
+}
+
+void delay(uint32_t ms)
+{
+    delayMicroseconds(ms * 1000);
+}
+
+void yield()
+{
+}
+
+// Pins
+
+bool HostGpio::level(uint8_t pin)
+{
+    if (pin >= PIN_COUNT)
+        return false;
+    return modes[pin] == OUTPUT ? outputs[pin] : inputs[pin];
+}
+
+void HostGpio::setInput(uint8_t pin, bool level)
+{
+    if (pin < PIN_COUNT)
+    {
+        inputs[pin] = level;
+    }
+}
+
+void HostGpio::setAnalog(uint8_t pin, uint16_t value)
+{
+    if (pin < PIN_COUNT)
+    {
+        analog[pin] = value;
+    }
+}
+
+uint32_t HostGpio::ledcDuty(uint8_t channel)
+{
+    return channel < LEDC_CHANNELS ? ledc[channel].duty : 0;
+}
+
+double HostGpio::ledcFrequency(uint8_t channel)
+{
+    return channel < LEDC_CHANNELS ? ledc[channel].frequency : 0.0;
+}
+
+void HostGpio::onPinChange(PinListener listener)
+{
+    pinListener = std::move(listener);
+}
+
+void HostGpio::onPinWrite(PinListener listener)
+{
+    writeListener = std::move(listener);
+}
+
+void HostGpio::onLedcChange(LedcListener listener)
+{
+    ledcListener = std::move(listener);
+}
+
+void HostGpio::reset()
+{
+    memset(outputs, 0, sizeof(outputs));
+    memset(inputs, 0, sizeof(inputs));
+    memset(analog, 0, sizeof(analog));
+    memset(modes, 0, sizeof(modes));
+    memset(ledc, 0, sizeof(ledc));
+    pinListener = nullptr;
+    writeListener = nullptr;
+    ledcListener = nullptr;
+}
+
+void HostGpio::write(uint8_t pin, bool level)
+{
+    if (pin >= PIN_COUNT)
+        return;
+    if (writeListener)
+    {
+        writeListener(pin, level, HostClock::nowUs());
+    }
+    if (outputs[pin] == level)
+        return;
+    outputs[pin] = level;
+    if (pinListener)
+    {
+        pinListener(pin, level, HostClock::nowUs());
+    }
+}
+
+void HostGpio::writeMask(uint8_t bank, uint32_t mask, bool level)
+{
+    for (uint8_t bit = 0; bit < 32; bit++)
+    {
+        if (mask & (1UL << bit))
+        {
+            write(bank * 32 + bit, level);
+        }
+    }
+}
+
+uint32_t HostGpio::readBank(uint8_t bank)
+{
+    uint32_t levels = 0;
+    for (uint8_t bit = 0; bit < 32 && bank * 32 + bit < PIN_COUNT; bit++)
+    {
+        if (level(bank * 32 + bit))
+        {
+            levels |= 1UL << bit;
+        }
+    }
+    return levels;
+}
+
+uint16_t HostGpio::readAnalog(uint8_t pin)
+{
+    return pin < PIN_COUNT ? analog[pin] : 0;
+}
+
+void HostGpio::setLedc(uint8_t channel, double frequency, uint32_t duty)
+{
+    if (channel >= LEDC_CHANNELS)
+        return;
+    if (ledc[channel].frequency == frequency && ledc[channel].duty == duty)
+        return;
+    ledc[channel].frequency = frequency;
+    ledc[channel].duty = duty;
+    if (ledcListener)
+    {
+        ledcListener(channel, frequency, duty, HostClock::nowUs());
+    }
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin >= HostGpio::PIN_COUNT)
+        return;
+    modes[pin] = mode;
+    if (mode == INPUT_PULLUP)
+    {
+        inputs[pin] = true;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    HostGpio::write(pin, value != LOW);
+}
+
+int digitalRead(uint8_t pin)
+{
+    return HostGpio::level(pin) ? HIGH : LOW;
+}
+
+uint16_t analogRead(uint8_t pin)
+{
+    return HostGpio::readAnalog(pin);
+}
+
+// Nothing raises pin interrupts on the host
+void attachInterrupt(uint8_t, void (*)(), int) {}
+void attachInterruptArg(uint8_t, void (*)(void *), void *, int) {}
+void detachInterrupt(uint8_t) {}
+
+// LEDC
+
+double ledcSetup(uint8_t channel, double frequency, uint8_t resolutionBits)
+{
+    if (channel < HostGpio::LEDC_CHANNELS)
+    {
+        ledc[channel].resolutionBits = resolutionBits;
+        HostGpio::setLedc(channel, frequency, ledc[channel].duty);
+    }
+    return frequency;
+}
+
+double ledcChangeFrequency(uint8_t channel, double frequency, uint8_t resolutionBits)
+{
+    return ledcSetup(channel, frequency, resolutionBits);
+}
+
+void ledcAttachPin(uint8_t, uint8_t) {}
+void ledcDetachPin(uint8_t) {}
+
+void ledcWrite(uint8_t channel, uint32_t duty)
+{
+    if (channel < HostGpio::LEDC_CHANNELS)
+    {
+        HostGpio::setLedc(channel, ledc[channel].frequency, duty);
+    }
+}
+
+// Randomness: a fixed-seed PCG so simulated runs repeat exactly
+
+uint32_t esp_random()
+{
+    uint64_t old = randomState;
+    randomState = old * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint32_t xorshifted = uint32_t(((old >> 18) ^ old) >> 27);
+    uint32_t rot = uint32_t(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+void randomSeed(unsigned long seed)
+{
+    randomState = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+}
+
+long random(long max)
+{
+    return max > 0 ? long(esp_random() % uint32_t(max)) : 0;
+}
+
+long random(long min, long max)
+{
+    return max > min ? min + random(max - min) : min;
+}
+
+void EspClass::restart()
+{
+    Serial.println("ESP.restart() on host");
+    exit(0);
+}
+
+// Serial
+
+size_t HardwareSerial::write(const char *text)
+{
+    if (muted)
+        return 0;
+    return fputs(text, stdout) >= 0 ? strlen(text) : 0;
+}
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
+
+size_t HardwareSerial::print(char c)
+{
+    char text[2] = {c, 0};
+    return write(text);
+}
+
+size_t HardwareSerial::printNumber(unsigned long long value, int base, bool negative)
+{
+    if (base < 2 || base > 16)
+    {
+        base = DEC;
+    }
+    char text[68];
+    char *p = text + sizeof(text) - 1;
+    *p = 0;
+    do
+    {
+        *--p = "0123456789ABCDEF"[value % base];
+        value /= base;
+    } while (value);
+    if (negative)
+    {
+        *--p = '-';
+    }
+    return write(p);
+}
+
+size_t HardwareSerial::print(long value, int base)
+{
+    // Like the Arduino core, only base 10 prints a sign
+    if (base == DEC && value < 0)
+        return printNumber(0ULL - (unsigned long long)value, DEC, true);
+    return printNumber((unsigned long)value, base, false);
+}
+
+size_t HardwareSerial::print(unsigned long value, int base)
+{
+    return printNumber(value, base, false);
+}
+
+size_t HardwareSerial::print(long long value, int base)
+{
+    if (base == DEC && value < 0)
+        return printNumber(0ULL - (unsigned long long)value, DEC, true);
+    return printNumber((unsigned long long)value, base, false);
+}
+
+size_t HardwareSerial::print(unsigned long long value, int base)
+{
+    return printNumber(value, base, false);
+}
+
+size_t HardwareSerial::print(double value, int digits)
+{
+    char text[64];
+    snprintf(text, sizeof(text), "%.*f", digits, value);
+    return write(text);
+}
+
+size_t HardwareSerial::printf(const char *format, ...)
+{
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (length < 0)
+        return 0;
+    write(text);
+    return size_t(length);
+}
@@ -0,0 +1,183 @@
+#include "ChanceSync.h"
+#include <Arduino.h>
+#include <cstring>
+#include <vector>
+#include <esp_now.h>
+#include "HostClock.h"
+#include "StrikeRecorder.h"
+
+namespace
+{
+    // The simulated leader the frames are injected from; the engine drops
+    // frames carrying its own ID
+    const uint8_t LEADER_ID[ESP_NOW_ETH_ALEN] = {0x02, 0x00, 0x00, 0x00, 0x4C, 0x44};
+
+    // Time for the frames sent around a start or stop to land
+    const uint32_t SETTLE_US = 5000;
+
+    typedef std::vector<uint8_t> Frame;
+
+    // xorshift32 for the session layouts, separate from esp_random()
+    uint32_t layoutState = 1;
+
+    uint32_t nextLayout(uint32_t limit)
+    {
+        layoutState ^= layoutState << 13;
+        layoutState ^= layoutState >> 17;
+        layoutState ^= layoutState << 5;
+        return layoutState % limit;
+    }
+
+    // New bar lengths, every step on and a chance per step, some of them
+    // certain or never. Polymeter, so every step is a quarter note.
+    void configureLeader(MetronomeState &state)
+    {
+        state.setRhythmMode(POLYMETER);
+        for (uint8_t ch = 0; ch < MetronomeState::CHANNEL_COUNT; ch++)
+        {
+            MetronomeChannel &channel = state.getChannel(ch);
+            if (!channel.isEnabled())
+            {
+                channel.toggleEnabled();
+            }
+            channel.setBarLength(uint8_t(2 + nextLayout(MAX_BEATS - 1)));
+            channel.setPattern(channel.getMaxPattern());
+            for (uint8_t step = 1; step < MAX_BEATS; step++)
+            {
+                uint32_t pick = nextLayout(12);
+                channel.setStepChance(step, pick == 0 ? 0 : pick == 1 ? 100 : uint8_t(1 + nextLayout(99)));
+            }
+        }
+    }
+
+    // Starts and stops the engine as leader; returns the frames a
+    // follower needs to play the session
+    std::vector<Frame> recordLeader()
+    {
+        SolenoidEngine &engine = SolenoidEngine::get();
+        std::vector<Frame> frames;
+        HostEspNow::setTap([&](const uint8_t *, const uint8_t *data, int len, uint64_t)
+        {
+            if (len != int(sizeof(SyncMessage)))
+                return;
+            MessageType type = reinterpret_cast<const SyncMessage *>(data)->type;
+            if (type == MSG_PATTERN || type == MSG_GROOVE || type == MSG_CHANCE || type == MSG_CONTROL)
+                frames.push_back(Frame(data, data + len));
+        });
+
+        // What the device loop does on a change, then a press of START
+        engine.wirelessSync.update(engine.state);
+        engine.timing.requestTransport(TRANSPORT_START_PAUSE, micros());
+        engine.timing.update();
+        HostClock::advanceUs(SETTLE_US);
+        engine.timing.requestTransport(TRANSPORT_STOP, micros());
+        engine.timing.update();
+        HostClock::advanceUs(SETTLE_US);
+
+        HostEspNow::setTap(nullptr);
+        return frames;
+    }
+
+    // Hands the frames to the engine's WirelessSync as a follower of
+    // LEADER_ID, applying them to `follower`
+    void replayToFollower(std::vector<Frame> frames, MetronomeState &follower)
+    {
+        WirelessSync &sync = SolenoidEngine::get().wirelessSync;
+        sync.setAsLeader(false);
+        sync.update(follower);
+        for (Frame &frame : frames)
+        {
+            memcpy(reinterpret_cast<SyncMessage *>(frame.data())->deviceID, LEADER_ID, ESP_NOW_ETH_ALEN);
+            HostEspNow::inject(LEADER_ID, frame.data(), int(frame.size()));
+        }
+        HostClock::advanceUs(SETTLE_US);
+
+        // Timing compiles received grooves on the device
+        follower.compileGroove();
+        sync.setAsLeader(true);
+    }
+
+    // Compares one session; returns true if the follower agrees
+    bool compareSession(uint16_t session, const MetronomeState &leader, const MetronomeState &follower,
+                        const ChanceSyncOptions &options)
+    {
+        uint32_t rolls = 0;
+        uint32_t played = 0;
+        uint32_t rollMismatches = 0;
+        uint32_t beats = 0;
+        uint32_t beatMismatches = 0;
+        for (uint8_t ch = 0; ch < MetronomeState::CHANNEL_COUNT; ch++)
+        {
+            const MetronomeChannel &ours = leader.getChannel(ch);
+            const MetronomeChannel &theirs = follower.getChannel(ch);
+            for (uint32_t bar = 0; bar < options.bars; bar++)
+            {
+                for (uint8_t step = 1; step < ours.getBarLength(); step++)
+                {
+                    bool hit = MetronomeChannel::rollChance(leader.getSessionSeed(), bar, ch, step,
+                                                            ours.getStepChance(step));
+                    bool followerHit = MetronomeChannel::rollChance(follower.getSessionSeed(), bar, ch, step,
+                                                                    theirs.getStepChance(step));
+                    rolls++;
+                    played += hit;
+                    rollMismatches += hit != followerHit;
+                    if (options.dump)
+                    {
+                        printf("%u,%u,%u,%u,%u,%u\n", session, ch, bar, step, hit, followerHit);
+                    }
+                }
+            }
+
+            int64_t ticks = int64_t(ours.getBarLength()) * 96 * options.bars;
+            for (int64_t tick = 0; tick < ticks; tick++)
+            {
+                BeatState beat = ours.getBeatStateBetween(tick - 1, tick, leader);
+                BeatState followerBeat = theirs.getBeatStateBetween(tick - 1, tick, follower);
+                beats += beat != SILENT;
+                beatMismatches += beat != followerBeat;
+            }
+        }
+
+        bool seeded = leader.getSessionSeed() == follower.getSessionSeed();
+        bool passed = seeded && !rollMismatches && !beatMismatches;
+        printf("%s session %u: seed %08x, lengths %u/%u, %u of %u chance steps played, "
+               "%u rolls and %u of %u beats differ\n",
+               passed ? "ok  " : "FAIL", session, leader.getSessionSeed(), leader.getChannel(0).getBarLength(),
+               leader.getChannel(1).getBarLength(), played, rolls, rollMismatches, beatMismatches, beats);
+        if (!seeded)
+        {
+            printf("  follower seed %08x\n", follower.getSessionSeed());
+        }
+        return passed;
+    }
+}
+
+int runChanceSync(const ChanceSyncOptions &options)
+{
+    SolenoidEngine &engine = SolenoidEngine::get();
+    engine.wirelessSync.init();
+    engine.wirelessSync.setAsLeader(true);
+
+    if (options.dump)
+    {
+        printf("session,channel,bar,step,leader,follower\n");
+    }
+
+    // Starts out of step with the leader, so every session's seed and
+    // chances have to come over the air
+    static MetronomeState follower;
+    follower.setSessionSeed(0);
+
+    layoutState = 1;
+    uint16_t failed = 0;
+    for (uint16_t session = 1; session <= options.sessions; session++)
+    {
+        configureLeader(engine.state);
+        std::vector<Frame> frames = recordLeader();
+        replayToFollower(frames, follower);
+        if (!compareSession(session, engine.state, follower, options))
+            failed++;
+    }
+    printf("Chance sync: %u sessions of %u bars, %u failed\n", options.sessions, options.bars, failed);
+    return failed ? 1 : 0;
+}
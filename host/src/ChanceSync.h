@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+
+// Step chance agreement check between a sync leader and a follower.
+// Each session plays the engine as leader with new bar lengths and step
+// chances and records the PATTERN, GROOVE, CHANCE and CONTROL frames it
+// sends through the loopback ESP-NOW, the START with its session seed
+// among them. The frames are then injected from a simulated peer into
+// the same WirelessSync, switched to follower, which applies them to a
+// second MetronomeState. Over many bars, every chance roll
+// (MetronomeChannel::rollChance) and every tick's beat
+// (getBeatStateBetween) must come out the same on both states.
+
+struct ChanceSyncOptions
+{
+    uint16_t sessions = 8;      // Starts, each with its own seed and chances
+    uint16_t bars = 256;        // Bars of each channel compared per session
+    bool dump = false;          // Print every chance roll as CSV
+};
+
+// Runs every session; returns the process exit code (0 = the follower
+// played every step the leader did, 1 = not)
+int runChanceSync(const ChanceSyncOptions &options);
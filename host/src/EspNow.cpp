@@ -0,0 +1,161 @@
+#include <esp_now.h>
+#include <WiFi.h>
+#include <cstring>
+#include <vector>
+#include "HostClock.h"
+
+WiFiClass WiFi;
+
+namespace
+{
+    bool initialized = false;
+    esp_now_recv_cb_t receive = nullptr;
+    uint32_t latencyUs = 300;
+    uint8_t lossPercent = 0;
+    uint32_t lossState = 1;
+    HostEspNow::Tap tap;
+    uint32_t sent = 0;
+    uint32_t dropped = 0;
+
+    // xorshift32: independent of random() so loss does not disturb the engine
+    bool lose()
+    {
+        if (!lossPercent)
+            return false;
+        lossState ^= lossState << 13;
+        lossState ^= lossState >> 17;
+        lossState ^= lossState << 5;
+        return lossState % 100 < lossPercent;
+    }
+
+    void deliver(const uint8_t *mac, const uint8_t *data, int len, bool toTap)
+    {
+        std::vector<uint8_t> frame(data, data + len);
+        std::vector<uint8_t> from(mac, mac + ESP_NOW_ETH_ALEN);
+        HostClock::schedule(HostClock::nowUs() + latencyUs, [frame, from, toTap]()
+        {
+            if (toTap && tap)
+            {
+                tap(from.data(), frame.data(), int(frame.size()), HostClock::nowUs());
+            }
+            if (initialized && receive)
+            {
+                receive(from.data(), frame.data(), int(frame.size()));
+            }
+        });
+    }
+}
+
+esp_err_t esp_now_init()
+{
+    initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_deinit()
+{
+    initialized = false;
+    receive = nullptr;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t callback)
+{
+    if (!initialized)
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    receive = callback;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer)
+{
+    if (!initialized)
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    return peer ? ESP_OK : ESP_ERR_ESPNOW_ARG;
+}
+
+esp_err_t esp_now_send(const uint8_t *, const uint8_t *data, size_t len)
+{
+    if (!initialized)
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    if (!data || len == 0 || len > ESP_NOW_MAX_DATA_LEN)
+        return ESP_ERR_ESPNOW_ARG;
+
+    sent++;
+    if (lose())
+    {
+        dropped++;
+        return ESP_OK; // Lost in the air; the sender never knows
+    }
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    WiFi.macAddress(mac);
+    deliver(mac, data, int(len), true);
+    return ESP_OK;
+}
+
+void HostEspNow::setLatencyUs(uint32_t us)
+{
+    latencyUs = us;
+}
+
+void HostEspNow::setLossPercent(uint8_t percent, uint32_t seed)
+{
+    lossPercent = percent > 100 ? 100 : percent;
+    lossState = seed ? seed : 1;
+}
+
+void HostEspNow::setTap(Tap value)
+{
+    tap = std::move(value);
+}
+
+void HostEspNow::inject(const uint8_t *mac, const uint8_t *data, int len)
+{
+    if (lose())
+    {
+        dropped++;
+        return;
+    }
+    deliver(mac, data, len, false);
+}
+
+uint32_t HostEspNow::sentFrames()
+{
+    return sent;
+}
+
+uint32_t HostEspNow::droppedFrames()
+{
+    return dropped;
+}
+
+void HostEspNow::reset()
+{
+    initialized = false;
+    receive = nullptr;
+    latencyUs = 300;
+    lossPercent = 0;
+    lossState = 1;
+    tap = nullptr;
+    sent = 0;
+    dropped = 0;
+}
+
+uint8_t *WiFiClass::macAddress(uint8_t *out)
+{
+    memcpy(out, mac, sizeof(mac));
+    return out;
+}
+
+String WiFiClass::macAddress()
+{
+    char text[18];
+    snprintf(text, sizeof(text), "%02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return String(text);
+}
+
+void WiFiClass::setMacAddress(const uint8_t *value)
+{
+    memcpy(mac, value, sizeof(mac));
+}
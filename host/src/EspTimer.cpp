@@ -0,0 +1,116 @@
+#include <esp_timer.h>
+#include <Ticker.h>
+#include "HostClock.h"
+
+struct esp_timer
+{
+    esp_timer_cb_t callback;
+    void *arg;
+    uint32_t event;
+    uint64_t periodUs;
+};
+
+static void startTimer(esp_timer_handle_t timer, uint64_t atUs)
+{
+    timer->event = HostClock::schedule(atUs, [timer, atUs]()
+    {
+        timer->event = 0;
+        if (timer->periodUs)
+        {
+            startTimer(timer, atUs + timer->periodUs);
+        }
+        timer->callback(timer->arg);
+    });
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+    if (!args || !args->callback || !handle)
+        return ESP_ERR_INVALID_ARG;
+    *handle = new esp_timer{args->callback, args->arg, 0, 0};
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs)
+{
+    if (!timer)
+        return ESP_ERR_INVALID_ARG;
+    if (timer->event)
+        return ESP_ERR_INVALID_STATE;
+    timer->periodUs = 0;
+    startTimer(timer, HostClock::nowUs() + timeoutUs);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t periodUs)
+{
+    if (!timer || !periodUs)
+        return ESP_ERR_INVALID_ARG;
+    if (timer->event)
+        return ESP_ERR_INVALID_STATE;
+    timer->periodUs = periodUs;
+    startTimer(timer, HostClock::nowUs() + periodUs);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer)
+        return ESP_ERR_INVALID_ARG;
+    if (!timer->event)
+        return ESP_ERR_INVALID_STATE;
+    HostClock::cancel(timer->event);
+    timer->event = 0;
+    timer->periodUs = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (!timer)
+        return ESP_ERR_INVALID_ARG;
+    if (timer->event)
+        return ESP_ERR_INVALID_STATE;
+    delete timer;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer && timer->event;
+}
+
+int64_t esp_timer_get_time()
+{
+    return int64_t(HostClock::nowUs());
+}
+
+void Ticker::arm(uint32_t us, bool repeat, callback_t function)
+{
+    detach();
+    callback = function;
+    periodUs = repeat ? us : 0;
+    event = HostClock::schedule(HostClock::nowUs() + us, [this]() { fire(); });
+}
+
+void Ticker::fire()
+{
+    event = 0;
+    if (periodUs)
+    {
+        event = HostClock::schedule(HostClock::nowUs() + periodUs, [this]() { fire(); });
+    }
+    if (callback)
+    {
+        callback();
+    }
+}
+
+void Ticker::detach()
+{
+    if (event)
+    {
+        HostClock::cancel(event);
+        event = 0;
+    }
+}
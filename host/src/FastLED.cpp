@@ -0,0 +1,86 @@
+#include <FastLED.h>
+#include <driver/rmt.h>
+
+CFastLED FastLED;
+
+namespace
+{
+    struct RmtChannel
+    {
+        bool installed;
+        uint8_t clkDiv;
+        uint64_t doneUs;
+        uint32_t frames;
+    };
+    RmtChannel rmt[RMT_CHANNEL_MAX] = {};
+}
+
+esp_err_t rmt_config(const rmt_config_t *config)
+{
+    if (!config || config->channel >= RMT_CHANNEL_MAX || !config->clk_div)
+        return ESP_FAIL;
+    rmt[config->channel].clkDiv = config->clk_div;
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t, int)
+{
+    if (channel >= RMT_CHANNEL_MAX || rmt[channel].installed)
+        return ESP_ERR_INVALID_STATE;
+    rmt[channel].installed = true;
+    rmt[channel].doneUs = 0;
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel)
+{
+    if (channel >= RMT_CHANNEL_MAX || !rmt[channel].installed)
+        return ESP_ERR_INVALID_STATE;
+    rmt[channel].installed = false;
+    return ESP_OK;
+}
+
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t *items, int count, bool waitDone)
+{
+    if (channel >= RMT_CHANNEL_MAX || !rmt[channel].installed || !items)
+        return ESP_ERR_INVALID_STATE;
+
+    // The driver blocks a write until the previous one has finished
+    rmt_wait_tx_done(channel, portMAX_DELAY);
+
+    uint64_t ticks = 0;
+    for (int i = 0; i < count; i++)
+    {
+        ticks += items[i].duration0 + items[i].duration1;
+    }
+    uint64_t streamUs = ticks * rmt[channel].clkDiv / 80;
+    rmt[channel].doneUs = HostClock::nowUs() + streamUs;
+    rmt[channel].frames++;
+
+    if (waitDone)
+    {
+        rmt_wait_tx_done(channel, portMAX_DELAY);
+    }
+    return ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, uint32_t waitTicks)
+{
+    if (channel >= RMT_CHANNEL_MAX || !rmt[channel].installed)
+        return ESP_ERR_INVALID_STATE;
+
+    uint64_t now = HostClock::nowUs();
+    if (now >= rmt[channel].doneUs)
+        return ESP_OK;
+    if (waitTicks == 0)
+        return ESP_ERR_TIMEOUT;
+
+    // Blocking: the caller's time passes while the frame finishes
+    delayMicroseconds(uint32_t(rmt[channel].doneUs - now));
+    return ESP_OK;
+}
+
+uint32_t host_rmt_frames(rmt_channel_t channel)
+{
+    return channel < RMT_CHANNEL_MAX ? rmt[channel].frames : 0;
+}
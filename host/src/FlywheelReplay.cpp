@@ -0,0 +1,239 @@
+#include "FlywheelReplay.h"
+#include <Arduino.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <esp_now.h>
+#include "HostClock.h"
+#include "StrikeRecorder.h"
+#include "../../led_receiver/FlywheelClock.h"
+
+namespace
+{
+    // The leader sends every SYNC24 pulse up to 120 BPM, every other one
+    // up to 240 and every fourth above (WirelessSync::onSync24)
+    const uint16_t TEMPO_SET[] = {60, 120, 180, 300};
+
+    // The receiver's loop polls the flywheel about this often
+    const uint32_t POLL_US = 100;
+
+    // Output ticks left out of the checks while the filter settles
+    const uint32_t SETTLE_TICKS = FlywheelClock::TICKS_PER_BEAT * 2;
+
+    // Largest share of a tick an output interval may be off the leader's
+    // tick, or an output tick off the leader's tick plus the mean delay.
+    // Poll quantization alone accounts for POLL_US.
+    const double SPACING_LIMIT = 0.05;
+    const double PHASE_LIMIT = 0.125;
+
+    struct Frame
+    {
+        uint64_t us;        // Arrival time at the receiver
+        MessageType type;
+        uint32_t tick;      // CLOCK: leader SYNC24 tick
+        float bpm;          // BEAT: leader tempo
+    };
+
+    struct OutputTick
+    {
+        uint64_t us;
+        uint32_t tick;      // Leader tick number the flywheel gave it
+    };
+
+    // xorshift32, separate from the loss generator
+    uint32_t jitterState = 1;
+
+    uint32_t nextJitter(uint32_t limit)
+    {
+        jitterState ^= jitterState << 13;
+        jitterState ^= jitterState >> 17;
+        jitterState ^= jitterState << 5;
+        return limit ? jitterState % (limit + 1) : 0;
+    }
+
+    // Plays `bpm` as leader and returns the frames that survived the air
+    std::vector<Frame> recordLeader(uint16_t bpm, const FlywheelOptions &options, uint32_t &sent, uint32_t &lost)
+    {
+        SolenoidEngine &engine = SolenoidEngine::get();
+        static bool initialized = false;
+        if (!initialized)
+        {
+            initialized = true;
+            engine.wirelessSync.init();
+            engine.wirelessSync.setAsLeader(true);
+        }
+
+        std::vector<Frame> trace;
+        HostEspNow::setLossPercent(options.lossPercent, bpm);
+        HostEspNow::setTap([&](const uint8_t *, const uint8_t *data, int len, uint64_t us)
+        {
+            if (len != int(sizeof(SyncMessage)))
+                return;
+            SyncMessage msg;
+            memcpy(&msg, data, sizeof(msg));
+            if (msg.type == MSG_CLOCK)
+                trace.push_back({us, MSG_CLOCK, msg.data.clock.clockTick, 0.0f});
+            else if (msg.type == MSG_BEAT)
+                trace.push_back({us, MSG_BEAT, 0, msg.data.beat.bpm});
+        });
+        uint32_t sentBefore = HostEspNow::sentFrames();
+        uint32_t lostBefore = HostEspNow::droppedFrames();
+
+        MetronomeState &state = engine.state;
+        state.setBpm(bpm);
+        engine.timing.setTempo(bpm);
+        engine.timing.requestTransport(TRANSPORT_START_PAUSE, micros());
+        engine.timing.update();
+        HostClock::advanceUs(uint64_t(options.seconds) * 1000000);
+        engine.timing.requestTransport(TRANSPORT_STOP, micros());
+        engine.timing.update();
+        HostClock::advanceUs(50000);
+
+        sent = HostEspNow::sentFrames() - sentBefore;
+        lost = HostEspNow::droppedFrames() - lostBefore;
+        HostEspNow::setTap(nullptr);
+        HostEspNow::setLossPercent(0);
+        return trace;
+    }
+
+    // Feeds the trace to a flywheel as the receiver does and collects
+    // the ticks it outputs while frames are still coming in
+    std::vector<OutputTick> replay(std::vector<Frame> trace, const FlywheelOptions &options,
+                                   FlywheelClock::Stats &stats)
+    {
+        for (Frame &frame : trace)
+        {
+            frame.us += nextJitter(options.jitterUs);
+        }
+        std::stable_sort(trace.begin(), trace.end(), [](const Frame &a, const Frame &b)
+        {
+            return a.us < b.us;
+        });
+
+        FlywheelClock flywheel;
+        flywheel.start();
+        std::vector<OutputTick> output;
+        size_t next = 0;
+        for (uint64_t now = trace.front().us; next < trace.size(); now += POLL_US)
+        {
+            for (; next < trace.size() && trace[next].us <= now; next++)
+            {
+                const Frame &frame = trace[next];
+                if (frame.type == MSG_CLOCK)
+                {
+                    flywheel.onClock(frame.tick, uint32_t(frame.us));
+                }
+                else
+                {
+                    flywheel.setTempo(frame.bpm);
+                    flywheel.onBeat(uint32_t(frame.us));
+                }
+            }
+
+            uint32_t tick = flywheel.getOutputTick();
+            uint8_t due = flywheel.poll(uint32_t(now));
+            for (uint8_t i = 0; i < due; i++)
+            {
+                output.push_back({now, tick + i});
+            }
+        }
+        stats = flywheel.getStats();
+        return output;
+    }
+
+    // Checks one tempo; returns true if the output passes
+    bool runTempo(uint16_t bpm, const FlywheelOptions &options)
+    {
+        uint32_t sent = 0;
+        uint32_t lost = 0;
+        std::vector<Frame> trace = recordLeader(bpm, options, sent, lost);
+        uint32_t clockFrames = 0;
+        double periodUs = 60000000.0 / (bpm * FlywheelClock::TICKS_PER_BEAT);
+        double originUs = 0.0;
+        for (const Frame &frame : trace)
+        {
+            if (frame.type != MSG_CLOCK)
+                continue;
+            // Leader tick 0 as it would arrive without jitter (air time
+            // included, as the frames are taken where they land)
+            if (!clockFrames++)
+                originUs = double(frame.us) - frame.tick * periodUs;
+        }
+        if (clockFrames < 2)
+        {
+            printf("FAIL %u BPM: no clock frames recorded\n", bpm);
+            return false;
+        }
+
+        FlywheelClock::Stats stats;
+        std::vector<OutputTick> output = replay(trace, options, stats);
+        if (options.dump)
+        {
+            for (const OutputTick &tick : output)
+            {
+                printf("%u,%u,%llu\n", bpm, tick.tick, (unsigned long long)tick.us);
+            }
+        }
+
+        // Every output tick after the settling ones: consecutive numbers,
+        // even spacing, and on the leader's timeline
+        bool continuous = true;
+        double worstSpacingUs = 0.0;
+        double worstPhaseUs = 0.0;
+        double sum = 0.0;
+        double sumSquares = 0.0;
+        uint32_t intervals = 0;
+        double meanDelayUs = options.jitterUs / 2.0;
+        for (size_t i = SETTLE_TICKS + 1; i < output.size(); i++)
+        {
+            if (output[i].tick != output[i - 1].tick + 1)
+                continuous = false;
+            double interval = double(output[i].us - output[i - 1].us);
+            sum += interval;
+            sumSquares += interval * interval;
+            intervals++;
+            worstSpacingUs = max(worstSpacingUs, fabs(interval - periodUs));
+            double ideal = originUs + output[i].tick * periodUs + meanDelayUs;
+            worstPhaseUs = max(worstPhaseUs, fabs(double(output[i].us) - ideal));
+        }
+        if (!intervals)
+        {
+            printf("FAIL %u BPM: no output after settling\n", bpm);
+            return false;
+        }
+        double mean = sum / intervals;
+        double deviation = sqrt(max(0.0, sumSquares / intervals - mean * mean));
+
+        bool even = worstSpacingUs <= periodUs * SPACING_LIMIT + POLL_US;
+        bool inPhase = worstPhaseUs <= periodUs * PHASE_LIMIT + POLL_US;
+        bool passed = continuous && even && inPhase && !stats.resyncs && !stats.catchUpTicks;
+        printf("%s %3u BPM: %u of %u frames lost, %zu ticks out, spacing %.1f +- %.1f us "
+               "(ideal %.1f, worst %.0f), phase worst %.0f us, %u resyncs, %u catch-up ticks\n",
+               passed ? "ok  " : "FAIL", bpm, lost, sent, output.size(), mean, deviation,
+               periodUs, worstSpacingUs, worstPhaseUs, stats.resyncs, stats.catchUpTicks);
+        if (!continuous)
+        {
+            printf("  output tick numbers skip\n");
+        }
+        return passed;
+    }
+}
+
+int runFlywheelReplay(const FlywheelOptions &options)
+{
+    if (options.dump)
+    {
+        printf("bpm,tick,time_us\n");
+    }
+
+    jitterState = 1;
+    uint8_t failed = 0;
+    for (uint16_t bpm : TEMPO_SET)
+    {
+        if (!runTempo(bpm, options))
+            failed++;
+    }
+    printf("Flywheel replay: %u tempos at %u%% loss, %u us jitter, %u failed\n",
+           uint32_t(sizeof(TEMPO_SET) / sizeof(TEMPO_SET[0])), options.lossPercent, options.jitterUs, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+// Flywheel replay check for the LED receiver's clock.
+// Plays the engine as sync leader and records the CLOCK and BEAT frames
+// that reach the air through the loopback ESP-NOW, with a share of them
+// lost. The trace is replayed into the receiver's FlywheelClock with
+// jittered arrival times, polled the way the receiver's loop polls it.
+// The output ticks must come one at a time, with no gaps, no resyncs and
+// evenly spaced, however many frames were lost.
+
+struct FlywheelOptions
+{
+    uint8_t lossPercent = 20;   // Frames lost on the air
+    uint32_t jitterUs = 400;    // Arrival delay on top of the air time, 0 to this
+    uint32_t seconds = 20;      // Session length per tempo
+    bool dump = false;          // Print every output tick as CSV
+};
+
+// Runs every tempo of the set; returns the process exit code (0 = all
+// outputs continuous and even, 1 = not)
+int runFlywheelReplay(const FlywheelOptions &options);
@@ -0,0 +1,434 @@
+#include "GoldenTrace.h"
+#include <Arduino.h>
+#include <cmath>
+#include "HostClock.h"
+#include "HostGpio.h"
+#include "StrikeRecorder.h"
+
+namespace
+{
+    // Downbeat only, every step, every other step, irregular
+    const uint16_t PATTERN_SET[] = {0x0000, 0xFFFF, 0x5555, 0x9A6C};
+    const uint8_t PATTERN_COUNT = sizeof(PATTERN_SET) / sizeof(PATTERN_SET[0]);
+
+    // Start tempo and the tempo set mid-bar (0 = steady)
+    const uint16_t TEMPO_SET[][2] = {{120, 0}, {120, 180}, {200, 75}};
+    const uint8_t TEMPO_COUNT = sizeof(TEMPO_SET) / sizeof(TEMPO_SET[0]);
+
+    const float MULTIPLIER_VALUES[MULTIPLIER_COUNT] = MULTIPLIERS;
+    const char *const MULTIPLIER_LABELS[MULTIPLIER_COUNT] = MULTIPLIER_NAMES;
+
+    // Timestamp and rounding slack on every comparison
+    const double SLACK_US = 20.0;
+
+    // Report at most this many problems per failing case
+    const uint8_t MAX_REPORTED = 8;
+
+    double tickPeriodUs(uint16_t bpm)
+    {
+        return 60000000.0 / (bpm * 96.0);
+    }
+
+    // Ideal PPQN position to time, with the tempo switched where the
+    // change was applied
+    struct Timeline
+    {
+        double startUs;
+        double periodUs;
+        double changeUs = -1.0;     // < 0: steady tempo
+        double changeTick = 0.0;
+        double changedPeriodUs = 0.0;
+
+        double timeAt(double tick) const
+        {
+            if (changeUs < 0.0 || tick <= changeTick)
+                return startUs + tick * periodUs;
+            return changeUs + (tick - changeTick) * changedPeriodUs;
+        }
+    };
+
+    // Effective ticks per bar of `channel`: its own bar, or channel 1's
+    // bar when a polyrhythm spreads channel 2 over it
+    double barTicks(const GoldenCase &c, uint8_t channel)
+    {
+        uint8_t beats = channel > 0 && c.mode == POLYRHYTHM ? c.barLength[0] : c.barLength[channel];
+        return 96.0 * beats;
+    }
+
+    // PPQN ticks between two steps of `channel`
+    double stepTicks(const GoldenCase &c, uint8_t channel)
+    {
+        return barTicks(c, channel) / c.barLength[channel] / MULTIPLIER_VALUES[c.multiplierIndex];
+    }
+
+    BeatState idealState(const GoldenCase &c, uint8_t channel, uint8_t step)
+    {
+        if (step == 0)
+            return ACCENT;
+        return (c.pattern[channel] >> (step - 1)) & 1 ? WEAK : SILENT;
+    }
+
+    // Every sounding step before `endTick`, straight from the definition:
+    // step k of a channel falls k/length of the way through its bar
+    std::vector<BeatEvent> idealTrace(const GoldenCase &c, uint8_t channel, const Timeline &timeline, double endTick)
+    {
+        std::vector<BeatEvent> events;
+        double spacing = stepTicks(c, channel);
+        for (uint32_t k = 0; k * spacing < endTick; k++)
+        {
+            BeatState state = idealState(c, channel, k % c.barLength[channel]);
+            if (state != SILENT)
+            {
+                events.push_back({uint64_t(llround(timeline.timeAt(k * spacing))), channel, state});
+            }
+        }
+        return events;
+    }
+
+    // Strikes closer than a pulse merge on the solenoid and cannot be
+    // told apart; the engine is not expected to play them
+    bool isPlayable(const GoldenCase &c)
+    {
+        double fastestUs = tickPeriodUs(max(c.bpm, c.changeBpm));
+        for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++)
+        {
+            double spacing = floor(stepTicks(c, ch));
+            if (spacing < 1.0 || spacing * fastestUs < ACCENT_PULSE_MS * 1000.0 + 1000.0)
+                return false;
+        }
+        return true;
+    }
+
+    const char *stateName(BeatState state)
+    {
+        return state == ACCENT ? "ACCENT" : state == WEAK ? "WEAK" : "CUT";
+    }
+
+    void describe(const GoldenCase &c, char *text, size_t size)
+    {
+        char tempo[16];
+        if (c.changeBpm)
+            snprintf(tempo, sizeof(tempo), "%u->%u", c.bpm, c.changeBpm);
+        else
+            snprintf(tempo, sizeof(tempo), "%u", c.bpm);
+        snprintf(text, size, "%s BPM x%s %s %u%s%u patterns 0x%04X/0x%04X", tempo,
+                 MULTIPLIER_LABELS[c.multiplierIndex], c.mode == POLYRHYTHM ? "polyrhythm" : "polymeter",
+                 c.barLength[0], c.mode == POLYRHYTHM ? ":" : "+", c.barLength[1], c.pattern[0], c.pattern[1]);
+    }
+
+    class CaseRunner
+    {
+    private:
+        SolenoidEngine &engine;
+        const GoldenOptions &options;
+        StrikeRecorder recorder;
+        uint32_t reported = 0;
+        uint32_t problems = 0;
+        uint64_t originUs = 0;
+        char label[96];
+
+        void report(const char *what, uint8_t channel, uint64_t us, const char *detail)
+        {
+            problems++;
+            if (problems == 1)
+            {
+                printf("FAIL %s\n", label);
+            }
+            if (reported++ < MAX_REPORTED)
+            {
+                printf("  %-6s ch%u at %10.3f ms  %s\n", what, channel + 1, (us - originUs) / 1000.0, detail);
+            }
+        }
+
+        void compare(uint8_t channel, const std::vector<BeatEvent> &ideal, double earlyUs, double lateUs,
+                     double firstLateUs, double endUs)
+        {
+            const std::vector<BeatEvent> &played = recorder.getEvents(channel);
+            char detail[48];
+            size_t a = 0;
+            for (size_t i = 0; i < ideal.size(); i++)
+            {
+                double due = double(ideal[i].us);
+                double lateLimit = i == 0 ? max(lateUs, firstLateUs) : lateUs;
+
+                while (a < played.size() && double(played[a].us) < due - earlyUs)
+                {
+                    report("extra", channel, played[a].us, stateName(played[a].state));
+                    a++;
+                }
+
+                bool nextDue = i + 1 < ideal.size();
+                if (a < played.size() && double(played[a].us) <= due + lateLimit)
+                {
+                    // The late first downbeat may be cut short by the step after it
+                    bool cutDownbeat = i == 0 && played[a].state == SILENT;
+                    if (played[a].state != ideal[i].state && !cutDownbeat)
+                    {
+                        snprintf(detail, sizeof(detail), "%s, expected %s", stateName(played[a].state),
+                                 stateName(ideal[i].state));
+                        report("state", channel, played[a].us, detail);
+                    }
+                    a++;
+                }
+                else if (a < played.size() && (!nextDue || double(played[a].us) < double(ideal[i + 1].us) - earlyUs))
+                {
+                    snprintf(detail, sizeof(detail), "%+.3f ms", (double(played[a].us) - due) / 1000.0);
+                    report("late", channel, ideal[i].us, detail);
+                    a++;
+                }
+                else
+                {
+                    report("missed", channel, ideal[i].us, stateName(ideal[i].state));
+                }
+            }
+
+            // Strikes from the bar after the run are not checked
+            for (; a < played.size() && double(played[a].us) < endUs - earlyUs; a++)
+            {
+                report("extra", channel, played[a].us, stateName(played[a].state));
+            }
+        }
+
+    public:
+        CaseRunner(SolenoidEngine &engine, const GoldenOptions &options)
+            : engine(engine), options(options), recorder(engine.timing)
+        {
+            label[0] = '\0';
+            recorder.attach();
+        }
+
+        // Plays one case and returns the number of problems found
+        uint32_t run(const GoldenCase &c, uint32_t index)
+        {
+            MetronomeState &state = engine.state;
+            Timing &timing = engine.timing;
+            describe(c, label, sizeof(label));
+            reported = 0;
+            problems = 0;
+            recorder.clear();
+
+            state.setRhythmMode(c.mode);
+            state.setMultiplierIndex(c.multiplierIndex);
+            state.setBpm(c.bpm);
+            for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++)
+            {
+                MetronomeChannel &channel = state.getChannel(ch);
+                if (!channel.isEnabled())
+                {
+                    channel.toggleEnabled();
+                }
+                channel.setBarLength(c.barLength[ch]);
+                channel.setPattern(c.pattern[ch]);
+            }
+            timing.setTempo(c.bpm);
+
+            // Tick 0 plays as the clock starts
+            timing.requestTransport(TRANSPORT_START_PAUSE, micros());
+            timing.update();
+
+            double periodUs = tickPeriodUs(c.bpm);
+            originUs = HostClock::nowUs();
+            Timeline timeline = {double(originUs), periodUs};
+            double bar = 96.0 * c.barLength[0] / MULTIPLIER_VALUES[c.multiplierIndex];
+            double endTick = bar * options.bars;
+            double driftUs = 0.0;
+
+            if (c.changeBpm)
+            {
+                // Halfway through bar 2, as a player turning the encoder would
+                HostClock::runUntilUs(uint64_t(ceil(timeline.timeAt(bar * 1.5))));
+                state.setBpm(c.changeBpm);
+                timing.setTempo(c.changeBpm);
+
+                timeline.changeUs = double(HostClock::nowUs());
+                timeline.changeTick = (timeline.changeUs - timeline.startUs) / periodUs;
+                timeline.changedPeriodUs = tickPeriodUs(c.changeBpm);
+
+                // The tick already due keeps the old spacing and shifts
+                // every later one by up to the difference, and strikes
+                // fired ahead for the solenoid latency were timed with
+                // the old spacing too
+                double lookahead = ceil(SOLENOID_LATENCY_US / min(periodUs, timeline.changedPeriodUs));
+                driftUs = fabs(timeline.changedPeriodUs - periodUs) * (1.0 + lookahead);
+            }
+
+            // Beats sit on PPQN ticks, so up to one tick late is by design
+            double slowestUs = max(periodUs, c.changeBpm ? timeline.changedPeriodUs : 0.0);
+            double earlyUs = driftUs + SLACK_US;
+            double lateUs = slowestUs + driftUs + SLACK_US;
+
+            // Nothing looks ahead of the first downbeat, which plays late
+            // by the solenoid latency (see Timing::scheduleOutputs)
+            double firstLateUs = SOLENOID_LATENCY_US + SLACK_US;
+
+            double endUs = timeline.timeAt(endTick);
+            HostClock::runUntilUs(uint64_t(ceil(endUs + lateUs + ACCENT_PULSE_MS * 1000.0)));
+            timing.requestTransport(TRANSPORT_STOP, micros());
+            timing.update();
+
+            // Let the last pulses and any batch still scheduled run out
+            HostClock::advanceUs(50000);
+
+            for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++)
+            {
+                if (options.dump)
+                {
+                    for (const BeatEvent &event : recorder.getEvents(ch))
+                    {
+                        printf("%u,%llu,%u,%s\n", index, (unsigned long long)(event.us - originUs),
+                               ch + 1, stateName(event.state));
+                    }
+                }
+                compare(ch, idealTrace(c, ch, timeline, endTick), earlyUs, lateUs, firstLateUs, endUs);
+            }
+            if (reported > MAX_REPORTED)
+            {
+                printf("  ... %u more\n", reported - MAX_REPORTED);
+            }
+            return problems;
+        }
+    };
+
+    // Two close strikes on one channel while the other is still in the
+    // pulse group of the first: both fire on one tick with the same
+    // width, then `channel` fires again alone before that pulse ends
+    struct RestartCase
+    {
+        const char *name;
+        BeatState together;
+        uint8_t channel;
+        BeatState again;
+        uint32_t againUs;
+    };
+
+    const RestartCase RESTART_SET[] = {
+        {"group owner restarts", ACCENT, 0, ACCENT, 4000},
+        {"group owner restarts wider", WEAK, 0, ACCENT, 3000},
+        {"group member restarts", ACCENT, 1, WEAK, 4000},
+    };
+
+    uint32_t pulseUs(BeatState state)
+    {
+        return (state == ACCENT ? ACCENT_PULSE_MS : SOLENOID_PULSE_MS) * 1000UL;
+    }
+
+    // Every pin must drop where its channel's last strike ends; returns
+    // true on failure
+    bool runRestartCase(SolenoidController &solenoids, const RestartCase &c)
+    {
+        const uint8_t pins[FIXED_CHANNEL_COUNT] = {SOLENOID_PIN, SOLENOID_PIN2};
+        uint64_t fallUs[FIXED_CHANNEL_COUNT] = {};
+        HostGpio::onPinChange([&](uint8_t pin, bool level, uint64_t us)
+        {
+            for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++)
+            {
+                if (pin == pins[ch] && !level)
+                    fallUs[ch] = us;
+            }
+        });
+
+        uint64_t originUs = HostClock::nowUs();
+        SolenoidHit hits[FIXED_CHANNEL_COUNT] = {{c.together, 255}, {c.together, 255}};
+        solenoids.processBeats(hits);
+        HostClock::advanceUs(c.againUs);
+        SolenoidHit again[FIXED_CHANNEL_COUNT] = {{SILENT, 0}, {SILENT, 0}};
+        again[c.channel] = {c.again, 255};
+        solenoids.processBeats(again);
+        HostClock::advanceUs(ACCENT_PULSE_MS * 2000UL);
+        HostGpio::onPinChange(nullptr);
+
+        bool failed = false;
+        for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++)
+        {
+            uint64_t expectedUs = ch == c.channel ? c.againUs + pulseUs(c.again) : pulseUs(c.together);
+            bool low = !HostGpio::level(pins[ch]);
+            double offUs = fallUs[ch] ? double(fallUs[ch] - originUs) - double(expectedUs) : 0.0;
+            if (!low || !fallUs[ch] || fabs(offUs) > SLACK_US)
+            {
+                if (!failed)
+                    printf("FAIL %s\n", c.name);
+                failed = true;
+                if (low)
+                    printf("  ch%u fell %.0f us from %.3f ms\n", ch + 1, offUs, expectedUs / 1000.0);
+                else
+                    printf("  ch%u still HIGH\n", ch + 1);
+            }
+        }
+        return failed;
+    }
+}
+
+
+int runGoldenTrace(const GoldenOptions &options)
+{
+#if SOLENOID_DRIVE_LEDC
+    (void)options;
+    printf("The golden trace reads GPIO solenoid pulses; build with SOLENOID_DRIVE_LEDC 0\n");
+    return 2;
+#else
+    CaseRunner runner(SolenoidEngine::get(), options);
+
+    if (options.dump)
+    {
+        printf("case,time_us,channel,state\n");
+    }
+
+    uint32_t cases = 0;
+    uint32_t skipped = 0;
+    uint32_t failed = 0;
+    for (uint8_t length = 1; length <= MAX_BEATS; length++)
+    {
+        // 7 is coprime with 16, so channel 2 also takes every length once
+        uint8_t companion = (length * 7) % MAX_BEATS + 1;
+        for (uint8_t p = 0; p < PATTERN_COUNT; p++)
+        {
+            for (MetronomeMode mode : {POLYMETER, POLYRHYTHM})
+            {
+                for (uint8_t m = 0; m < MULTIPLIER_COUNT; m++)
+                {
+                    for (uint8_t t = 0; t < TEMPO_COUNT; t++)
+                    {
+                        GoldenCase c = {};
+                        c.bpm = TEMPO_SET[t][0];
+                        c.changeBpm = TEMPO_SET[t][1];
+                        c.multiplierIndex = m;
+                        c.mode = mode;
+                        c.barLength[0] = length;
+                        c.barLength[1] = companion;
+                        for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++)
+                        {
+                            // Only the bits of steps 1 .. length-1 exist
+                            uint16_t mask = (1U << (c.barLength[ch] - 1)) - 1;
+                            c.pattern[ch] = PATTERN_SET[(p + ch) % PATTERN_COUNT] & mask;
+                        }
+
+                        if (!isPlayable(c))
+                        {
+                            skipped++;
+                            continue;
+                        }
+                        if (runner.run(c, cases))
+                        {
+                            failed++;
+                        }
+                        cases++;
+                    }
+                }
+            }
+        }
+    }
+
+    // Those steps still have to leave every coil off
+    for (const RestartCase &c : RESTART_SET)
+    {
+        if (runRestartCase(SolenoidEngine::get().solenoidController, c))
+        {
+            failed++;
+        }
+        cases++;
+    }
+
+    printf("Golden trace: %u cases, %u failed, %u skipped (steps closer than a pulse)\n", cases, failed, skipped);
+    return failed ? 1 : 0;
+#endif
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include "MetronomeState.h"
+
+// Golden beat-trace check for the simulator.
+// Plays the engine through a matrix of configurations (every bar length,
+// several patterns, both rhythm modes, every multiplier, with and without
+// a tempo change mid-bar) and records each solenoid strike as
+// (landing time, channel, BeatState). Every trace is compared with the
+// beats an ideal metronome plays for the same settings, computed in
+// closed form from the tempo and bar layout, and missed, extra, late or
+// mis-accented beats are reported. Steps closer than a pulse, which the
+// matrix skips, get direct cases: every coil must still switch off where
+// its last pulse ends.
+
+struct GoldenCase
+{
+    uint16_t bpm;
+    uint16_t changeBpm;         // Tempo set halfway through bar 2; 0 = none
+    uint8_t multiplierIndex;
+    MetronomeMode mode;
+    uint8_t barLength[FIXED_CHANNEL_COUNT];
+    uint16_t pattern[FIXED_CHANNEL_COUNT];
+};
+
+struct GoldenOptions
+{
+    uint8_t bars = 3;           // Bars of channel 1 per case
+    bool dump = false;          // Print every recorded strike as CSV
+};
+
+// Runs the whole matrix; returns the process exit code (0 = all traces
+// match, 1 = mismatches, 2 = cannot run in this build)
+int runGoldenTrace(const GoldenOptions &options);
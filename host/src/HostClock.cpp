@@ -0,0 +1,95 @@
+#include "HostClock.h"
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+    // Ordered by time, then by scheduling order
+    using EventKey = std::pair<uint64_t, uint32_t>;
+
+    uint64_t now = 0;
+    uint32_t nextId = 1;
+    uint32_t dispatchDepth = 0;
+    std::map<EventKey, HostClock::Callback> events;
+    std::unordered_map<uint32_t, uint64_t> eventTimes;
+}
+
+uint64_t HostClock::nowUs()
+{
+    return now;
+}
+
+void HostClock::runUntilUs(uint64_t atUs)
+{
+    while (!events.empty() && events.begin()->first.first <= atUs)
+    {
+        auto first = events.begin();
+        uint64_t dueUs = first->first.first;
+        Callback callback = std::move(first->second);
+        eventTimes.erase(first->first.second);
+        events.erase(first);
+
+        // A callback that delayed past later events makes them late
+        if (dueUs > now)
+        {
+            now = dueUs;
+        }
+        dispatchDepth++;
+        callback();
+        dispatchDepth--;
+    }
+    if (atUs > now)
+    {
+        now = atUs;
+    }
+}
+
+void HostClock::advanceUs(uint64_t us)
+{
+    runUntilUs(now + us);
+}
+
+uint32_t HostClock::schedule(uint64_t atUs, Callback callback)
+{
+    uint32_t id = nextId++;
+    if (atUs < now)
+    {
+        atUs = now;
+    }
+    events.emplace(EventKey(atUs, id), std::move(callback));
+    eventTimes[id] = atUs;
+    return id;
+}
+
+void HostClock::cancel(uint32_t id)
+{
+    auto found = eventTimes.find(id);
+    if (found == eventTimes.end())
+        return;
+    events.erase(EventKey(found->second, id));
+    eventTimes.erase(found);
+}
+
+uint64_t HostClock::nextEventUs()
+{
+    return events.empty() ? UINT64_MAX : events.begin()->first.first;
+}
+
+bool HostClock::isDispatching()
+{
+    return dispatchDepth > 0;
+}
+
+void HostClock::skipUs(uint64_t us)
+{
+    now += us;
+}
+
+void HostClock::reset()
+{
+    events.clear();
+    eventTimes.clear();
+    now = 0;
+    nextId = 1;
+}
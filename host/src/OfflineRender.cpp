@@ -0,0 +1,235 @@
+#include "OfflineRender.h"
+#include <Arduino.h>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include "HostClock.h"
+#include "BuzzerController.h"
+#include "StrikeRecorder.h"
+
+namespace
+{
+    const double PI = 3.14159265358979323846;
+
+    // Every click is this long; its envelope has died away by then
+    const uint32_t VOICE_MS = 80;
+
+    // Mix headroom: both channels at full volume stay below clipping
+    const float CHANNEL_GAIN = 0.45f;
+
+    const uint32_t BLOCK_SAMPLES = 4096;
+
+    struct Voice
+    {
+        double frequency;
+        double decayMs;     // Tone falls to 1/e in this time
+        float noise;        // Share of the noise burst at the attack
+        float gain;
+    };
+
+    Voice voiceFor(const MetronomeChannel &channel, uint8_t index, BeatState state)
+    {
+        // The buzzer's pitches; accents an octave up, longer and brighter
+        double base = index == 0 ? SoundConfig::CH1_FREQ : SoundConfig::CH2_FREQ;
+        if (state == ACCENT)
+            return {base * 2.0, 30.0, SoundConfig::NOISE_STRONG / 255.0f,
+                    channel.getEffectiveStrongVolume() / 255.0f * CHANNEL_GAIN};
+        return {base, 18.0, SoundConfig::NOISE_WEAK / 255.0f,
+                channel.getEffectiveWeakVolume() / 255.0f * CHANNEL_GAIN};
+    }
+
+    // Adds one click starting at sample `start` to the block at `blockStart`
+    void mixVoice(const Voice &voice, uint64_t start, uint32_t seed, uint32_t sampleRate, uint64_t blockStart,
+                  float *mix, uint32_t count)
+    {
+        uint64_t length = uint64_t(VOICE_MS) * sampleRate / 1000;
+        uint64_t from = max(start, blockStart);
+        uint64_t to = min(start + length, blockStart + count);
+
+        // Same noise for a click however the blocks split it
+        uint32_t noiseState = seed * 2654435761u + 1;
+        for (uint64_t s = start; s < from; s++)
+        {
+            noiseState = noiseState * 1664525u + 1013904223u;
+        }
+
+        for (uint64_t s = from; s < to; s++)
+        {
+            double t = double(s - start) / sampleRate;
+            noiseState = noiseState * 1664525u + 1013904223u;
+            double noise = (int32_t(noiseState) / 2147483648.0) * exp(-t * 1000.0 / 2.0);
+            double tone = sin(2.0 * PI * voice.frequency * t) * exp(-t * 1000.0 / voice.decayMs);
+            mix[s - blockStart] += voice.gain * float(tone * (1.0 - voice.noise) + noise * voice.noise);
+        }
+    }
+
+    void writeLe(FILE *file, uint32_t value, uint8_t bytes)
+    {
+        for (uint8_t i = 0; i < bytes; i++)
+        {
+            fputc((value >> (8 * i)) & 0xFF, file);
+        }
+    }
+
+    void writeWavHeader(FILE *file, uint32_t sampleRate, uint32_t dataBytes)
+    {
+        fwrite("RIFF", 1, 4, file);
+        writeLe(file, 36 + dataBytes, 4);
+        fwrite("WAVEfmt ", 1, 8, file);
+        writeLe(file, 16, 4);             // PCM format chunk
+        writeLe(file, 1, 2);              // PCM
+        writeLe(file, 1, 2);              // Mono
+        writeLe(file, sampleRate, 4);
+        writeLe(file, sampleRate * 2, 4); // Byte rate
+        writeLe(file, 2, 2);              // Block align
+        writeLe(file, 16, 2);             // Bits per sample
+        fwrite("data", 1, 4, file);
+        writeLe(file, dataBytes, 4);
+    }
+
+    std::string labelPath(const char *wavPath)
+    {
+        std::string path = wavPath;
+        size_t dot = path.rfind('.');
+        if (dot != std::string::npos && path.find('/', dot) == std::string::npos)
+        {
+            path.erase(dot);
+        }
+        return path + ".txt";
+    }
+
+    // Length of one step of `channel` on the virtual clock
+    double stepUs(const MetronomeState &state, uint8_t channel)
+    {
+        const MetronomeChannel &ch = state.getChannel(channel);
+        uint8_t barBeats = channel > 0 && state.isPolyrhythm() ? state.getChannel(0).getBarLength() : ch.getBarLength();
+        double ticks = 96.0 * barBeats / ch.getBarLength() / state.getCurrentMultiplier();
+        return ticks * 60000000.0 / (state.bpm * 96.0);
+    }
+}
+
+int renderSession(const Preset &settings, const RenderOptions &options)
+{
+#if SOLENOID_DRIVE_LEDC
+    (void)settings;
+    (void)options;
+    printf("The renderer reads GPIO solenoid pulses; build with SOLENOID_DRIVE_LEDC 0\n");
+    return 2;
+#else
+    uint64_t totalSamples = uint64_t(options.seconds) * options.sampleRate;
+    if (totalSamples * 2 > 0xFFFFFFFFULL - 36)
+    {
+        printf("Too long for a WAV file: %u s at %u Hz\n", options.seconds, options.sampleRate);
+        return 2;
+    }
+
+    FILE *wav = fopen(options.wavPath, "wb");
+    if (!wav)
+    {
+        printf("Cannot write %s\n", options.wavPath);
+        return 2;
+    }
+    std::string labelsPath = labelPath(options.wavPath);
+    FILE *labels = fopen(labelsPath.c_str(), "w");
+    if (!labels)
+    {
+        fclose(wav);
+        printf("Cannot write %s\n", labelsPath.c_str());
+        return 2;
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+
+    // Play the whole session first; the strikes are all the mix needs
+    SolenoidEngine &engine = SolenoidEngine::get();
+    MetronomeState &state = engine.state;
+    PresetBank::apply(settings, state);
+    for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++)
+    {
+        state.getChannel(ch).setSwing(options.swing[ch]);
+    }
+    engine.timing.setTempo(state.bpm);
+
+    StrikeRecorder recorder(engine.timing);
+    recorder.attach();
+    engine.timing.requestTransport(TRANSPORT_START_PAUSE, micros());
+    engine.timing.update();
+    uint64_t originUs = HostClock::nowUs();
+    HostClock::runUntilUs(originUs + uint64_t(options.seconds) * 1000000);
+    engine.timing.requestTransport(TRANSPORT_STOP, micros());
+    engine.timing.update();
+    HostClock::advanceUs(50000);
+    recorder.detach();
+
+    // Both channels in time order, with their markers
+    std::vector<BeatEvent> strikes;
+    for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++)
+    {
+        double step = stepUs(state, ch);
+        uint8_t length = state.getChannel(ch).getBarLength();
+        for (const BeatEvent &strike : recorder.getEvents(ch))
+        {
+            uint64_t us = strike.us - originUs;
+            if (us >= uint64_t(options.seconds) * 1000000)
+                continue;
+            strikes.push_back(strike);
+
+            // Nearest step, counting a swing of half a step as the earlier one
+            uint32_t index = uint32_t(ceil(us / step - 0.5));
+            fprintf(labels, "%.6f\t%.6f\t%u.%u ch%u %s\n", us / 1e6, us / 1e6, index / length + 1,
+                    index % length + 1, ch + 1,
+                    strike.state == ACCENT ? "accent" : strike.state == WEAK ? "weak" : "cut");
+        }
+    }
+    std::sort(strikes.begin(), strikes.end(), [](const BeatEvent &a, const BeatEvent &b)
+    {
+        return a.us < b.us;
+    });
+    fclose(labels);
+
+    // Mix block by block; a click spans at most a few blocks
+    writeWavHeader(wav, options.sampleRate, uint32_t(totalSamples * 2));
+    uint64_t voiceSamples = uint64_t(VOICE_MS) * options.sampleRate / 1000;
+    float mix[BLOCK_SAMPLES];
+    uint8_t pcm[BLOCK_SAMPLES * 2];     // Little-endian 16-bit
+    size_t first = 0;
+    for (uint64_t blockStart = 0; blockStart < totalSamples; blockStart += BLOCK_SAMPLES)
+    {
+        uint32_t count = uint32_t(min(uint64_t(BLOCK_SAMPLES), totalSamples - blockStart));
+        memset(mix, 0, sizeof(mix));
+
+        auto startSample = [&](const BeatEvent &strike)
+        {
+            return (strike.us - originUs) * options.sampleRate / 1000000;
+        };
+        while (first < strikes.size() && startSample(strikes[first]) + voiceSamples <= blockStart)
+        {
+            first++;
+        }
+        for (size_t i = first; i < strikes.size() && startSample(strikes[i]) < blockStart + count; i++)
+        {
+            const BeatEvent &strike = strikes[i];
+            // A cut strike still struck; it sounds as a weak one
+            BeatState sound = strike.state == ACCENT ? ACCENT : WEAK;
+            Voice voice = voiceFor(state.getChannel(strike.channel), strike.channel, sound);
+            mixVoice(voice, startSample(strike), uint32_t(i), options.sampleRate, blockStart, mix, count);
+        }
+
+        for (uint32_t s = 0; s < count; s++)
+        {
+            float sample = constrain(mix[s], -1.0f, 1.0f);
+            uint16_t value = uint16_t(int16_t(lrintf(sample * 32767.0f)));
+            pcm[2 * s] = value & 0xFF;
+            pcm[2 * s + 1] = value >> 8;
+        }
+        fwrite(pcm, 2, count, wav);
+    }
+    fclose(wav);
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    printf("Rendered %u s, %zu strikes to %s (markers in %s) in %.2f s, %.0fx real time\n", options.seconds,
+           strikes.size(), options.wavPath, labelsPath.c_str(), wallSeconds,
+           wallSeconds > 0.0 ? options.seconds / wallSeconds : 0.0);
+    return 0;
+#endif
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include "PresetBank.h"
+
+// Offline render of a metronome session for the simulator.
+// Plays the settings on the virtual clock with the solenoid-only engine
+// (see StrikeRecorder.h), then mixes one click voice per strike into a
+// mono 16-bit WAV: the channel's buzzer pitch, an octave up and brighter
+// on accents, at the channel's effective strong or weak volume. The
+// strikes also go to a label file next to the WAV (Audacity label
+// format: start, end and "bar.step chN accent|weak", tab separated).
+
+struct RenderOptions
+{
+    const char *wavPath = nullptr;
+    uint32_t seconds = 16;
+    uint32_t sampleRate = 48000;
+    uint8_t swing[FIXED_CHANNEL_COUNT] = {MIN_SWING, MIN_SWING};  // Not part of a Preset
+};
+
+// Returns the process exit code
+int renderSession(const Preset &settings, const RenderOptions &options);
@@ -0,0 +1,177 @@
+#include <Preferences.h>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Namespace = std::map<std::string, std::vector<uint8_t>>;
+
+    std::map<std::string, Namespace> store;
+    uint32_t writeCount = 0;
+
+    // NVS limits keys and namespace names to 15 characters
+    bool validName(const char *name)
+    {
+        return name && *name && strlen(name) <= 15;
+    }
+}
+
+bool Preferences::begin(const char *value, bool readOnlyMode, const char *)
+{
+    if (!validName(value))
+        return false;
+    name = value;
+    readOnly = readOnlyMode;
+    if (!readOnly)
+    {
+        store[name];
+    }
+    return true;
+}
+
+void Preferences::end()
+{
+    name = nullptr;
+}
+
+bool Preferences::clear()
+{
+    if (!name || readOnly)
+        return false;
+    store[name].clear();
+    writeCount++;
+    return true;
+}
+
+bool Preferences::remove(const char *key)
+{
+    if (!name || readOnly)
+        return false;
+    if (store[name].erase(key) == 0)
+        return false;
+    writeCount++;
+    return true;
+}
+
+bool Preferences::isKey(const char *key)
+{
+    if (!name)
+        return false;
+    auto found = store.find(name);
+    return found != store.end() && found->second.count(key);
+}
+
+bool Preferences::putValue(const char *key, const void *value, size_t length)
+{
+    if (!name || readOnly || !validName(key))
+        return false;
+    const uint8_t *bytes = static_cast<const uint8_t *>(value);
+    store[name][key].assign(bytes, bytes + length);
+    writeCount++;
+    return true;
+}
+
+bool Preferences::getValue(const char *key, void *value, size_t length) const
+{
+    if (!name)
+        return false;
+    auto ns = store.find(name);
+    if (ns == store.end())
+        return false;
+    auto found = ns->second.find(key);
+    if (found == ns->second.end() || found->second.size() != length)
+        return false;
+    memcpy(value, found->second.data(), length);
+    return true;
+}
+
+size_t Preferences::putBool(const char *key, bool value)
+{
+    return putUChar(key, value ? 1 : 0);
+}
+
+size_t Preferences::putUChar(const char *key, uint8_t value)
+{
+    return putValue(key, &value, sizeof(value)) ? sizeof(value) : 0;
+}
+
+size_t Preferences::putUShort(const char *key, uint16_t value)
+{
+    return putValue(key, &value, sizeof(value)) ? sizeof(value) : 0;
+}
+
+size_t Preferences::putUInt(const char *key, uint32_t value)
+{
+    return putValue(key, &value, sizeof(value)) ? sizeof(value) : 0;
+}
+
+size_t Preferences::putULong(const char *key, uint32_t value)
+{
+    return putUInt(key, value);
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t length)
+{
+    return putValue(key, value, length) ? length : 0;
+}
+
+bool Preferences::getBool(const char *key, bool defaultValue)
+{
+    return getUChar(key, defaultValue ? 1 : 0) != 0;
+}
+
+uint8_t Preferences::getUChar(const char *key, uint8_t defaultValue)
+{
+    uint8_t value;
+    return getValue(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+uint16_t Preferences::getUShort(const char *key, uint16_t defaultValue)
+{
+    uint16_t value;
+    return getValue(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char *key, uint32_t defaultValue)
+{
+    uint32_t value;
+    return getValue(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+uint32_t Preferences::getULong(const char *key, uint32_t defaultValue)
+{
+    return getUInt(key, defaultValue);
+}
+
+size_t Preferences::getBytesLength(const char *key)
+{
+    if (!name)
+        return 0;
+    auto ns = store.find(name);
+    if (ns == store.end())
+        return 0;
+    auto found = ns->second.find(key);
+    return found == ns->second.end() ? 0 : found->second.size();
+}
+
+size_t Preferences::getBytes(const char *key, void *buffer, size_t maxLength)
+{
+    size_t length = getBytesLength(key);
+    if (!length || length > maxLength)
+        return 0;
+    memcpy(buffer, store[name][key].data(), length);
+    return length;
+}
+
+void HostNvs::wipe()
+{
+    store.clear();
+    writeCount = 0;
+}
+
+uint32_t HostNvs::writes()
+{
+    return writeCount;
+}
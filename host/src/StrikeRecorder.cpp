@@ -0,0 +1,76 @@
+#include "StrikeRecorder.h"
+#include "HostGpio.h"
+
+namespace
+{
+    const uint8_t SOLENOID_PINS[FIXED_CHANNEL_COUNT] = {SOLENOID_PIN, SOLENOID_PIN2};
+
+    // Pulses at least this long are accents (weak 5 ms, accent 7 ms)
+    const uint32_t ACCENT_WIDTH_US = (SOLENOID_PULSE_MS + ACCENT_PULSE_MS) * 500UL;
+}
+
+SolenoidEngine::SolenoidEngine()
+    : solenoidController(SOLENOID_PIN, SOLENOID_PIN2),
+      timing(state, wirelessSync, solenoidController, nullptr)
+{
+}
+
+SolenoidEngine &SolenoidEngine::get()
+{
+    static SolenoidEngine *engine = nullptr;
+    if (!engine)
+    {
+        engine = new SolenoidEngine();
+        engine->solenoidController.init();
+        engine->timing.init();
+    }
+    return *engine;
+}
+
+void StrikeRecorder::attach()
+{
+    HostGpio::onPinWrite([this](uint8_t pin, bool level, uint64_t us)
+    {
+        onPinWrite(pin, level, us);
+    });
+}
+
+void StrikeRecorder::detach()
+{
+    HostGpio::onPinWrite(nullptr);
+}
+
+void StrikeRecorder::clear()
+{
+    for (std::vector<BeatEvent> &channelEvents : events)
+    {
+        channelEvents.clear();
+    }
+}
+
+// Called before the pin changes
+void StrikeRecorder::onPinWrite(uint8_t pin, bool level, uint64_t us)
+{
+    for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++)
+    {
+        if (pin != SOLENOID_PINS[ch])
+            continue;
+
+        std::vector<BeatEvent> &channelEvents = events[ch];
+        uint64_t landUs = us + timing.getOutputLatency(LatencyOutput(LATENCY_SOLENOID1 + ch));
+        bool pulsing = HostGpio::level(pin) && !channelEvents.empty();
+        if (level)
+        {
+            if (pulsing)
+            {
+                channelEvents.back().state = SILENT;
+            }
+            channelEvents.push_back({landUs, ch, WEAK});
+        }
+        else if (pulsing && channelEvents.back().state != SILENT)
+        {
+            uint64_t widthUs = landUs - channelEvents.back().us;
+            channelEvents.back().state = widthUs >= ACCENT_WIDTH_US ? ACCENT : WEAK;
+        }
+    }
+}
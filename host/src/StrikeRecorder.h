@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "config.h"
+#include "MetronomeState.h"
+#include "SolenoidController.h"
+#include "WirelessSync.h"
+#include "Timing.h"
+
+// Solenoid strikes as the simulator sees them, for the golden trace and
+// the offline renderer.
+
+struct BeatEvent
+{
+    uint64_t us;        // When the strike lands (pin edge + solenoid latency)
+    uint8_t channel;
+    BeatState state;    // ACCENT or WEAK; SILENT if the pulse was cut short
+};
+
+// The engine without buzzer, LEDs or display: only the solenoids play,
+// so nothing else in the tick path moves their timing. Constructed on
+// first use, as its Timing takes over the uClock callbacks.
+struct SolenoidEngine
+{
+    MetronomeState state;
+    SolenoidController solenoidController;
+    WirelessSync wirelessSync;
+    Timing timing;
+
+    SolenoidEngine();
+
+    static SolenoidEngine &get();
+};
+
+// Records every strike from the solenoid pin writes. The state follows
+// from the pulse width (accent pulses are longer); a strike restarted
+// before its pulse ended is kept as SILENT. Needs the GPIO solenoid
+// drive (SOLENOID_DRIVE_LEDC 0).
+class StrikeRecorder
+{
+private:
+    const Timing &timing;
+    std::vector<BeatEvent> events[FIXED_CHANNEL_COUNT];
+
+    void onPinWrite(uint8_t pin, bool level, uint64_t us);
+
+public:
+    explicit StrikeRecorder(const Timing &timing) : timing(timing) {}
+    ~StrikeRecorder() { detach(); }
+
+    void attach();
+    void detach();
+    void clear();
+
+    const std::vector<BeatEvent> &getEvents(uint8_t channel) const { return events[channel]; }
+};
@@ -0,0 +1,106 @@
+#include <U8g2lib.h>
+
+const uint8_t u8g2_font_t0_11_tr[] = {0};
+
+// Fixed advance of the t0_11 font
+static const int GLYPH_WIDTH = 6;
+
+void U8G2_SH1106_128X64_NONAME_F_HW_I2C::drawPixel(int x, int y)
+{
+    if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT)
+        return;
+
+    // Page layout as on the SH1106: 8 rows per byte, LSB on top
+    uint8_t &cell = buffer[(y / 8) * WIDTH + x];
+    uint8_t bit = 1 << (y & 7);
+    if (drawColor == 0)
+        cell &= ~bit;
+    else if (drawColor == 1)
+        cell |= bit;
+    else
+        cell ^= bit;
+}
+
+void U8G2_SH1106_128X64_NONAME_F_HW_I2C::drawHLine(int x, int y, int w)
+{
+    for (int i = 0; i < w; i++)
+    {
+        drawPixel(x + i, y);
+    }
+}
+
+void U8G2_SH1106_128X64_NONAME_F_HW_I2C::drawVLine(int x, int y, int h)
+{
+    for (int i = 0; i < h; i++)
+    {
+        drawPixel(x, y + i);
+    }
+}
+
+void U8G2_SH1106_128X64_NONAME_F_HW_I2C::drawBox(int x, int y, int w, int h)
+{
+    for (int i = 0; i < h; i++)
+    {
+        drawHLine(x, y + i, w);
+    }
+}
+
+void U8G2_SH1106_128X64_NONAME_F_HW_I2C::drawFrame(int x, int y, int w, int h)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    drawHLine(x, y, w);
+    drawHLine(x, y + h - 1, w);
+    drawVLine(x, y + 1, h - 2);
+    drawVLine(x + w - 1, y + 1, h - 2);
+}
+
+void U8G2_SH1106_128X64_NONAME_F_HW_I2C::drawCircle(int x0, int y0, int r)
+{
+    // Midpoint circle
+    int x = r;
+    int y = 0;
+    int error = 1 - r;
+    while (x >= y)
+    {
+        drawPixel(x0 + x, y0 + y);
+        drawPixel(x0 + y, y0 + x);
+        drawPixel(x0 - y, y0 + x);
+        drawPixel(x0 - x, y0 + y);
+        drawPixel(x0 - x, y0 - y);
+        drawPixel(x0 - y, y0 - x);
+        drawPixel(x0 + y, y0 - x);
+        drawPixel(x0 + x, y0 - y);
+        y++;
+        if (error < 0)
+        {
+            error += 2 * y + 1;
+        }
+        else
+        {
+            x--;
+            error += 2 * (y - x) + 1;
+        }
+    }
+}
+
+void U8G2_SH1106_128X64_NONAME_F_HW_I2C::drawDisc(int x0, int y0, int r)
+{
+    for (int dy = -r; dy <= r; dy++)
+    {
+        for (int dx = -r; dx <= r; dx++)
+        {
+            if (dx * dx + dy * dy <= r * r)
+            {
+                drawPixel(x0 + dx, y0 + dy);
+            }
+        }
+    }
+}
+
+int U8G2_SH1106_128X64_NONAME_F_HW_I2C::drawStr(int x, int y, const char *text)
+{
+    (void)x;
+    (void)y;
+    return int(strlen(text)) * GLYPH_WIDTH;
+}
@@ -0,0 +1,444 @@
+// Metronome simulator for the native environment.
+// Wires the engine together the way src/main.cpp does (without the
+// display, encoder and buttons) and plays it on the virtual clock,
+// printing every solenoid strike with its timestamp.
+//
+//   .pio/build/native/program [--bpm N] [--seconds S] [--multiplier I]
+//                             [--polyrhythm] [--length1 N] [--length2 N]
+//                             [--pattern1 X] [--pattern2 X] [--swing1 P]
+//                             [--swing2 P] [--ramp BPM] [--ramp-bars N]
+//                             [--ramp-exp] [--chance1 P] [--chance2 P]
+//                             [--seed N] [--song STEPSxBARS[@BPM],...]
+//                             [--song-loop] [--recall STEPS[@BPM]] [--quiet]
+//                             [--render FILE.wav] [--sample-rate HZ]
+//   .pio/build/native/program --golden [--bars N] [--dump]
+//   .pio/build/native/program --flywheel [--loss P] [--jitter US] [--seconds S]
+//                             [--dump]
+//   .pio/build/native/program --chance-sync [--sessions N] [--bars N] [--dump]
+//
+// --song stores a chain of the configured session with channel 1's bar
+// length and the tempo changed per entry, e.g. --song 4x2,3x2@140,5x1,
+// in the preset bank and song storage, and plays it from there.
+// --recall stores the session with channel 1's bar length (and tempo)
+// changed in the preset bank and recalls it from there halfway through.
+// --render mixes the session into a WAV with a marker file instead (see
+// OfflineRender.h). --golden checks the beat trace of a configuration
+// matrix against the ideal one (see GoldenTrace.h) and exits non-zero on
+// mismatch. --flywheel replays the leader's clock frames, P % of them
+// lost, into the LED receiver's flywheel clock and checks that its output
+// ticks stay continuous and evenly spaced (see FlywheelReplay.h).
+// --chance-sync feeds the leader's start seed and step chances through
+// the loopback to a follower and checks that both roll every step the
+// same way (see ChanceSync.h).
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include <uClock.h>
+#include "HostClock.h"
+#include "HostGpio.h"
+#include "config.h"
+#include "MetronomeState.h"
+#include "SolenoidController.h"
+#include "BuzzerController.h"
+#include "WirelessSync.h"
+#include "Timing.h"
+#include "ConfigStore.h"
+#include "LEDController.h"
+#include "FrameClock.h"
+#include "GoldenTrace.h"
+#include "FlywheelReplay.h"
+#include "ChanceSync.h"
+#include "OfflineRender.h"
+#include "PresetBank.h"
+#include "SongChain.h"
+
+// One pass of the device loop per millisecond of virtual time
+static const uint32_t LOOP_PERIOD_US = 1000;
+
+static MetronomeState state;
+static SolenoidController solenoidController(SOLENOID_PIN, SOLENOID_PIN2);
+static BuzzerController buzzerController(BUZZER_PIN1, BUZZER_PIN2);
+static WirelessSync wirelessSync;
+static Timing timing(state, wirelessSync, solenoidController, &buzzerController);
+static LEDController ledController;
+static FrameClock frameClock;
+static ConfigStore configStore;
+
+ConfigStore *globalConfigStore = &configStore;
+static PresetBank presetBank;
+
+// Bank slot --recall stores its preset in
+static const uint8_t RECALL_SLOT = PRESET_COUNT - 1;
+
+static bool openPresetBank()
+{
+    static bool opened = false;
+    if (!opened)
+    {
+        opened = presetBank.begin();
+    }
+    return opened;
+}
+
+// Stores --song as the device would have it: a preset in the bank per
+// bar length, and a chain of those slots with the bars and tempo of each
+// entry. Returns the number of entries, 0 on a bad list.
+static uint8_t storeSong(const char *list, bool loop, const MetronomeState &live)
+{
+    if (!openPresetBank())
+        return 0;
+
+    SongChain chain;
+    chain.begin();
+    chain.clear();
+    chain.setLoop(loop);
+    uint32_t stored = 0;    // Bit per bar length with a preset saved
+    while (*list)
+    {
+        char *end;
+        long steps = strtol(list, &end, 10);
+        if (*end != 'x')
+            return 0;
+        long bars = strtol(end + 1, &end, 10);
+        long bpm = 0;
+        if (*end == '@')
+            bpm = strtol(end + 1, &end, 10);
+        if (steps < 1 || steps > MAX_BEATS || bars < 1 || bars > 255 || (*end && *end != ','))
+            return 0;
+
+        // Slot N - 1 holds the session with channel 1 at N steps
+        uint8_t slot = uint8_t(steps - 1);
+        if (!(stored & (1UL << slot)))
+        {
+            Preset preset;
+            PresetBank::capture(live, preset);
+            preset.channels[0].barLength = uint8_t(steps);
+            static MetronomeState edited;
+            PresetBank::apply(preset, edited);
+            if (!presetBank.save(slot, edited))
+                return 0;
+            stored |= 1UL << slot;
+        }
+
+        uint16_t tempo = bpm ? uint16_t(constrain(bpm, MIN_GLOBAL_BPM, MAX_GLOBAL_BPM)) : 0;
+        if (!chain.append({slot, uint8_t(bars), tempo}))
+            return 0;
+        list = *end ? end + 1 : end;
+    }
+    return chain.save() ? chain.size() : 0;
+}
+
+// Stores the live settings with --recall's changes in RECALL_SLOT
+static bool storeRecallPreset(const char *spec, const MetronomeState &live)
+{
+    char *end;
+    long steps = strtol(spec, &end, 10);
+    long bpm = live.bpm;
+    if (*end == '@')
+        bpm = strtol(end + 1, &end, 10);
+    if (steps < 1 || steps > MAX_BEATS || *end)
+        return false;
+
+    Preset preset;
+    PresetBank::capture(live, preset);
+    preset.bpm = uint16_t(constrain(bpm, MIN_GLOBAL_BPM, MAX_GLOBAL_BPM));
+    preset.channels[0].barLength = uint8_t(steps);
+    static MetronomeState edited;
+    PresetBank::apply(preset, edited);
+    return openPresetBank() && presetBank.save(RECALL_SLOT, edited);
+}
+
+
+static void usage()
+{
+    printf("usage: program [--bpm N] [--seconds S] [--multiplier I] [--polyrhythm]\n"
+           "               [--length1 N] [--length2 N] [--pattern1 X] [--pattern2 X]\n"
+           "               [--swing1 P] [--swing2 P] [--ramp BPM] [--ramp-bars N] [--ramp-exp]\n"
+           "               [--chance1 P] [--chance2 P] [--seed N]\n"
+           "               [--song STEPSxBARS[@BPM],...] [--song-loop] [--recall STEPS[@BPM]]\n"
+           "               [--quiet]\n"
+           "               [--render FILE.wav] [--sample-rate HZ]\n"
+           "       program --golden [--bars N] [--dump]\n"
+           "       program --flywheel [--loss P] [--jitter US] [--seconds S] [--dump]\n"
+           "       program --chance-sync [--sessions N] [--bars N] [--dump]\n");
+}
+
+int main(int argc, char **argv)
+{
+    uint16_t bpm = DEFAULT_BPM;
+    uint32_t seconds = 4;
+    int multiplier = 0;
+    bool polyrhythm = false;
+    bool quiet = false;
+    bool golden = false;
+    GoldenOptions goldenOptions;
+    bool flywheel = false;
+    bool secondsSet = false;
+    FlywheelOptions flywheelOptions;
+    bool chanceSync = false;
+    ChanceSyncOptions chanceOptions;
+    RenderOptions renderOptions;
+    // Channel 2 plays 3 steps unless told otherwise; 0 / -1 keep the stored setting
+    uint8_t lengths[FIXED_CHANNEL_COUNT] = {0, 3};
+    long patterns[FIXED_CHANNEL_COUNT] = {-1, -1};
+    uint8_t swings[FIXED_CHANNEL_COUNT] = {MIN_SWING, MIN_SWING};
+    uint16_t rampBpm = 0;
+    uint16_t rampBars = 4;
+    RampShape rampShape = RAMP_LINEAR;
+    uint8_t chances[FIXED_CHANNEL_COUNT] = {100, 100};
+    long seed = -1;
+    const char *songList = nullptr;
+    bool songLoop = false;
+    const char *recallSpec = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--bpm") && i + 1 < argc)
+            bpm = uint16_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+        {
+            seconds = uint32_t(atoi(argv[++i]));
+            secondsSet = true;
+        }
+        else if (!strcmp(argv[i], "--multiplier") && i + 1 < argc)
+            multiplier = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--polyrhythm"))
+            polyrhythm = true;
+        else if (!strcmp(argv[i], "--quiet"))
+            quiet = true;
+        else if (!strcmp(argv[i], "--length1") && i + 1 < argc)
+            lengths[0] = uint8_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--length2") && i + 1 < argc)
+            lengths[1] = uint8_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--pattern1") && i + 1 < argc)
+            patterns[0] = strtol(argv[++i], nullptr, 0);
+        else if (!strcmp(argv[i], "--pattern2") && i + 1 < argc)
+            patterns[1] = strtol(argv[++i], nullptr, 0);
+        else if (!strcmp(argv[i], "--swing1") && i + 1 < argc)
+            swings[0] = uint8_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--swing2") && i + 1 < argc)
+            swings[1] = uint8_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--ramp") && i + 1 < argc)
+            rampBpm = uint16_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--ramp-bars") && i + 1 < argc)
+            rampBars = uint16_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--ramp-exp"))
+            rampShape = RAMP_EXPONENTIAL;
+        else if (!strcmp(argv[i], "--chance1") && i + 1 < argc)
+            chances[0] = uint8_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--chance2") && i + 1 < argc)
+            chances[1] = uint8_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = strtol(argv[++i], nullptr, 0);
+        else if (!strcmp(argv[i], "--song") && i + 1 < argc)
+            songList = argv[++i];
+        else if (!strcmp(argv[i], "--song-loop"))
+            songLoop = true;
+        else if (!strcmp(argv[i], "--recall") && i + 1 < argc)
+            recallSpec = argv[++i];
+        else if (!strcmp(argv[i], "--render") && i + 1 < argc)
+            renderOptions.wavPath = argv[++i];
+        else if (!strcmp(argv[i], "--sample-rate") && i + 1 < argc)
+            renderOptions.sampleRate = uint32_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--golden"))
+            golden = true;
+        else if (!strcmp(argv[i], "--bars") && i + 1 < argc)
+        {
+            int bars = atoi(argv[++i]);
+            goldenOptions.bars = uint8_t(bars);
+            chanceOptions.bars = uint16_t(constrain(bars, 1, 4096));
+        }
+        else if (!strcmp(argv[i], "--dump"))
+            goldenOptions.dump = flywheelOptions.dump = chanceOptions.dump = true;
+        else if (!strcmp(argv[i], "--flywheel"))
+            flywheel = true;
+        else if (!strcmp(argv[i], "--loss") && i + 1 < argc)
+            flywheelOptions.lossPercent = uint8_t(min(atoi(argv[++i]), 90));
+        else if (!strcmp(argv[i], "--jitter") && i + 1 < argc)
+            flywheelOptions.jitterUs = uint32_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--chance-sync"))
+            chanceSync = true;
+        else if (!strcmp(argv[i], "--sessions") && i + 1 < argc)
+            chanceOptions.sessions = uint16_t(max(atoi(argv[++i]), 1));
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    goldenOptions.bars = constrain(goldenOptions.bars, 2, 64);
+    renderOptions.sampleRate = constrain(renderOptions.sampleRate, 8000, 192000);
+
+    // Engine chatter off; strikes below are printed with printf
+    Serial.mute(quiet);
+
+    if (golden)
+    {
+        Serial.mute(true);
+        return runGoldenTrace(goldenOptions);
+    }
+
+    if (flywheel)
+    {
+        Serial.mute(true);
+        if (secondsSet)
+        {
+            flywheelOptions.seconds = max(seconds, uint32_t(2));
+        }
+        return runFlywheelReplay(flywheelOptions);
+    }
+
+    if (chanceSync)
+    {
+        Serial.mute(true);
+        return runChanceSync(chanceOptions);
+    }
+
+    configStore.begin();
+    state.loadFromStorage();
+    state.setBpm(constrain(bpm, MIN_GLOBAL_BPM, MAX_GLOBAL_BPM));
+    state.setMultiplierIndex(constrain(multiplier, 0, MULTIPLIER_COUNT - 1));
+    state.setRhythmMode(polyrhythm ? POLYRHYTHM : POLYMETER);
+    if (!state.getChannel(1).isEnabled())
+    {
+        state.getChannel(1).toggleEnabled();
+    }
+    for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++)
+    {
+        MetronomeChannel &channel = state.getChannel(ch);
+        if (lengths[ch])
+        {
+            channel.setBarLength(constrain(lengths[ch], 1, MAX_BEATS));
+        }
+        if (patterns[ch] >= 0)
+        {
+            channel.setPattern(uint16_t(patterns[ch]) & channel.getMaxPattern());
+        }
+        channel.setSwing(swings[ch]);
+        for (uint8_t step = 1; step < MAX_BEATS; step++)
+        {
+            channel.setStepChance(step, chances[ch]);
+        }
+        renderOptions.swing[ch] = channel.getSwing();
+    }
+
+    if (renderOptions.wavPath)
+    {
+        Serial.mute(true);
+        Preset settings;
+        PresetBank::capture(state, settings);
+        renderOptions.seconds = seconds;
+        return renderSession(settings, renderOptions);
+    }
+
+    solenoidController.init();
+    buzzerController.init();
+    ledController.init();
+    timing.setFrameClock(&frameClock);
+    timing.setLEDController(&ledController);
+    timing.init();
+    timing.setTempo(state.bpm);
+    if (rampBpm)
+    {
+        timing.rampTempo(rampBpm, rampBars, rampShape);
+    }
+
+    if (songList)
+    {
+        uint8_t count = storeSong(songList, songLoop, state);
+        if (!count)
+        {
+            usage();
+            return 2;
+        }
+
+        // Read back from flash and resolved as the device does at boot
+        SongChain stored;
+        stored.begin();
+        static SongEntry song[SONG_MAX_ENTRIES];
+        timing.loadSong(song, stored.resolve(presetBank, song), stored.isLooping());
+    }
+
+    // The recalled preset goes through the bank like one saved on the device
+    if (recallSpec && !storeRecallPreset(recallSpec, state))
+    {
+        usage();
+        return 2;
+    }
+
+    // The session seed comes from esp_random() on start
+    if (seed >= 0)
+    {
+        randomSeed(uint32_t(seed));
+    }
+
+    uint32_t strikes[2] = {};
+    HostGpio::onPinChange([&](uint8_t pin, bool level, uint64_t us)
+    {
+        if (!level || (pin != SOLENOID_PIN && pin != SOLENOID_PIN2))
+            return;
+        uint8_t channel = pin == SOLENOID_PIN ? 0 : 1;
+        strikes[channel]++;
+        if (!quiet)
+        {
+            printf("%10.3f ms  solenoid %u\n", us / 1000.0, channel + 1);
+        }
+    });
+
+    printf("Simulating %u s at %u BPM x%s, %s\n", seconds, state.bpm,
+           state.getCurrentMultiplierName(), polyrhythm ? "polyrhythm" : "polymeter");
+
+    timing.requestTransport(TRANSPORT_START_PAUSE, micros());
+    uint64_t endUs = HostClock::nowUs() + uint64_t(seconds) * 1000000;
+    uint64_t recallUs = HostClock::nowUs() + uint64_t(seconds) * 500000;
+    bool recalled = false;
+    bool switched = false;
+    while (HostClock::nowUs() < endUs)
+    {
+        timing.update();
+        state.update();
+
+        if (recallSpec && !recalled && HostClock::nowUs() >= recallUs)
+        {
+            Preset preset;
+            recalled = presetBank.recall(RECALL_SLOT, preset);
+            timing.queuePreset(preset);
+            printf("%10.3f ms  preset %u recalled\n", HostClock::nowUs() / 1000.0, RECALL_SLOT + 1);
+        }
+        if (recalled && !switched && !timing.isPresetPending())
+        {
+            switched = true;
+            printf("%10.3f ms  preset %u playing from tick %u, %u BPM\n", HostClock::nowUs() / 1000.0,
+                   RECALL_SLOT + 1, uClock.getTick(), state.bpm);
+        }
+
+        FrameInfo frame;
+        if (frameClock.poll(micros(), frame))
+        {
+            ledController.update(state, frame);
+        }
+        buzzerController.update();
+        configStore.update(state, millis(), timing.isSongSetup());
+
+        HostClock::advanceUs(LOOP_PERIOD_US);
+    }
+
+    timing.requestTransport(TRANSPORT_STOP, micros());
+    timing.update();
+    configStore.update(state, millis(), timing.isSongSetup());
+    if (songList)
+    {
+        // Stopping puts back the setup the song replaced; none of its
+        // entries is saved
+        printf("Song stopped: channel 1 back to %u steps at %u BPM, %u settings writes\n",
+               state.getChannel(0).getBarLength(), state.bpm, configStore.getStats().sessionWrites);
+    }
+
+    printf("%u PPQN ticks, strikes %u / %u, max tick delay %u us, %u LED frames, %u BPM\n",
+           uClock.getTick(), strikes[0], strikes[1], timing.getMaxTickDelayUs(),
+           frameClock.getFrameCount(), state.bpm);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,177 @@
+#include <uClock.h>
+#include "HostClock.h"
+
+uClockClass uClock;
+
+void uClockClass::init()
+{
+    cancelPending();
+    state = STOPPED;
+    tick = 0;
+}
+
+void uClockClass::setMode(ClockMode value)
+{
+    if (value == mode)
+        return;
+    mode = value;
+    cancelPending();
+    lastPulseUs = 0;
+    pulseIntervalUs = 0;
+    releasedTicks = tick;
+    if (state == RUNNING && mode == INTERNAL_CLOCK)
+    {
+        nextTickUs = double(HostClock::nowUs());
+        scheduleNext();
+    }
+}
+
+void uClockClass::setPPQN(PPQNResolution resolution)
+{
+    ppqn = resolution;
+}
+
+void uClockClass::setTempo(float bpm)
+{
+    if (bpm < MIN_BPM || bpm > MAX_BPM)
+        return;
+    tempo = bpm;
+}
+
+float uClockClass::getTempo()
+{
+    return tempo;
+}
+
+uint32_t uClockClass::bpmToMicroSeconds(float bpm)
+{
+    return uint32_t(60000000.0f / float(ppqn) / bpm);
+}
+
+double uClockClass::tickPeriodUs() const
+{
+    return 60000000.0 / (double(tempo) * ppqn);
+}
+
+void uClockClass::start()
+{
+    cancelPending();
+    state = RUNNING;
+    tick = 0;
+    releasedTicks = 0;
+    lastPulseUs = 0;
+    if (mode == INTERNAL_CLOCK)
+    {
+        nextTickUs = double(HostClock::nowUs());
+        scheduleNext();
+    }
+}
+
+void uClockClass::stop()
+{
+    cancelPending();
+    state = STOPPED;
+}
+
+void uClockClass::pause()
+{
+    if (state == RUNNING)
+    {
+        cancelPending();
+        state = PAUSED;
+    }
+    else if (state == PAUSED)
+    {
+        state = RUNNING;
+        if (mode == INTERNAL_CLOCK)
+        {
+            nextTickUs = double(HostClock::nowUs());
+            scheduleNext();
+        }
+    }
+}
+
+void uClockClass::clockMe()
+{
+    if (mode != EXTERNAL_CLOCK || state != RUNNING)
+        return;
+
+    uint64_t now = HostClock::nowUs();
+    if (lastPulseUs)
+    {
+        pulseIntervalUs = uint32_t(now - lastPulseUs);
+        if (pulseIntervalUs)
+        {
+            tempo = 60000000.0f / (pulseIntervalUs * 24.0f);
+        }
+    }
+    lastPulseUs = now;
+
+    // Finish the previous pulse's ticks now, then spread this pulse's
+    uint16_t perPulse = ppqn >= 24 ? ppqn / 24 : 1;
+    cancelPending();
+    while (tick < releasedTicks)
+    {
+        emitTick();
+    }
+    releasedTicks += perPulse;
+    emitTick();
+    if (tick < releasedTicks && pulseIntervalUs)
+    {
+        nextTickUs = double(now) + double(pulseIntervalUs) / perPulse;
+        scheduleNext();
+    }
+}
+
+void uClockClass::emitTick()
+{
+    uint32_t current = tick++;
+    uint16_t per24 = ppqn >= 24 ? ppqn / 24 : 1;
+    uint16_t perStep = ppqn >= 4 ? ppqn / 4 : 1;
+
+    if (onPPQN)
+    {
+        onPPQN(current);
+    }
+    if (onSync24 && current % per24 == 0)
+    {
+        onSync24(current / per24);
+    }
+    if (onStep && current % perStep == 0)
+    {
+        onStep(current / perStep);
+    }
+}
+
+void uClockClass::scheduleNext()
+{
+    pendingEvent = HostClock::schedule(uint64_t(nextTickUs + 0.5), [this]()
+    {
+        pendingEvent = 0;
+        emitTick();
+
+        // A callback may have stopped, paused or restarted the clock
+        if (state != RUNNING || pendingEvent)
+            return;
+        if (mode == INTERNAL_CLOCK)
+        {
+            nextTickUs += tickPeriodUs();
+            scheduleNext();
+        }
+        else if (tick < releasedTicks && pulseIntervalUs)
+        {
+            uint16_t perPulse = ppqn >= 24 ? ppqn / 24 : 1;
+            nextTickUs += double(pulseIntervalUs) / perPulse;
+            scheduleNext();
+        }
+    });
+}
+
+void uClockClass::cancelPending()
+{
+    if (pendingEvent)
+    {
+        HostClock::cancel(pendingEvent);
+        pendingEvent = 0;
+    }
+}
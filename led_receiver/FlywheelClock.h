@@ -0,0 +1,221 @@
+#pragma once
+#include <stdint.h>
+
+// Local 24 PPQN clock for the follower, disciplined by the leader's
+// CLOCK and BEAT messages.
+//
+// The leader's tick numbers and the local arrival times form a model
+// of the leader clock: tick t is expected at anchorUs + (t - anchorTick)
+// * period. Every received tick nudges the model's phase and period
+// (alpha-beta filter), so single late or missing packets barely move it.
+// Output ticks are scheduled from the model and free-run through gaps;
+// phase errors are slewed out over several ticks instead of jumping.
+//
+// Plain C++ with no Arduino dependency so it can be driven from a host
+// build with recorded message traces.
+class FlywheelClock {
+public:
+  static const uint8_t TICKS_PER_BEAT = 24;
+
+  struct Stats {
+    uint32_t observations;   // CLOCK/BEAT observations used by the model
+    uint32_t ignored;        // Duplicate or reordered ticks
+    uint32_t resyncs;        // Hard phase jumps
+    uint32_t catchUpTicks;   // Ticks emitted late, back to back
+    int32_t lastErrorUs;     // Arrival time minus model prediction
+    uint32_t maxErrorUs;     // Largest |error| absorbed without a resync
+  };
+
+private:
+  // Filter gains as shifts: phase 1/4, period 1/16 of the error per tick
+  static const uint8_t PHASE_GAIN_SHIFT = 2;
+  static const uint8_t PERIOD_GAIN_SHIFT = 4;
+  // Output slews at most 1/8 of a tick per tick towards the model
+  static const uint8_t SLEW_LIMIT_SHIFT = 3;
+  // Errors above this many ticks are treated as a new timeline
+  static const uint8_t RESYNC_TICKS = 4;
+  // Ticks emitted in one poll before the output jumps instead
+  static const uint8_t MAX_CATCH_UP = TICKS_PER_BEAT;
+  // Free-run this many beats without any message, then go quiet
+  static const uint8_t HOLDOVER_BEATS = 8;
+
+  bool running = false;
+  bool locked = false;
+  bool tempoKnown = false;  // A BEAT has given the leader's tempo
+  bool measuring = false;   // First tick seen, waiting for a second
+
+  // Leader clock model, period in Q8 microseconds
+  uint32_t anchorTick = 0;
+  uint32_t anchorUs = 0;
+  uint32_t periodQ8 = (500000u << 8) / TICKS_PER_BEAT;
+  uint32_t nominalQ8 = periodQ8;
+  uint32_t lastObservationUs = 0;
+
+  // Output schedule
+  uint32_t outTick = 0;     // Leader tick number of the next output tick
+  uint32_t nextOutUs = 0;   // Local time the next output tick is due
+
+  Stats stats = {};
+
+  uint32_t periodUs() const { return periodQ8 >> 8; }
+
+  uint32_t predict(uint32_t tick) const {
+    int64_t ticks = int32_t(tick - anchorTick);
+    return anchorUs + uint32_t(int32_t((ticks * periodQ8) >> 8));
+  }
+
+  // Leader tick number closest to local time `us`
+  uint32_t tickAt(uint32_t us) const {
+    int64_t elapsed = int32_t(us - anchorUs);
+    int64_t ticks = ((elapsed << 8) + (periodQ8 >> 1)) / periodQ8;
+    return anchorTick + uint32_t(int32_t(ticks));
+  }
+
+  void anchor(uint32_t tick, uint32_t rxUs) {
+    anchorTick = tick;
+    anchorUs = rxUs;
+    outTick = tick;
+    nextOutUs = rxUs;
+  }
+
+  void observe(uint32_t tick, uint32_t rxUs) {
+    lastObservationUs = rxUs;
+
+    if (!locked) {
+      // Without a BEAT yet, the period comes from the first two ticks,
+      // not from whatever tempo the last session had
+      if (!tempoKnown) {
+        if (!measuring) {
+          measuring = true;
+          anchorTick = tick;
+          anchorUs = rxUs;
+          stats.observations++;
+          return;
+        }
+        int32_t gap = int32_t(tick - anchorTick);
+        if (gap <= 0) {
+          stats.ignored++;
+          return;
+        }
+        nominalQ8 = uint32_t((uint64_t(uint32_t(rxUs - anchorUs)) << 8) / uint32_t(gap));
+        periodQ8 = nominalQ8;
+      }
+      locked = true;
+      anchor(tick, rxUs);
+      stats.observations++;
+      return;
+    }
+
+    int32_t gap = int32_t(tick - anchorTick);
+    if (gap <= 0) {
+      stats.ignored++;
+      return;
+    }
+
+    int32_t error = int32_t(rxUs - predict(tick));
+    uint32_t magnitude = error < 0 ? uint32_t(-error) : uint32_t(error);
+    stats.lastErrorUs = error;
+    stats.observations++;
+
+    if (magnitude > RESYNC_TICKS * periodUs()) {
+      stats.resyncs++;
+      anchor(tick, rxUs);
+      return;
+    }
+    if (magnitude > stats.maxErrorUs) {
+      stats.maxErrorUs = magnitude;
+    }
+
+    // Alpha-beta update; the period term is spread over the ticks since
+    // the last observation so sparse packets do not over-correct
+    int64_t periodStep = (int64_t(error) << 8) / (int64_t(gap) << PERIOD_GAIN_SHIFT);
+    uint32_t newPeriod = uint32_t(int64_t(periodQ8) + periodStep);
+    uint32_t limit = nominalQ8 >> 2;
+    if (newPeriod < nominalQ8 - limit) newPeriod = nominalQ8 - limit;
+    if (newPeriod > nominalQ8 + limit) newPeriod = nominalQ8 + limit;
+
+    anchorUs = predict(tick) + (error >> PHASE_GAIN_SHIFT);
+    anchorTick = tick;
+    periodQ8 = newPeriod;
+  }
+
+public:
+  void start() {
+    running = true;
+    locked = false;
+    tempoKnown = false;
+    measuring = false;
+    stats = {};
+  }
+
+  void stop() {
+    running = false;
+    locked = false;
+  }
+
+  // Leader tempo from a BEAT message. Small differences are left to the
+  // filter; a real tempo change replaces the period outright.
+  void setTempo(float bpm) {
+    if (bpm <= 0.0f) return;
+    tempoKnown = true;
+    nominalQ8 = uint32_t(60000000.0f * 256.0f / (bpm * TICKS_PER_BEAT));
+    uint32_t difference = periodQ8 > nominalQ8 ? periodQ8 - nominalQ8 : nominalQ8 - periodQ8;
+    if (!locked || difference > (nominalQ8 >> 4)) {
+      periodQ8 = nominalQ8;
+    }
+  }
+
+  // A CLOCK message for leader tick `tick` arrived at local time `rxUs`
+  void onClock(uint32_t tick, uint32_t rxUs) {
+    if (running) observe(tick, rxUs);
+  }
+
+  // A BEAT message arrived; the leader sends it on a tick that is a
+  // multiple of 24, which keeps the phase when CLOCK messages are lost
+  void onBeat(uint32_t rxUs) {
+    if (!running || !locked) return;
+    uint32_t tick = tickAt(rxUs);
+    uint32_t offset = tick % TICKS_PER_BEAT;
+    tick += offset < TICKS_PER_BEAT / 2 ? -offset : TICKS_PER_BEAT - offset;
+    observe(tick, rxUs);
+  }
+
+  // Number of output ticks due at `nowUs`; call clockMe() that often
+  uint8_t poll(uint32_t nowUs) {
+    if (!running || !locked) return 0;
+    if (nowUs - lastObservationUs > HOLDOVER_BEATS * TICKS_PER_BEAT * periodUs()) return 0;
+
+    uint8_t due = 0;
+    while (int32_t(nowUs - nextOutUs) >= 0) {
+      if (due == MAX_CATCH_UP) {
+        // Too far behind to catch up musically, rejoin the model
+        stats.resyncs++;
+        outTick = tickAt(nowUs) + 1;
+        nextOutUs = predict(outTick);
+        break;
+      }
+      due++;
+
+      // Slew the schedule towards the model by at most 1/8 tick
+      int32_t period = int32_t(periodUs());
+      int32_t drift = int32_t(predict(outTick) - nextOutUs);
+      int32_t limit = period >> SLEW_LIMIT_SHIFT;
+      int32_t correction = drift / 4;
+      if (correction > limit) correction = limit;
+      if (correction < -limit) correction = -limit;
+
+      outTick++;
+      nextOutUs += uint32_t(period + correction);
+    }
+    if (due > 1) {
+      stats.catchUpTicks += due - 1;
+    }
+    return due;
+  }
+
+  bool isRunning() const { return running; }
+  bool isLocked() const { return locked; }
+  uint32_t getOutputTick() const { return outTick; }
+  uint32_t getPeriodUs() const { return periodUs(); }
+  const Stats& getStats() const { return stats; }
+};
@@ -3,6 +3,7 @@
 #include <WiFi.h>
 #include <FastLED.h>
 #include <uClock.h>
+#include "FlywheelClock.h"
 
 // LED strip configuration
 #define LED_PIN     4
@@ -23,7 +24,12 @@ typedef enum {
   MSG_BEAT = 1,
   MSG_BAR = 2,
   MSG_CONTROL = 3,
-  MSG_PATTERN = 4
+  MSG_PATTERN = 4,
+  MSG_GROOVE = 5,
+  MSG_RAMP = 6,
+  MSG_CHANCE = 7,
+  MSG_SONG = 8,
+  MSG_SONG_ENTRY = 9
 } MessageType;
 
 // Protocol message structures
@@ -72,6 +78,43 @@ typedef struct {
       uint8_t enabled;        // Channel enabled state
       uint8_t reserved[2];    // Reserved
     } pattern;
+    
+    struct {
+      uint8_t channelId;      // Channel ID
+      uint8_t swing;          // Swing percent, 50 = straight
+      uint8_t firstStep;      // Step of offsets[0]
+      int8_t offsets[8];      // Step offsets in PPQN ticks
+      uint8_t reserved[1];    // Reserved
+    } groove;
+    
+    struct {
+      uint32_t startTick;     // PPQN tick the ramp starts on
+      uint16_t fromBpm;       // Tempo at the start
+      uint16_t toBpm;         // Tempo at the end
+      uint16_t lengthPulses;  // Length in SYNC24 pulses
+      uint8_t shape;          // 0 linear, 1 exponential
+      uint8_t reserved;       // Reserved
+    } ramp;
+    
+    struct {
+      uint8_t channelId;      // Channel ID
+      uint8_t firstStep;      // Step of chances[0]
+      uint8_t chances[8];     // Trigger chance in percent
+      uint8_t reserved[2];    // Reserved
+    } chance;
+    
+    struct {
+      uint8_t count;          // Entries in the song
+      uint8_t flags;          // Bit 0 loop
+      uint8_t firstEntry;     // Entry of bars[0]
+      uint8_t bars[8];        // Bars each entry plays
+      uint8_t reserved;       // Reserved
+    } song;
+    
+    struct {
+      uint8_t index;          // Entry index
+      uint8_t settings[11];   // Preset after its format byte
+    } songEntry;
   } data;
 } SyncMessage;
 
@@ -203,22 +246,16 @@ private:
   uint32_t lastClockTick = 0;
   
   LEDDisplay& display;
-  
-  struct TimingState {
-    uint32_t latencyBuffer[8];
-    uint32_t averageLatency;
-    uint32_t lastReceivedTick;
-    uint32_t predictedNextTick;
-    float driftCorrection;
-  } timing;
+
+  // Local beat clock; messages arrive on the WiFi task, ticks are
+  // emitted from the loop
+  FlywheelClock flywheel;
+  portMUX_TYPE flywheelMux = portMUX_INITIALIZER_UNLOCKED;
 
 public:
-  SyncFollower(LEDDisplay& disp) : display(disp) {
-    timing.averageLatency = 0;
-    timing.driftCorrection = 1.0;
-  }
+  SyncFollower(LEDDisplay& disp) : display(disp) {}
 
-  void handleClock(const SyncMessage& msg) {
+  void handleClock(const SyncMessage& msg, uint32_t rxUs) {
     lastClockTime = millis();
     lastClockTick = msg.data.clock.clockTick;
     
@@ -229,23 +266,26 @@ public:
 
     if (!isRunning) return;
 
-    // Calculate message latency
-    uint32_t messageLatency = micros() - msg.timestamp;
-    
-    // Update timing state and apply PLL corrections
-    updateTimingState(messageLatency, msg.timestamp);
-    
-    // Call uClock to maintain sync
-    uClock.clockMe();
+    // The timestamp is the leader's clock, so only the local arrival time
+    // and the tick number feed the flywheel. Lost ticks are filled in by
+    // the flywheel instead of going missing.
+    portENTER_CRITICAL(&flywheelMux);
+    flywheel.onClock(msg.data.clock.clockTick, rxUs);
+    portEXIT_CRITICAL(&flywheelMux);
   }
 
-  void handleBeat(const SyncMessage& msg) {
+  void handleBeat(const SyncMessage& msg, uint32_t rxUs) {
     // Update tempo if changed
     if (msg.data.beat.bpm != currentBpm) {
       currentBpm = msg.data.beat.bpm;
       uClock.setTempo(currentBpm);
     }
 
+    portENTER_CRITICAL(&flywheelMux);
+    flywheel.setTempo(currentBpm);
+    flywheel.onBeat(rxUs);
+    portEXIT_CRITICAL(&flywheelMux);
+
     // Update beat position and trigger visual indication
     display.onBeat(msg.data.beat.beatPosition);
     
@@ -289,14 +329,17 @@ public:
         isRunning = true;
         connectionLost = false;
         lastClockTime = millis();
+        portENTER_CRITICAL(&flywheelMux);
+        flywheel.start();
+        portEXIT_CRITICAL(&flywheelMux);
         uClock.start();
         break;
       case 2: // STOP
-        isRunning = false;
-        uClock.stop();
-        break;
       case 3: // PAUSE
         isRunning = false;
+        portENTER_CRITICAL(&flywheelMux);
+        flywheel.stop();
+        portEXIT_CRITICAL(&flywheelMux);
         uClock.stop();
         break;
       case 4: // RESET
@@ -317,7 +360,19 @@ public:
     }
   }
 
+  // Feed uClock every tick the flywheel has due, lost packets included
+  void clockTicks() {
+    portENTER_CRITICAL(&flywheelMux);
+    uint8_t due = flywheel.poll(micros());
+    portEXIT_CRITICAL(&flywheelMux);
+
+    for (uint8_t i = 0; i < due; i++) {
+      uClock.clockMe();
+    }
+  }
+
   void update() {
+    clockTicks();
     checkConnection();
     if (!connectionLost) {
       display.updateMainBeat();
@@ -325,37 +380,6 @@ public:
       display.show();
     }
   }
-
-private:
-  void updateTimingState(uint32_t messageLatency, uint64_t messageTimestamp) {
-    // Update latency buffer (simple rolling average)
-    static uint8_t latencyIndex = 0;
-    timing.latencyBuffer[latencyIndex] = messageLatency;
-    latencyIndex = (latencyIndex + 1) % 8;
-
-    // Calculate average latency
-    uint32_t sum = 0;
-    for (int i = 0; i < 8; i++) {
-      sum += timing.latencyBuffer[i];
-    }
-    timing.averageLatency = sum / 8;
-
-    // Calculate phase error and apply corrections
-    uint32_t tickInterval = 60000000 / (currentBpm * 24); // microseconds per tick
-    uint64_t predictedArrivalTime = messageTimestamp + timing.averageLatency;
-    int32_t phaseError = micros() - predictedArrivalTime;
-
-    // Apply tempo correction if phase error is significant
-    if (abs(phaseError) > 100) { // More than 100μs error
-      float tempoAdjustment = (phaseError > 0) ? 0.9999f : 1.0001f;
-      float newTempo = currentBpm * tempoAdjustment;
-      
-      if (newTempo >= MIN_BPM && newTempo <= MAX_BPM) {
-        currentBpm = newTempo;
-        uClock.setTempo(newTempo);
-      }
-    }
-  }
 };
 
 // Global instances
@@ -365,6 +389,8 @@ SyncFollower* follower;
 
 // ESP-NOW callback
 void onDataReceived(const uint8_t *mac, const uint8_t *data, int len) {
+  uint32_t rxUs = micros();
+
   if (len != sizeof(SyncMessage)) {
     Serial.printf("Invalid message size: %d\n", len);
     return;
@@ -374,10 +400,10 @@ void onDataReceived(const uint8_t *mac, const uint8_t *data, int len) {
   
   switch (msg->type) {
     case MSG_CLOCK:
-      follower->handleClock(*msg);
+      follower->handleClock(*msg, rxUs);
       break;
     case MSG_BEAT:
-      follower->handleBeat(*msg);
+      follower->handleBeat(*msg, rxUs);
       break;
     case MSG_BAR:
       follower->handleBar(*msg);
@@ -0,0 +1,68 @@
+#include "BootProfiler.h"
+
+BootPhaseRecord BootProfiler::phases[BOOT_MAX_PHASES];
+volatile uint8_t BootProfiler::count = 0;
+volatile uint32_t BootProfiler::readyUs = 0;
+bool BootProfiler::reported = false;
+portMUX_TYPE BootProfiler::mux = portMUX_INITIALIZER_UNLOCKED;
+
+uint8_t BootProfiler::begin(const char *name)
+{
+    uint32_t now = micros();
+
+    portENTER_CRITICAL(&mux);
+    uint8_t phase = count;
+    if (phase < BOOT_MAX_PHASES)
+    {
+        phases[phase] = {name, now, 0};
+        count = phase + 1;
+    }
+    portEXIT_CRITICAL(&mux);
+    return phase;
+}
+
+void BootProfiler::end(uint8_t phase)
+{
+    uint32_t now = micros();
+
+    portENTER_CRITICAL(&mux);
+    if (phase < count)
+    {
+        // Keep 0 for "still running"
+        phases[phase].endUs = now ? now : 1;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+void BootProfiler::markReady()
+{
+    readyUs = micros();
+}
+
+void BootProfiler::reportWhenDone()
+{
+    if (reported || !readyUs)
+        return;
+
+    portENTER_CRITICAL(&mux);
+    bool running = false;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        running |= phases[i].endUs == 0;
+    }
+    portEXIT_CRITICAL(&mux);
+    if (running)
+        return;
+
+    reported = true;
+    Serial.println("Boot phases (ms from power-on):");
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const BootPhaseRecord &phase = phases[i];
+        Serial.printf("  %-16s %7.1f - %7.1f  (%.1f)\n", phase.name,
+                      phase.startUs / 1000.0f, phase.endUs / 1000.0f,
+                      (phase.endUs - phase.startUs) / 1000.0f);
+    }
+    Serial.printf("Ready to play at %.1f ms (target %u ms)%s\n", readyUs / 1000.0f,
+                  BOOT_TARGET_MS, readyUs > BOOT_TARGET_MS * 1000UL ? " - OVER TARGET" : "");
+}
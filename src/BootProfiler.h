@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Boot phase timings, measured from power-on (esp_timer starts with the
+// app). Phases may overlap: slow steps run in background tasks while
+// setup() carries on. Once setup() has marked the unit ready and every
+// phase has ended, reportWhenDone() prints the table once.
+
+struct BootPhaseRecord
+{
+    const char *name;
+    uint32_t startUs;
+    uint32_t endUs; // 0 while the phase is still running
+};
+
+class BootProfiler
+{
+private:
+    static BootPhaseRecord phases[BOOT_MAX_PHASES];
+    static volatile uint8_t count;
+    static volatile uint32_t readyUs;
+    static bool reported;
+    static portMUX_TYPE mux;
+
+public:
+    // Returns a handle for end(); phases past BOOT_MAX_PHASES are not kept
+    static uint8_t begin(const char *name);
+    static void end(uint8_t phase);
+
+    // The unit accepts START from here on
+    static void markReady();
+    static uint32_t getReadyUs() { return readyUs; }
+
+    static void reportWhenDone();
+};
+
+// Times the enclosing scope as one boot phase
+class BootPhase
+{
+private:
+    uint8_t phase;
+
+public:
+    explicit BootPhase(const char *name) : phase(BootProfiler::begin(name)) {}
+    ~BootPhase() { BootProfiler::end(phase); }
+};
@@ -0,0 +1,124 @@
+#include "ButtonInput.h"
+#include <soc/gpio_struct.h>
+
+// Buttons pull to ground when pressed
+static inline bool IRAM_ATTR isLow(uint8_t pin)
+{
+    uint32_t levels = pin < 32 ? GPIO.in : GPIO.in1.data;
+    return !((levels >> (pin & 31)) & 1);
+}
+
+void IRAM_ATTR ButtonInput::onEdge(void *arg)
+{
+    Button *button = static_cast<Button *>(arg);
+    uint32_t now = micros();
+    bool pressed = isLow(button->pin);
+
+    // Back at the accepted level, or still inside the bounce window
+    if (pressed == button->pressed || now - button->edgeUs < BUTTON_DEBOUNCE_US)
+        return;
+
+    button->owner->accept(*button, pressed, now);
+}
+
+void IRAM_ATTR ButtonInput::accept(Button &button, bool pressed, uint32_t us)
+{
+    button.pressed = pressed;
+    button.edgeUs = us;
+    button.longPressSent = false;
+
+    ButtonEvent event = {us, button.id, pressed ? BUTTON_PRESS : BUTTON_RELEASE};
+    push(event);
+
+    if (pressed && button.id != BUTTON_ENCODER && transportQueue)
+    {
+        if (xPortInIsrContext())
+        {
+            BaseType_t woken = pdFALSE;
+            xQueueSendFromISR(transportQueue, &event, &woken);
+            if (woken)
+                portYIELD_FROM_ISR();
+        }
+        else
+        {
+            xQueueSend(transportQueue, &event, 0);
+        }
+    }
+}
+
+void IRAM_ATTR ButtonInput::push(const ButtonEvent &event)
+{
+    portENTER_CRITICAL_SAFE(&mux);
+    uint8_t next = (head + 1) % BUTTON_QUEUE_SIZE;
+    if (next != tail)
+    {
+        ring[head] = event;
+        head = next;
+    }
+    portEXIT_CRITICAL_SAFE(&mux);
+}
+
+// An edge swallowed by the debounce window (a tap shorter than it, or a
+// bounce that settled on the other level) is picked up once the pin has
+// been stable for a full window
+void ButtonInput::resync(Button &button, uint32_t nowUs)
+{
+    bool pressed = isLow(button.pin);
+
+    portENTER_CRITICAL(&mux);
+    bool stale = pressed != button.pressed && nowUs - button.edgeUs >= BUTTON_DEBOUNCE_US;
+    portEXIT_CRITICAL(&mux);
+
+    if (stale)
+    {
+        accept(button, pressed, nowUs);
+    }
+}
+
+void ButtonInput::begin(uint8_t encoderPin, uint8_t startPin, uint8_t stopPin)
+{
+    const uint8_t pins[BUTTON_COUNT] = {encoderPin, startPin, stopPin};
+    transportQueue = xQueueCreate(BUTTON_QUEUE_SIZE, sizeof(ButtonEvent));
+
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++)
+    {
+        Button &button = buttons[i];
+        button.owner = this;
+        button.id = static_cast<ButtonId>(i);
+        button.pin = pins[i];
+        pinMode(button.pin, INPUT_PULLUP);
+        button.pressed = isLow(button.pin);
+        button.edgeUs = now;
+        // Held since boot (e.g. STOP for calibration) is not a long press
+        button.longPressSent = true;
+        attachInterruptArg(digitalPinToInterrupt(button.pin), onEdge, &button, CHANGE);
+    }
+}
+
+bool ButtonInput::pop(ButtonEvent &event)
+{
+    uint32_t now = micros();
+    for (Button &button : buttons)
+    {
+        resync(button, now);
+
+        if (button.pressed && !button.longPressSent &&
+            now - button.edgeUs >= LONG_PRESS_DURATION_MS * 1000UL)
+        {
+            button.longPressSent = true;
+            uint32_t longPressUs = button.edgeUs + LONG_PRESS_DURATION_MS * 1000UL;
+            push({longPressUs, button.id, BUTTON_LONG_PRESS});
+        }
+    }
+
+    portENTER_CRITICAL(&mux);
+    bool available = tail != head;
+    if (available)
+    {
+        event = ring[tail];
+        tail = (tail + 1) % BUTTON_QUEUE_SIZE;
+    }
+    portEXIT_CRITICAL(&mux);
+    return available;
+}
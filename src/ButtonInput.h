@@ -0,0 +1,68 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+enum ButtonId : uint8_t
+{
+    BUTTON_ENCODER,
+    BUTTON_START,
+    BUTTON_STOP,
+    BUTTON_COUNT
+};
+
+enum ButtonEventType : uint8_t
+{
+    BUTTON_PRESS,
+    BUTTON_RELEASE,
+    BUTTON_LONG_PRESS
+};
+
+struct ButtonEvent
+{
+    uint32_t us;        // Edge time taken in the interrupt
+    ButtonId button;
+    ButtonEventType type;
+};
+
+// Debounced, timestamped button events from edge interrupts.
+// The first edge of a press is accepted at once and stamped in the ISR;
+// edges within BUTTON_DEBOUNCE_US of it are bounce. Every event goes to a
+// small ring drained by the loop. START and STOP presses also go to a
+// FreeRTOS queue, so a control task can act on them without waiting for
+// the loop. Long presses are generated when the loop drains the ring.
+class ButtonInput
+{
+private:
+    struct Button
+    {
+        ButtonInput *owner;
+        ButtonId id;
+        uint8_t pin;
+        volatile bool pressed;
+        volatile uint32_t edgeUs;   // Last accepted edge
+        bool longPressSent;
+    };
+
+    Button buttons[BUTTON_COUNT] = {};
+    ButtonEvent ring[BUTTON_QUEUE_SIZE];
+    volatile uint8_t head = 0;
+    volatile uint8_t tail = 0;
+    QueueHandle_t transportQueue = nullptr;
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    static void IRAM_ATTR onEdge(void *arg);
+    void IRAM_ATTR accept(Button &button, bool pressed, uint32_t us);
+    void IRAM_ATTR push(const ButtonEvent &event);
+    void resync(Button &button, uint32_t nowUs);
+
+public:
+    void begin(uint8_t encoderPin, uint8_t startPin, uint8_t stopPin);
+
+    // Next event for the loop; also emits long presses that are due
+    bool pop(ButtonEvent &event);
+
+    // START/STOP presses, for a task blocked in xQueueReceive()
+    QueueHandle_t getTransportQueue() const { return transportQueue; }
+
+    bool isPressed(ButtonId button) const { return buttons[button].pressed; }
+};
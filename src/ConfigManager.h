@@ -64,10 +64,10 @@ public:
     }
     
     // Load global parameters
-    state.bpm = constrain(prefs.getUShort("bpm", DEFAULT_BPM), MIN_GLOBAL_BPM, MAX_GLOBAL_BPM);
-    state.currentMultiplierIndex = constrain(prefs.getUChar("multiplier", 0), 0, MULTIPLIER_COUNT - 1);
-    state.rhythmMode = static_cast<MetronomeMode>(
-      constrain(prefs.getUChar("rhythmMode", 0), 0, 1)); // 0=POLYMETER, 1=POLYRHYTHM
+    state.setBpm(constrain(prefs.getUShort("bpm", DEFAULT_BPM), MIN_GLOBAL_BPM, MAX_GLOBAL_BPM));
+    state.setMultiplierIndex(constrain(prefs.getUChar("multiplier", 0), 0, MULTIPLIER_COUNT - 1));
+    state.setRhythmMode(static_cast<MetronomeMode>(
+      constrain(prefs.getUChar("rhythmMode", 0), 0, 1))); // 0=POLYMETER, 1=POLYRHYTHM
     
     // Load channel-specific parameters
     for (uint8_t i = 0; i < FIXED_CHANNEL_COUNT; i++) {
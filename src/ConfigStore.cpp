@@ -0,0 +1,290 @@
+#include "ConfigStore.h"
+#include "ConfigManager.h"
+#include <stddef.h>
+
+const char *const ConfigStore::SLOT_KEYS[2] = {"cfgA", "cfgB"};
+
+uint32_t ConfigStore::crc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+// Compare settings only, ignoring the sequence number and checksum
+bool ConfigStore::samePayload(const Record &a, const Record &b)
+{
+    const size_t start = offsetof(Record, bpm);
+    const size_t end = offsetof(Record, crc);
+    return memcmp(reinterpret_cast<const uint8_t *>(&a) + start,
+                  reinterpret_cast<const uint8_t *>(&b) + start, end - start) == 0;
+}
+
+void ConfigStore::capture(const MetronomeState &state, Record &record) const
+{
+    record.magic = CONFIG_MAGIC_MARKER;
+    record.version = CONFIG_STORE_VERSION;
+    record.bpm = state.bpm;
+    record.multiplierIndex = state.currentMultiplierIndex;
+    record.rhythmMode = static_cast<uint8_t>(state.rhythmMode);
+
+    for (uint8_t i = 0; i < FIXED_CHANNEL_COUNT; i++)
+    {
+        const MetronomeChannel &channel = state.getChannel(i);
+        ChannelRecord &stored = record.channels[i];
+        stored.enabled = channel.isEnabled();
+        stored.barLength = channel.getBarLength();
+        stored.pattern = channel.getPattern();
+        stored.volume = channel.getVolume();
+        stored.strongVolume = channel.getStrongVolume();
+        stored.weakVolume = channel.getWeakVolume();
+        stored.latencyUs = latencyUs[i];
+    }
+}
+
+void ConfigStore::apply(const Record &record, MetronomeState &state)
+{
+    state.setBpm(constrain(record.bpm, MIN_GLOBAL_BPM, MAX_GLOBAL_BPM));
+    state.setMultiplierIndex(constrain(record.multiplierIndex, 0, MULTIPLIER_COUNT - 1));
+    state.setRhythmMode(static_cast<MetronomeMode>(constrain(record.rhythmMode, 0, 1)));
+
+    for (uint8_t i = 0; i < FIXED_CHANNEL_COUNT; i++)
+    {
+        MetronomeChannel &channel = state.getChannel(i);
+        const ChannelRecord &stored = record.channels[i];
+        if (channel.isEnabled() != bool(stored.enabled))
+        {
+            channel.toggleEnabled();
+        }
+        channel.setBarLength(constrain(stored.barLength, 1, MAX_BEATS));
+        channel.setPattern(stored.pattern & channel.getMaxPattern());
+        channel.setVolume(stored.volume);
+        channel.setStrongVolume(stored.strongVolume);
+        channel.setWeakVolume(stored.weakVolume);
+        latencyUs[i] = stored.latencyUs;
+    }
+}
+
+bool ConfigStore::readSlot(uint8_t slot, Record &record)
+{
+    if (prefs.getBytesLength(SLOT_KEYS[slot]) != sizeof(Record))
+    {
+        return false;
+    }
+    prefs.getBytes(SLOT_KEYS[slot], &record, sizeof(Record));
+    return record.magic == CONFIG_MAGIC_MARKER &&
+           record.version == CONFIG_STORE_VERSION &&
+           record.crc == crc32(reinterpret_cast<const uint8_t *>(&record), offsetof(Record, crc));
+}
+
+// A version 2 slot as a current record without calibrated latencies;
+// the next commit rewrites it in the current layout
+bool ConfigStore::readSlotV2(uint8_t slot, Record &record)
+{
+    RecordV2 old;
+    if (prefs.getBytesLength(SLOT_KEYS[slot]) != sizeof(RecordV2))
+    {
+        return false;
+    }
+    prefs.getBytes(SLOT_KEYS[slot], &old, sizeof(RecordV2));
+    if (old.magic != CONFIG_MAGIC_MARKER || old.version != 2 ||
+        old.crc != crc32(reinterpret_cast<const uint8_t *>(&old), offsetof(RecordV2, crc)))
+    {
+        return false;
+    }
+
+    record = {};
+    record.magic = CONFIG_MAGIC_MARKER;
+    record.version = 2;
+    record.sequence = old.sequence;
+    record.bpm = old.bpm;
+    record.multiplierIndex = old.multiplierIndex;
+    record.rhythmMode = old.rhythmMode;
+    for (uint8_t i = 0; i < FIXED_CHANNEL_COUNT; i++)
+    {
+        ChannelRecord &channel = record.channels[i];
+        channel.enabled = old.channels[i].enabled;
+        channel.barLength = old.channels[i].barLength;
+        channel.pattern = old.channels[i].pattern;
+        channel.volume = old.channels[i].volume;
+        channel.strongVolume = old.channels[i].strongVolume;
+        channel.weakVolume = old.channels[i].weakVolume;
+    }
+    return true;
+}
+
+bool ConfigStore::write(const Record &record)
+{
+    Record stored = record;
+    stored.sequence = committed.sequence + 1;
+    stored.crc = crc32(reinterpret_cast<const uint8_t *>(&stored), offsetof(Record, crc));
+
+    uint32_t start = micros();
+    bool ok = prefs.putBytes(SLOT_KEYS[nextSlot], &stored, sizeof(Record)) == sizeof(Record);
+    uint32_t elapsed = micros() - start;
+
+    stats.lastCommitUs = elapsed;
+    if (elapsed > stats.maxCommitUs)
+    {
+        stats.maxCommitUs = elapsed;
+    }
+    if (!ok)
+    {
+        Serial.println("Configuration commit failed");
+        return false;
+    }
+
+    committed = stored;
+    nextSlot ^= 1;
+    stats.writes = stored.sequence;
+    stats.sessionWrites++;
+    Serial.printf("Configuration committed (write #%lu, %lu us)\n",
+                  (unsigned long)stats.writes, (unsigned long)elapsed);
+    return true;
+}
+
+bool ConfigStore::begin()
+{
+    // Kept open for the whole session; commits must not pay for begin/end
+    opened = prefs.begin(ConfigManager::NAMESPACE_NAME, false);
+    if (!opened)
+    {
+        Serial.println("Failed to initialize Preferences storage!");
+    }
+    return opened;
+}
+
+bool ConfigStore::load(MetronomeState &state)
+{
+    if (!opened)
+    {
+        return false;
+    }
+
+    Record slots[2];
+    bool valid[2];
+    for (uint8_t slot = 0; slot < 2; slot++)
+    {
+        valid[slot] = readSlot(slot, slots[slot]) || readSlotV2(slot, slots[slot]);
+    }
+    int8_t newest = -1;
+    for (uint8_t slot = 0; slot < 2; slot++)
+    {
+        if (valid[slot] && (newest < 0 || int32_t(slots[slot].sequence - slots[newest].sequence) > 0))
+        {
+            newest = slot;
+        }
+    }
+
+    if (newest >= 0)
+    {
+        committed = slots[newest];
+        nextSlot = newest ^ 1;
+        stats.writes = committed.sequence;
+        apply(committed, state);
+        Serial.printf("Loaded configuration (write #%lu)\n", (unsigned long)committed.sequence);
+        return true;
+    }
+
+    // Nothing in blob form yet; fall back to the old per-key layout. The
+    // empty `committed` record makes the next quiet point migrate it.
+    ConfigManager::init();
+    bool loaded = ConfigManager::loadConfig(state);
+    ConfigManager::end();
+    return loaded;
+}
+
+void ConfigStore::update(const MetronomeState &state, uint32_t nowMs, bool held)
+{
+    // The loop sees the downbeat within a few ms; the next beat is at
+    // least a beat away, which is ample room for one NVS write
+    uint8_t barLength = state.getChannel(0).getBarLength();
+    uint32_t bar = barLength ? state.globalTick / barLength : 0;
+    bool barBoundary = bar != lastBar;
+    lastBar = bar;
+
+    // Changes made meanwhile are picked up once the hold ends
+    if (held)
+    {
+        return;
+    }
+
+    // Only snapshot when a setting actually changed
+    if (changes.poll(state) || latencyChanged)
+    {
+        latencyChanged = false;
+        Record current = {};
+        capture(state, current);
+        if (!havePending || !samePayload(current, pending))
+        {
+            pending = current;
+            havePending = true;
+            lastChangeMs = nowMs;
+        }
+    }
+
+    if (!opened || samePayload(pending, committed))
+    {
+        return;
+    }
+    if (nowMs - lastChangeMs < CONFIG_DEBOUNCE_MS)
+    {
+        return;
+    }
+    bool playing = state.isRunning && !state.isPaused;
+    if (playing && !barBoundary)
+    {
+        return;
+    }
+
+    write(pending);
+}
+
+bool ConfigStore::commit(const MetronomeState &state)
+{
+    if (!opened)
+    {
+        return false;
+    }
+    capture(state, pending);
+    havePending = true;
+    return write(pending);
+}
+
+bool ConfigStore::clear()
+{
+    if (!opened)
+    {
+        return false;
+    }
+    // Wipes both slots and any legacy keys; the sequence carries on so
+    // the write count still covers the flash that has been used
+    uint32_t sequence = committed.sequence;
+    bool ok = prefs.clear();
+    committed = {};
+    committed.sequence = sequence;
+    nextSlot = 0;
+    return ok;
+}
+
+void ConfigStore::setSolenoidLatency(uint8_t channel, uint32_t us)
+{
+    if (channel >= FIXED_CHANNEL_COUNT)
+    {
+        return;
+    }
+    latencyUs[channel] = uint16_t(min(us, uint32_t(UINT16_MAX)));
+    latencyChanged = true;
+}
+
+uint32_t ConfigStore::getSolenoidLatency(uint8_t channel) const
+{
+    return channel < FIXED_CHANNEL_COUNT ? latencyUs[channel] : 0;
+}
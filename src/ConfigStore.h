@@ -0,0 +1,122 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include "config.h"
+#include "MetronomeState.h"
+
+// Write-behind configuration store.
+//
+// The whole persisted state is one packed, CRC-checked blob. Commits
+// alternate between two NVS keys with an increasing sequence number, so a
+// write torn by a power cut leaves the previous copy intact; loading picks
+// the newest slot that verifies. Edits are only snapshotted in RAM; the
+// flash write waits until nothing has changed for CONFIG_DEBOUNCE_MS and
+// the metronome is at a quiet point (stopped, paused, or just past a bar
+// downbeat), so NVS never stalls the cache in the middle of a bar.
+class ConfigStore
+{
+public:
+    struct Stats
+    {
+        uint32_t writes;          // Blob commits over the device's lifetime
+        uint32_t sessionWrites;   // Commits since boot
+        uint32_t lastCommitUs;    // Duration of the last commit
+        uint32_t maxCommitUs;
+    };
+
+private:
+    struct __attribute__((packed)) ChannelRecord
+    {
+        uint8_t enabled;
+        uint8_t barLength;
+        uint16_t pattern;
+        uint8_t volume;
+        uint8_t strongVolume;
+        uint8_t weakVolume;
+        uint16_t latencyUs;       // Calibrated solenoid latency, 0 = default
+    };
+
+    struct __attribute__((packed)) Record
+    {
+        uint16_t magic;
+        uint8_t version;
+        uint32_t sequence;        // Doubles as the lifetime write count
+        uint16_t bpm;
+        uint8_t multiplierIndex;
+        uint8_t rhythmMode;
+        ChannelRecord channels[FIXED_CHANNEL_COUNT];
+        uint32_t crc;             // CRC-32 of every byte above
+    };
+
+    // Version 2, before the solenoid latencies; migrated on load
+    struct __attribute__((packed)) RecordV2
+    {
+        uint16_t magic;
+        uint8_t version;
+        uint32_t sequence;
+        uint16_t bpm;
+        uint8_t multiplierIndex;
+        uint8_t rhythmMode;
+        struct __attribute__((packed))
+        {
+            uint8_t enabled;
+            uint8_t barLength;
+            uint16_t pattern;
+            uint8_t volume;
+            uint8_t strongVolume;
+            uint8_t weakVolume;
+        } channels[FIXED_CHANNEL_COUNT];
+        uint32_t crc;
+    };
+
+    static const char *const SLOT_KEYS[2];
+
+    Preferences prefs;
+    bool opened = false;
+
+    Record committed = {};        // Contents of the newest slot in flash
+    Record pending = {};          // Latest snapshot of the live state
+    uint8_t nextSlot = 0;
+    bool havePending = false;
+    uint32_t lastChangeMs = 0;
+    uint32_t lastBar = 0;
+    ChangeTracker changes;
+    uint16_t latencyUs[FIXED_CHANNEL_COUNT] = {};
+    bool latencyChanged = false;
+    Stats stats = {};
+
+    static uint32_t crc32(const uint8_t *data, size_t length);
+    static bool samePayload(const Record &a, const Record &b);
+    void capture(const MetronomeState &state, Record &record) const;
+    void apply(const Record &record, MetronomeState &state);
+
+    bool readSlot(uint8_t slot, Record &record);
+    bool readSlotV2(uint8_t slot, Record &record);
+    bool write(const Record &record);
+
+public:
+    bool begin();
+
+    // Restore the newest valid blob, or the per-key layout older
+    // firmware wrote (migrated to a blob on the next commit)
+    bool load(MetronomeState &state);
+
+    // Call every loop; commits once edits have settled at a quiet point.
+    // While `held` (a song's entries are playing) the live state is not
+    // the user's, and nothing is snapshotted or written.
+    void update(const MetronomeState &state, uint32_t nowMs, bool held = false);
+
+    // Write the live state now, regardless of debounce
+    bool commit(const MetronomeState &state);
+
+    // Drop both slots and the legacy keys (factory reset)
+    bool clear();
+
+    // Solenoid fire-to-strike latency from calibration, kept with the
+    // settings; 0 = not calibrated (Timing keeps its default)
+    void setSolenoidLatency(uint8_t channel, uint32_t us);
+    uint32_t getSolenoidLatency(uint8_t channel) const;
+
+    bool isDirty() const { return havePending && !samePayload(pending, committed); }
+    const Stats &getStats() const { return stats; }
+};
@@ -1,60 +1,29 @@
 #include "Display.h"
 #include "config.h"
 
-// Initialize static member
-Display *Display::_instance = nullptr;
-
 Display::Display()
 {
     display = new U8G2_SH1106_128X64_NONAME_F_HW_I2C(U8G2_R0, U8X8_PIN_NONE);
-    _instance = this;
-    animationRunning = false;
 }
 
 Display::~Display()
 {
-    stopAnimation();
-    if (_instance == this)
-    {
-        _instance = nullptr;
-    }
     if (display)
     {
         delete display;
     }
 }
 
-void Display::animationTickerCallback()
-{
-    if (_instance)
-    {
-        _instance->animationTick++;
-    }
-}
-
 void Display::begin()
 {
     display->begin();
     display->setFont(u8g2_font_t0_11_tr);
 }
 
-void Display::startAnimation()
-{
-    animationTicker.detach();
-    animationTick = 0;
-    // Update animation at 20ms intervals (50Hz)
-    animationTicker.attach(0.02, animationTickerCallback);
-    animationRunning = true;
-}
-
-void Display::stopAnimation()
-{
-    animationTicker.detach();
-    animationRunning = false;
-}
-
-void Display::update(const MetronomeState &state)
+void Display::update(const MetronomeState &state, const FrameInfo &frameInfo)
 {
+    frame = &frameInfo;
+    refreshLayout(state);
     display->clearBuffer();
 
     display->drawFrame(0, 0, 128, 64);
@@ -73,6 +42,49 @@ void Display::update(const MetronomeState &state)
     display->sendBuffer();
 }
 
+void Display::refreshLayout(const MetronomeState &state)
+{
+    uint8_t changed = layoutChanges.poll(state, changeBit(CHANGE_PATTERN) | changeBit(CHANGE_MODE) |
+                                                    changeBit(CHANGE_MULTIPLIER));
+    if (!changed && layoutPolled)
+        return;
+    layoutPolled = true;
+
+    sprintf(multiplierLabel, "x%s", state.getCurrentMultiplierName());
+
+    // Polymeter keeps one cell width for both channels, set by the longer bar
+    uint8_t ch1Length = state.getChannel(0).getBarLength();
+    uint8_t ch2Length = state.getChannel(1).getBarLength();
+    uint8_t maxLength = (ch1Length > ch2Length) ? ch1Length : ch2Length;
+
+    for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++)
+    {
+        const MetronomeChannel &channel = state.getChannel(i);
+        ChannelLayout &layout = layouts[i];
+        uint8_t barLength = channel.getBarLength();
+
+        sprintf(layout.length, "%02d", barLength);
+        sprintf(layout.patternCount, "%u/%u", channel.getPattern() + 1, channel.getMaxPattern() + 1);
+
+        if (barLength == 0)
+        {
+            layout.cellWidth = 0;
+            layout.drawLength = 0;
+        }
+        else if (state.isPolyrhythm())
+        {
+            // In polyrhythm mode, each pattern takes the full width
+            layout.cellWidth = 126 / barLength;
+            layout.drawLength = barLength;
+        }
+        else
+        {
+            layout.cellWidth = 126 / maxLength;
+            layout.drawLength = (barLength < maxLength) ? barLength : maxLength;
+        }
+    }
+}
+
 void Display::drawGlobalRow(const MetronomeState &state)
 {
     char buffer[32];
@@ -80,12 +92,8 @@ void Display::drawGlobalRow(const MetronomeState &state)
     // Global beat indicator (4px wide block on the left)
     if (state.isRunning)
     {
-        // Calculate flash duration based on BPM and multiplier
-        float beatDuration = 60000.0f / state.getEffectiveBpm();           // in milliseconds
-        float flashDuration = beatDuration * 0.5f;                         // 25% of beat duration
-        uint32_t animTime = (animationTick * 20) % uint32_t(beatDuration); // 20ms per animation tick
-
-        if (animTime < flashDuration)
+        // Flash for the first half of every beat
+        if (frame->isPhaseBelow(0.5f))
         {
             display->drawBox(1, 1, 4, 12);
         }
@@ -113,8 +121,6 @@ void Display::drawGlobalRow(const MetronomeState &state)
     display->setDrawColor(1);
 
     // Multiplier display
-    sprintf(buffer, "x%s", state.getCurrentMultiplierName());
-    
     if (state.isMultiplierSelected())
     {
         display->drawFrame(55, 1, 16, 12);
@@ -124,7 +130,7 @@ void Display::drawGlobalRow(const MetronomeState &state)
             display->setDrawColor(0);
         }
     }
-    display->drawStr(57, 11, buffer);
+    display->drawStr(57, 11, multiplierLabel);
     display->setDrawColor(1);
     
     // Rhythm mode toggle (+ for polymeter, ÷ for polyrhythm)
@@ -187,8 +193,8 @@ void Display::drawGlobalProgress(const MetronomeState &state)
 
 void Display::drawChannelBlock(const MetronomeState &state, uint8_t channelIndex, uint8_t y)
 {
-    char buffer[32];
     const MetronomeChannel &channel = state.getChannel(channelIndex);
+    const ChannelLayout &layout = layouts[channelIndex];
 
 
     // Channel beat indicator (flashing block)
@@ -228,18 +234,10 @@ void Display::drawChannelBlock(const MetronomeState &state, uint8_t channelIndex
             shouldBlink = (channel.getCurrentBeat() == 0);
         }
         
-        // Calculate beat duration based on BPM and multiplier
-        float beatDuration = 60000.0f / state.getEffectiveBpm();
-        
         if (shouldBlink)
         {
-            // Calculate flash duration - longer for better visibility
-            float flashDuration = beatDuration * 0.4f; // 40% of beat duration
-            
-            // Calculate animation time based on the appropriate beat duration
-            uint32_t animTime = (animationTick * 20) % uint32_t(beatDuration);
-            
-            if (animTime < flashDuration)
+            // Flash for the first 40% of the beat - longer for better visibility
+            if (frame->isPhaseBelow(0.4f))
             {
                 display->drawBox(1, y - 1, 4, 12); // Only the height of the upper row
             }
@@ -267,7 +265,6 @@ void Display::drawChannelBlock(const MetronomeState &state, uint8_t channelIndex
     display->setDrawColor(1);
 
     // Length row
-    sprintf(buffer, "%02d", channel.getBarLength());
     bool isLengthSelected = state.isLengthSelected(channelIndex);
 
     // Box for length (shifted right to make room for toggle)
@@ -282,14 +279,11 @@ void Display::drawChannelBlock(const MetronomeState &state, uint8_t channelIndex
     }
 
     // Draw length text
-    display->drawStr(27, y + 8, buffer);
+    display->drawStr(27, y + 8, layout.length);
     display->setDrawColor(1);
 
     // Add pattern counter (current/total)
-    uint16_t currentPattern = channel.getPattern() + 1;
-    uint16_t maxPattern = channel.getMaxPattern() + 1;
-    sprintf(buffer, "%u/%u", currentPattern, maxPattern);
-    display->drawStr(91, y + 8, buffer);
+    display->drawStr(91, y + 8, layout.patternCount);
 
     // Pattern row
     uint8_t patternY = y + 11;
@@ -306,44 +300,19 @@ void Display::drawChannelBlock(const MetronomeState &state, uint8_t channelIndex
     }
     display->drawHLine(1, patternY, 126);
     
-    // Get max length for visualization, depends on rhythm mode
-    uint8_t maxLength;
-    
-    if (state.isPolyrhythm()) {
-        // In polyrhythm mode, each pattern takes the full width
-        maxLength = channel.getBarLength();
-    } else {
-        // In polymeter mode, use max length between channels for consistent visualization
-        uint8_t ch1Length = state.getChannel(0).getBarLength();
-        uint8_t ch2Length = state.getChannel(1).getBarLength();
-        maxLength = (ch1Length > ch2Length) ? ch1Length : ch2Length;
-    }
-    
-    drawBeatGrid(2, patternY + 1, channel, maxLength, state.isPolyrhythm(), state);
+    drawBeatGrid(2, patternY + 1, channel, layout, state.isPolyrhythm(), state);
     display->setDrawColor(1);
 }
 
-void Display::drawBeatGrid(uint8_t x, uint8_t y, const MetronomeChannel &ch, uint8_t maxLength, bool isPolyrhythm, const MetronomeState &state)
+void Display::drawBeatGrid(uint8_t x, uint8_t y, const MetronomeChannel &ch, const ChannelLayout &layout, bool isPolyrhythm, const MetronomeState &state)
 {
     uint8_t barLength = ch.getBarLength();
-    uint8_t cellWidth;
-    
-    if (barLength == 0) return; // Safety check
-    
-    if (isPolyrhythm) {
-        // For polyrhythm, each channel's grid should take the full width
-        cellWidth = 126 / barLength; 
-    } else {
-        // For polymeter, maintain consistent cell width based on max length
-        cellWidth = (maxLength > 0) ? (126 / maxLength) : 0;
-    }
+    uint8_t cellWidth = layout.cellWidth;
+    uint8_t drawLength = layout.drawLength;
 
     if (cellWidth == 0)
         return; // Safety check
 
-    // Calculate how far to draw (either this channel's bar length or the max length, depending on mode)
-    uint8_t drawLength = isPolyrhythm ? barLength : ((barLength < maxLength) ? barLength : maxLength);
-
     // Get current beat position
     uint8_t currentBeat = ch.getCurrentBeat();
     
@@ -418,9 +387,8 @@ void Display::drawBeatGrid(uint8_t x, uint8_t y, const MetronomeChannel &ch, uin
         }
         else if (isCurrentBeat && ch.isEnabled())
         {
-            // Pulsing dot for silent active beat
-            float pulse = (millis() % 500) / 500.0f; // 0.0 to 1.0 over 500ms
-            uint8_t radius = 1 + uint8_t(pulse);
+            // Dot for silent active beat, pulsing larger in the second half of the beat
+            uint8_t radius = frame->isPhaseBelow(0.5f) ? 1 : 2;
             display->drawDisc(cellX + cellWidth / 2 - 1, y + 4, radius);
         }
         else
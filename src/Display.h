@@ -1,36 +1,41 @@
 #pragma once
 #include <U8g2lib.h>
-#include <Ticker.h>
 #include "MetronomeState.h"
 #include "MetronomeChannel.h"
+#include "FrameClock.h"
 
 class Display
 {
 private:
     U8G2_SH1106_128X64_NONAME_F_HW_I2C *display;
 
-    // Animation timing variables
-    uint32_t animationTick = 0;
-    Ticker animationTicker;
-    bool animationRunning = false;
+    // Animation timing comes from the shared frame clock
+    const FrameInfo *frame = nullptr;
 
-    static Display *_instance;
-    static void animationTickerCallback();
+    // Labels and step grid geometry of a channel block; only bar lengths,
+    // patterns, the rhythm mode and the multiplier move them
+    struct ChannelLayout
+    {
+        char length[4];         // Bar length, two digits
+        char patternCount[12];  // Pattern number / patterns for the length
+        uint8_t cellWidth;      // Pixels per step, 0 hides the grid
+        uint8_t drawLength;     // Steps drawn
+    };
 
+    ChannelLayout layouts[MetronomeState::CHANNEL_COUNT] = {};
+    char multiplierLabel[8] = {};
+    ChangeTracker layoutChanges;
+    bool layoutPolled = false;
+
+    void refreshLayout(const MetronomeState &state);
     void drawGlobalRow(const MetronomeState &state);
     void drawGlobalProgress(const MetronomeState &state);
     void drawChannelBlock(const MetronomeState &state, uint8_t channelIndex, uint8_t y);
-    void drawBeatGrid(uint8_t x, uint8_t y, const MetronomeChannel &ch, uint8_t maxLength, bool isPolyrhythm, const MetronomeState &state);
+    void drawBeatGrid(uint8_t x, uint8_t y, const MetronomeChannel &ch, const ChannelLayout &layout, bool isPolyrhythm, const MetronomeState &state);
 
 public:
     Display();
     ~Display(); // Added destructor to prevent memory leaks
     void begin();
-    void update(const MetronomeState &state);
-
-    // Animation control
-    void startAnimation();
-    void stopAnimation();
-    bool isAnimationRunning() const { return animationRunning; }
-    uint32_t getAnimationTick() const { return animationTick; }
+    void update(const MetronomeState &state, const FrameInfo &frameInfo);
 };
\ No newline at end of file
@@ -1,17 +1,7 @@
 #include "EncoderController.h"
 
-// Global pointer for ISR to access
 EncoderController *globalEncoderController = nullptr;
 
-// ISR function that calls the controller method
-void IRAM_ATTR globalEncoderISR()
-{
-  if (globalEncoderController)
-  {
-    globalEncoderController->encoderISRHandler();
-  }
-}
-
 EncoderController::EncoderController(MetronomeState &state, Timing &timing)
     : state(state), timing(timing)
 {
@@ -22,335 +12,307 @@ void EncoderController::begin()
 {
   pinMode(ENCODER_A, INPUT_PULLUP);
   pinMode(ENCODER_B, INPUT_PULLUP);
-  pinMode(ENCODER_BTN, INPUT_PULLUP);
-  pinMode(BTN_START, INPUT_PULLUP);
-  pinMode(BTN_STOP, INPUT_PULLUP);
 
-  attachInterrupt(digitalPinToInterrupt(ENCODER_A), globalEncoderISR, CHANGE);
+  // Buttons are edge interrupts; START and STOP are handled by a task
+  // that preempts the loop as soon as the press is seen
+  buttons.begin(ENCODER_BTN, BTN_START, BTN_STOP);
+  xTaskCreatePinnedToCore(controlTask, "control", 4096, this, CONTROL_TASK_PRIORITY, nullptr, 1);
+
+  // Full quadrature decode in hardware: each channel counts the edges of
+  // one phase, with the other phase setting the direction. No interrupts.
+  pcnt_config_t config = {};
+  config.pulse_gpio_num = ENCODER_A;
+  config.ctrl_gpio_num = ENCODER_B;
+  config.pos_mode = PCNT_COUNT_INC;
+  config.neg_mode = PCNT_COUNT_DEC;
+  config.lctrl_mode = PCNT_MODE_KEEP;
+  config.hctrl_mode = PCNT_MODE_REVERSE;
+  config.counter_h_lim = PCNT_LIMIT;
+  config.counter_l_lim = -PCNT_LIMIT;
+  config.unit = PCNT_UNIT;
+  config.channel = PCNT_CHANNEL_0;
+  pcnt_unit_config(&config);
+
+  config.pulse_gpio_num = ENCODER_B;
+  config.ctrl_gpio_num = ENCODER_A;
+  config.lctrl_mode = PCNT_MODE_REVERSE;
+  config.hctrl_mode = PCNT_MODE_KEEP;
+  config.channel = PCNT_CHANNEL_1;
+  pcnt_unit_config(&config);
+
+  // Re-assert the pull-ups after pcnt_unit_config() has routed the pins
+  pinMode(ENCODER_A, INPUT_PULLUP);
+  pinMode(ENCODER_B, INPUT_PULLUP);
+
+  pcnt_set_filter_value(PCNT_UNIT, ENCODER_GLITCH_FILTER);
+  pcnt_filter_enable(PCNT_UNIT);
+  pcnt_counter_pause(PCNT_UNIT);
+  pcnt_counter_clear(PCNT_UNIT);
+  pcnt_counter_resume(PCNT_UNIT);
+  lastCount = 0;
 }
 
 bool EncoderController::handleControls()
 {
-  bool stateChanged = false;
-  
-  // Store initial state values to detect changes
-  uint16_t initialBpm = state.bpm;
-  uint8_t initialMultiplierIndex = state.currentMultiplierIndex;
-  MetronomeMode initialRhythmMode = state.rhythmMode;
-  
-  // Store initial channel states
-  struct ChannelState {
-    bool enabled;
-    uint8_t barLength;
-    uint16_t pattern;
-  };
-  
-  ChannelState initialChannelStates[MetronomeState::CHANNEL_COUNT];
-  for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
-    initialChannelStates[i].enabled = state.getChannel(i).isEnabled();
-    initialChannelStates[i].barLength = state.getChannel(i).getBarLength();
-    initialChannelStates[i].pattern = state.getChannel(i).getPattern();
-  }
-  
-  // Call the handler methods
-  handleEncoderButton();
-  handleStartButton();
-  handleStopButton();
-  handleRotaryEncoder();
-  
-  // Check if any state values have changed
-  if (initialBpm != state.bpm || 
-      initialMultiplierIndex != state.currentMultiplierIndex ||
-      initialRhythmMode != state.rhythmMode) {
-    stateChanged = true;
-  }
-  
-  // Check if any channel states have changed
-  for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
-    const MetronomeChannel& channel = state.getChannel(i);
-    if (initialChannelStates[i].enabled != channel.isEnabled() ||
-        initialChannelStates[i].barLength != channel.getBarLength() ||
-        initialChannelStates[i].pattern != channel.getPattern()) {
-      stateChanged = true;
-      break;
+  // Every setting change bumps the state's generation
+  uint32_t initialGeneration = state.getGeneration();
+
+  // Events were timestamped by the button interrupts; START and STOP
+  // presses have already been acted on by the control task
+  ButtonEvent event;
+  while (buttons.pop(event)) {
+    if (event.button == BUTTON_ENCODER) {
+      handleEncoderButton(event);
     }
   }
-  
-  return stateChanged;
+  checkFactoryReset();
+  handleRotaryEncoder();
+
+  return state.getGeneration() != initialGeneration;
 }
 
-void EncoderController::encoderISRHandler()
+int32_t EncoderController::readDetents()
 {
-  uint8_t a = digitalRead(ENCODER_A);
-  uint8_t b = digitalRead(ENCODER_B);
+  int16_t count = 0;
+  pcnt_get_counter_value(PCNT_UNIT, &count);
 
-  if (a != lastEncA)
+  // The counter restarts from 0 when it reaches either limit
+  int32_t delta = int32_t(count) - lastCount;
+  if (delta > PCNT_LIMIT / 2)
+    delta -= PCNT_LIMIT;
+  else if (delta < -PCNT_LIMIT / 2)
+    delta += PCNT_LIMIT;
+  lastCount = count;
+
+  pendingCounts += delta;
+  int32_t detents = pendingCounts / ENCODER_COUNTS_PER_DETENT;
+  pendingCounts -= detents * ENCODER_COUNTS_PER_DETENT;
+  return detents;
+}
+
+// Step multiplier from how fast the knob is turning: 1 up to the slow
+// rate, rising quadratically to ENCODER_ACCEL_MAX at the fast rate
+uint8_t EncoderController::accelerationFor(int32_t detents)
+{
+  uint32_t now = millis();
+  uint32_t elapsed = now - lastDetentMs;
+  lastDetentMs = now;
+
+  uint32_t rate = 0;
+  if (elapsed < 250)
   {
-    lastEncA = a;
-    encoderValue += (a != b) ? 1 : -1;
+    rate = elapsed ? uint32_t(abs(detents)) * 1000 / elapsed : ENCODER_ACCEL_FAST_DPS;
+    rate = (detentRate + rate) / 2;
   }
+  detentRate = rate;
+
+  if (rate <= ENCODER_ACCEL_SLOW_DPS)
+    return 1;
+  if (rate >= ENCODER_ACCEL_FAST_DPS)
+    return ENCODER_ACCEL_MAX;
+  uint32_t span = ENCODER_ACCEL_FAST_DPS - ENCODER_ACCEL_SLOW_DPS;
+  uint32_t x = rate - ENCODER_ACCEL_SLOW_DPS;
+  return 1 + (ENCODER_ACCEL_MAX - 1) * x * x / (span * span);
 }
 
-void EncoderController::handleEncoderButton()
+void EncoderController::handleEncoderButton(const ButtonEvent &event)
 {
-  bool encBtn = digitalRead(ENCODER_BTN);
-  uint32_t currentTime = millis();
-
-  // Button pressed
-  if (encBtn == LOW && lastEncBtn == HIGH) {
-    // Start timing for long press
-    buttonPressStartTime = currentTime;
+  if (event.type == BUTTON_PRESS) {
     buttonLongPressActive = false;
+    return;
   }
-  // Button released
-  else if (encBtn == HIGH && lastEncBtn == LOW) {
-    // If it wasn't a long press, handle as a normal click
-    if (!buttonLongPressActive) {
-      // Check if rhythm mode is selected
-      if (state.isRhythmModeSelected()) {
-        // Toggle between polymeter and polyrhythm modes
-        state.toggleRhythmMode();
-        lastEncBtn = encBtn;
+
+  // Released: if it wasn't a long press, handle as a normal click
+  if (event.type == BUTTON_RELEASE) {
+    bool wasLongPress = buttonLongPressActive;
+    buttonLongPressActive = false;
+    if (wasLongPress)
+      return;
+
+    // Check if rhythm mode is selected
+    if (state.isRhythmModeSelected()) {
+      // Toggle between polymeter and polyrhythm modes
+      state.toggleRhythmMode();
+      return;
+    }
+
+    // Check if a channel toggle is selected
+    for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
+      if (state.isToggleSelected(i)) {
+        // Toggle the channel on/off
+        state.getChannel(i).toggleEnabled();
         return;
       }
-      
-      // Check if a channel toggle is selected
-      for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
-        if (state.isToggleSelected(i)) {
-          // Toggle the channel on/off
-          state.getChannel(i).toggleEnabled();
-          lastEncBtn = encBtn;
-          return;
-        }
-      }
-      
-      // Otherwise toggle editing mode as before
-      state.isEditing = !state.isEditing;
     }
-    // Reset long press state on button release
-    buttonLongPressActive = false;
+
+    // Otherwise toggle editing mode as before
+    state.isEditing = !state.isEditing;
+    return;
   }
-  // Button still pressed, check for long press
-  else if (encBtn == LOW && !buttonLongPressActive) {
-    // Check if we've held the button long enough for a long press
-    if (currentTime - buttonPressStartTime > LONG_PRESS_DURATION_MS) {
-      buttonLongPressActive = true;
-      
-      // Handle long press for BPM reset
-      if (state.isBpmSelected()) {
-        // Reset BPM to default (120)
-        state.resetBpmToDefault();
-        
-        // Update the tempo
-        timing.setTempo(state.bpm);
-        
-        // Exit editing mode
-        state.isEditing = false;
-        
-        // Debug output
-        Serial.println("BPM reset to default");
-        lastEncBtn = encBtn;
-        return;
-      }
-      
-      // Handle long press for multiplier and pattern reset
-      if (state.isMultiplierSelected()) {
-        // Reset patterns and multiplier
-        state.resetPatternsAndMultiplier();
-        
-        // Exit editing mode
-        state.isEditing = false;
-        
-        // Debug output
-        Serial.println("Patterns and multiplier reset");
-        lastEncBtn = encBtn;
-        return;
-      }
-      
-      // Handle long press for channel bar length to reset the channel pattern
-      uint8_t channelIndex = state.getActiveChannel();
-      if (state.isLengthSelected(channelIndex)) {
-        // Reset the channel pattern to default (only first beat active)
-        state.resetChannelPattern(channelIndex);
-        
-        // Exit editing mode
-        state.isEditing = false;
-        
-        // Debug output
-        Serial.print("Channel ");
-        Serial.print(channelIndex + 1);
-        Serial.println(" pattern reset");
-        lastEncBtn = encBtn;
-        return;
-      }
-      
-      // Handle long press for Euclidean rhythm reset
-      if (state.isPatternSelected(channelIndex)) {
-        auto &channel = state.getChannel(channelIndex);
-        
-        // Count active beats in current pattern
-        uint16_t pattern = channel.getPattern();
-        uint8_t barLength = channel.getBarLength();
-        uint8_t activeBeats = 0;
-        
-        // Count active beats in the pattern
-        // First beat is always active
-        activeBeats = 1;
-        
-        // Count active beats in the rest of the pattern
-        for (uint8_t i = 0; i < barLength - 1; i++) {
-          if ((pattern >> i) & 1) {
-            activeBeats++;
-          }
-        }
-        
-        // Debug output
-        Serial.print("Active beats: ");
-        Serial.print(activeBeats);
-        Serial.print(" / Bar length: ");
-        Serial.println(barLength);
-        
-        // Generate Euclidean rhythm with the same number of active beats
-        channel.generateEuclidean(activeBeats);
-        
-        // Exit editing mode
-        state.isEditing = false;
+
+  // Held for LONG_PRESS_DURATION_MS
+  buttonLongPressActive = true;
+
+  // Handle long press for BPM reset
+  if (state.isBpmSelected()) {
+    // Reset BPM to default (120)
+    state.resetBpmToDefault();
+
+    // Update the tempo
+    timing.setTempo(state.bpm);
+
+    // Exit editing mode
+    state.isEditing = false;
+
+    // Debug output
+    Serial.println("BPM reset to default");
+    return;
+  }
+
+  // Handle long press for multiplier and pattern reset
+  if (state.isMultiplierSelected()) {
+    // Reset patterns and multiplier
+    state.resetPatternsAndMultiplier();
+
+    // Exit editing mode
+    state.isEditing = false;
+
+    // Debug output
+    Serial.println("Patterns and multiplier reset");
+    return;
+  }
+
+  // Handle long press for channel bar length to reset the channel pattern
+  uint8_t channelIndex = state.getActiveChannel();
+  if (state.isLengthSelected(channelIndex)) {
+    // Reset the channel pattern to default (only first beat active)
+    state.resetChannelPattern(channelIndex);
+
+    // Exit editing mode
+    state.isEditing = false;
+
+    // Debug output
+    Serial.print("Channel ");
+    Serial.print(channelIndex + 1);
+    Serial.println(" pattern reset");
+    return;
+  }
+
+  // Handle long press for Euclidean rhythm reset
+  if (state.isPatternSelected(channelIndex)) {
+    auto &channel = state.getChannel(channelIndex);
+
+    // Count active beats in current pattern
+    uint16_t pattern = channel.getPattern();
+    uint8_t barLength = channel.getBarLength();
+
+    // First beat is always active
+    uint8_t activeBeats = 1;
+
+    // Count active beats in the rest of the pattern
+    for (uint8_t i = 0; i < barLength - 1; i++) {
+      if ((pattern >> i) & 1) {
+        activeBeats++;
       }
     }
+
+    // Debug output
+    Serial.print("Active beats: ");
+    Serial.print(activeBeats);
+    Serial.print(" / Bar length: ");
+    Serial.println(barLength);
+
+    // Generate Euclidean rhythm with the same number of active beats
+    channel.generateEuclidean(activeBeats);
+
+    // Exit editing mode
+    state.isEditing = false;
   }
-  
-  lastEncBtn = encBtn;
 }
 
-void EncoderController::handleStartButton()
+void EncoderController::controlTask(void *arg)
 {
-  bool startBtn = digitalRead(BTN_START);
+  EncoderController *controller = static_cast<EncoderController *>(arg);
+  QueueHandle_t queue = controller->buttons.getTransportQueue();
+  ButtonEvent event;
 
-  if (startBtn != lastStartBtn && startBtn == LOW)
-  {
-    // If stopped, start playback
-    if (!state.isRunning && !state.isPaused) {
-      state.isRunning = true;
-      state.isPaused = false;
-      timing.start();
-    } 
-    // If running, pause playback
-    else if (state.isRunning && !state.isPaused) {
-      state.isRunning = false;
-      state.isPaused = true;
-      timing.pause();
-    }
-    // If paused, resume playback
-    else if (!state.isRunning && state.isPaused) {
-      state.isRunning = true;
-      state.isPaused = false;
-      timing.pause(); // pause() toggles between pause and resume
-    }
+  for (;;) {
+    if (xQueueReceive(queue, &event, portMAX_DELAY) != pdTRUE)
+      continue;
+
+    // Timing acts on it here, without waiting for the loop
+    TransportRequest request = event.button == BUTTON_STOP ? TRANSPORT_STOP : TRANSPORT_START_PAUSE;
+    controller->timing.requestTransport(request, event.us);
+    controller->timing.serviceTransport();
   }
-  lastStartBtn = startBtn;
 }
 
-void EncoderController::handleStopButton()
+void EncoderController::checkFactoryReset()
 {
-  bool stopBtn = digitalRead(BTN_STOP);
-  bool startBtn = digitalRead(BTN_START);
-  bool encoderBtn = digitalRead(ENCODER_BTN);
-
-  // Check for factory reset combination (all three buttons pressed at once)
-  if (stopBtn == LOW && startBtn == LOW && encoderBtn == LOW) {
-    if (!factoryResetDetected) {
-      factoryResetStartTime = millis();
-      factoryResetDetected = true;
-    } else if (millis() - factoryResetStartTime > FACTORY_RESET_DURATION_MS) {
-      // Reset all settings to factory defaults
-      state.resetBpmToDefault();
-      state.resetPatternsAndMultiplier();
-      
-      // Clear stored configuration
-      state.clearStorage();
-      
-      // Reset all state variables
-      state.isRunning = false;
-      state.isPaused = false;
-      state.currentBeat = 0;
-      state.globalTick = 0;
-      state.lastBeatTime = 0;
-      state.tickFraction = 0.0f;
-      state.lastPpqnTick = 0;
-      
-      // Reset all channels
-      for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
-        state.getChannel(i).resetBeat();
-      }
-      
-      // Update tempo
-      timing.setTempo(state.bpm);
-      
-      // Debug output
-      Serial.println("FACTORY RESET PERFORMED");
-      
-      // Wait for buttons to be released
-      while (digitalRead(BTN_STOP) == LOW || digitalRead(BTN_START) == LOW || digitalRead(ENCODER_BTN) == LOW) {
-        delay(10);
-      }
-      
-      factoryResetDetected = false;
-    }
-    
-    // Skip normal stop button processing
-    lastStopBtn = stopBtn;
+  // Factory reset combination: all three buttons held together
+  bool allHeld = buttons.isPressed(BUTTON_STOP) && buttons.isPressed(BUTTON_START) &&
+                 buttons.isPressed(BUTTON_ENCODER);
+  if (!allHeld) {
+    factoryResetDetected = false;
+    factoryResetLatched = false;
     return;
-  } else {
-    // If any button is released, cancel factory reset detection
-    if (factoryResetDetected) {
-      factoryResetDetected = false;
-    }
   }
+  if (factoryResetLatched)
+    return;
 
-  // Normal stop button processing
-  if (stopBtn != lastStopBtn && stopBtn == LOW)
-  {
-    // Reset all state variables
-    state.isRunning = false;
-    state.isPaused = false;
-    state.currentBeat = 0;
-    state.globalTick = 0;
-    state.lastBeatTime = 0;
-    state.tickFraction = 0.0f;
-    state.lastPpqnTick = 0;
-
-    // Stop the clock
-    timing.stop();
-
-    // Reset all channels
-    for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++)
-    {
-      state.getChannel(i).resetBeat();
-    }
-    
-    // Debug output
-    Serial.println("Metronome stopped and reset");
+  if (!factoryResetDetected) {
+    factoryResetStartTime = millis();
+    factoryResetDetected = true;
+    return;
   }
-  lastStopBtn = stopBtn;
+  if (millis() - factoryResetStartTime <= FACTORY_RESET_DURATION_MS)
+    return;
+
+  // Reset all settings to factory defaults
+  state.resetBpmToDefault();
+  state.resetPatternsAndMultiplier();
+
+  // Clear stored configuration
+  state.clearStorage();
+
+  // Reset all state variables
+  state.isRunning = false;
+  state.isPaused = false;
+  state.currentBeat = 0;
+  state.globalTick = 0;
+  state.lastBeatTime = 0;
+  state.tickFraction = 0.0f;
+  state.lastPpqnTick = 0;
+
+  // Reset all channels
+  for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
+    state.getChannel(i).resetBeat();
+  }
+
+  // Update tempo
+  timing.setTempo(state.bpm);
+
+  // Debug output
+  Serial.println("FACTORY RESET PERFORMED");
+
+  // Not again until the buttons have been released
+  factoryResetDetected = false;
+  factoryResetLatched = true;
 }
 
 void EncoderController::handleRotaryEncoder()
 {
-  static int32_t lastEncoderValue = encoderValue;
-  int32_t currentStep = encoderValue / 2;
-  int32_t lastStep = lastEncoderValue / 2;
-
-  if (currentStep == lastStep)
+  int32_t diff = readDetents();
+  if (diff == 0)
     return;
 
-  int32_t diff = currentStep - lastStep;
-  lastEncoderValue = encoderValue;
-
   if (state.isEditing)
   {
     if (state.isBpmSelected())
     {
-      state.bpm = constrain(state.bpm + diff, MIN_GLOBAL_BPM, MAX_GLOBAL_BPM);
+      // Fast turns cover the whole tempo range in one flick
+      diff *= accelerationFor(diff);
+      state.setBpm(constrain(int32_t(state.bpm) + diff, MIN_GLOBAL_BPM, MAX_GLOBAL_BPM));
       timing.setTempo(state.bpm);
     }
     else if (state.isMultiplierSelected())
@@ -1,12 +1,11 @@
 #pragma once
 #include <Arduino.h>
+#include <driver/pcnt.h>
 #include "MetronomeState.h"
 #include "Timing.h"
+#include "ButtonInput.h"
 #include "config.h"
 
-// Duration for long press detection
-#define LONG_PRESS_DURATION_MS 1000
-
 // Duration required to hold all buttons for factory reset
 #define FACTORY_RESET_DURATION_MS 3000
 
@@ -16,21 +15,24 @@ private:
   MetronomeState &state;
   Timing &timing;
 
+  // Pulse counter wraps to 0 at +/- this; polled often enough to unwrap
+  static const int16_t PCNT_LIMIT = 1000;
+  static constexpr pcnt_unit_t PCNT_UNIT = static_cast<pcnt_unit_t>(ENCODER_PCNT_UNIT);
+
   // Encoder state tracking
-  volatile int32_t encoderValue = 0;
-  volatile uint8_t lastEncA = HIGH;
+  int16_t lastCount = 0;
+  int32_t pendingCounts = 0;   // Edges short of a full detent
+  uint32_t lastDetentMs = 0;
+  uint32_t detentRate = 0;     // Smoothed detents per second
+
+  ButtonInput buttons;
 
-  // Button states
-  bool lastEncBtn = HIGH;
-  bool lastStartBtn = HIGH;
-  bool lastStopBtn = HIGH;
-  
   // Long press tracking
-  uint32_t buttonPressStartTime = 0;
   bool buttonLongPressActive = false;
   
   // Factory reset detection
   bool factoryResetDetected = false;
+  bool factoryResetLatched = false;   // Done; wait for the buttons to be let go
   uint32_t factoryResetStartTime = 0;
 
 public:
@@ -42,15 +44,16 @@ public:
 
   void resetEncoders();
 
-  // ISR-compatible method for the encoder
-  void encoderISRHandler();
-
 private:
-  void handleEncoderButton();
-  void handleStartButton();
-  void handleStopButton();
+  // START/STOP presses are posted to Timing from their own task, woken
+  // straight from the button ISR
+  static void controlTask(void *arg);
+
+  void handleEncoderButton(const ButtonEvent &event);
+  void checkFactoryReset();
   void handleRotaryEncoder();
+  int32_t readDetents();
+  uint8_t accelerationFor(int32_t detents);
 };
 
-// Declare a global pointer for the ISR to access
 extern EncoderController *globalEncoderController;
\ No newline at end of file
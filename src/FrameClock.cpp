@@ -0,0 +1,96 @@
+#include "FrameClock.h"
+
+FrameClock::FrameClock(uint16_t frameRateHz)
+{
+    setFrameRate(frameRateHz);
+}
+
+void FrameClock::setFrameRate(uint16_t frameRateHz)
+{
+    framePeriodUs = 1000000UL / (frameRateHz ? frameRateHz : 1);
+}
+
+void IRAM_ATTR FrameClock::publishBeat(uint32_t beat, uint32_t tickUs, uint32_t nominalPeriodUs)
+{
+    uint32_t period = nominalPeriodUs;
+
+    // Prefer the measured distance between consecutive beats so the phase
+    // follows the real clock (including an external leader's clock)
+    if (locked && beat == beatNumber + 1)
+    {
+        uint32_t measured = tickUs - beatStartUs;
+        if (measured > nominalPeriodUs / 2 && measured < nominalPeriodUs * 2)
+        {
+            period = measured;
+        }
+    }
+
+    publishSeq++;
+    beatNumber = beat;
+    beatStartUs = tickUs;
+    beatPeriodUs = period ? period : 1;
+    locked = true;
+    publishSeq++;
+}
+
+void FrameClock::reset()
+{
+    publishSeq++;
+    locked = false;
+    beatNumber = 0;
+    publishSeq++;
+}
+
+bool FrameClock::poll(uint32_t nowUs, FrameInfo &frame)
+{
+    if (!started)
+    {
+        started = true;
+        nextFrameUs = nowUs;
+    }
+
+    int32_t late = int32_t(nowUs - nextFrameUs);
+    if (late < 0)
+        return false;
+
+    // Under load, drop the frames we missed and realign to now
+    if (uint32_t(late) >= framePeriodUs)
+    {
+        skippedFrames += uint32_t(late) / framePeriodUs;
+        nextFrameUs = nowUs + framePeriodUs;
+    }
+    else
+    {
+        nextFrameUs += framePeriodUs;
+    }
+
+    // Take a consistent copy of the published beat
+    uint32_t seq;
+    do
+    {
+        seq = publishSeq;
+        frame.beatNumber = beatNumber;
+        frame.beatStartUs = beatStartUs;
+        frame.beatPeriodUs = beatPeriodUs;
+        frame.locked = locked;
+    } while ((seq & 1) || seq != publishSeq);
+
+    frame.frameIndex = frameIndex++;
+    frame.nowUs = nowUs;
+
+    uint32_t elapsed = nowUs - frame.beatStartUs;
+    if (!frame.locked)
+    {
+        frame.beatPhase = 0;
+    }
+    else if (elapsed >= frame.beatPeriodUs)
+    {
+        frame.beatPhase = 0xFFFF; // Hold at the end until the next beat lands
+    }
+    else
+    {
+        frame.beatPhase = uint16_t((uint64_t(elapsed) << 16) / frame.beatPeriodUs);
+    }
+
+    return true;
+}
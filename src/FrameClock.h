@@ -0,0 +1,78 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Snapshot of the beat clock handed to every renderer for one frame.
+// All visuals derive their timing from the same beat timestamp, so the
+// display and the LED strip flash together with the click.
+struct FrameInfo
+{
+    uint32_t frameIndex;   // Frames rendered since boot
+    uint32_t nowUs;        // Time this frame represents
+    uint32_t beatNumber;   // Effective beat (quarter note x multiplier) count
+    uint32_t beatStartUs;  // Timestamp of the tick that started the beat
+    uint32_t beatPeriodUs; // Length of the current beat
+    uint16_t beatPhase;    // Position inside the beat, Q16 (0 .. 65535)
+    bool locked;           // At least one beat has been published since reset
+
+    float phase() const { return beatPhase / 65536.0f; }
+
+    // True while the beat phase is inside the first `fraction` of the beat
+    bool isPhaseBelow(float fraction) const
+    {
+        return locked && beatPhase < uint32_t(fraction * 65536.0f);
+    }
+
+    // True while less than `fraction` of a beat has passed since `eventUs`
+    bool isWithinBeatFraction(uint32_t eventUs, float fraction) const
+    {
+        return locked && (nowUs - eventUs) < uint32_t(beatPeriodUs * fraction);
+    }
+
+    // Beat phase (Q16) elapsed since `eventUs`, saturating at one beat
+    uint16_t phaseSince(uint32_t eventUs) const
+    {
+        uint32_t elapsed = nowUs - eventUs;
+        if (!locked || elapsed >= beatPeriodUs)
+            return 0xFFFF;
+        return uint16_t((uint64_t(elapsed) << 16) / beatPeriodUs);
+    }
+};
+
+// Frame clock driven by the published tick phase.
+// The timing path publishes each beat boundary with the timestamp of the
+// tick that produced it; the main loop polls for frames at a fixed rate.
+// Frames that could not be rendered in time are skipped, never queued.
+class FrameClock
+{
+private:
+    // Written from the clock callback, read from the main loop.
+    // The sequence counter is odd while a publish is in progress.
+    volatile uint32_t publishSeq = 0;
+    volatile uint32_t beatNumber = 0;
+    volatile uint32_t beatStartUs = 0;
+    volatile uint32_t beatPeriodUs = 500000;
+    volatile bool locked = false;
+
+    uint32_t framePeriodUs;
+    uint32_t nextFrameUs = 0;
+    uint32_t frameIndex = 0;
+    uint32_t skippedFrames = 0;
+    bool started = false;
+
+public:
+    explicit FrameClock(uint16_t frameRateHz = FRAME_RATE_HZ);
+
+    // Called from the tick path on every beat boundary
+    void publishBeat(uint32_t beat, uint32_t tickUs, uint32_t nominalPeriodUs);
+
+    // Forget the beat phase (transport stopped)
+    void reset();
+
+    // Returns true and fills `frame` when a new frame is due
+    bool poll(uint32_t nowUs, FrameInfo &frame);
+
+    void setFrameRate(uint16_t frameRateHz);
+    uint32_t getFrameCount() const { return frameIndex; }
+    uint32_t getSkippedFrames() const { return skippedFrames; }
+};
@@ -0,0 +1,139 @@
+#pragma once
+#include <FastLED.h>
+#include <array>
+#include "FrameClock.h"
+#include "config.h"
+
+// Fixed-point colour pipeline for the LED visualisers.
+// Palettes are authored in perceptual (pre-gamma) space. Once per frame
+// every (palette, role) pair is faded by beat phase and passed through
+// the gamma table, so drawing a pixel is a single table lookup.
+
+enum PixelRole : uint8_t
+{
+  ROLE_OFF,
+  ROLE_BACKGROUND,     // Step that is neither active nor current
+  ROLE_ACTIVE,         // Step that will sound
+  ROLE_CURRENT,        // Playhead on a silent step
+  ROLE_CURRENT_ACTIVE, // Playhead on a sounding step
+  ROLE_FLASH,          // Beat blinker, decays from the triggering beat
+  ROLE_COUNT
+};
+
+// Palette 0 is the global beat, palettes 1.. are the channels
+static const uint8_t PALETTE_GLOBAL = 0;
+static const uint8_t PALETTE_COUNT = FIXED_CHANNEL_COUNT + 1;
+
+struct ChannelPalette
+{
+  CRGB colors[ROLE_COUNT];
+};
+
+// Gamma 2.2 as x^2 * x^0.2; the fifth root is solved with Newton's method
+// so the whole table is built by the compiler.
+constexpr double fifthRoot(double x)
+{
+  if (x <= 0.0)
+    return 0.0;
+  double y = 1.0;
+  for (int i = 0; i < 40; i++)
+  {
+    y = (4.0 * y + x / (y * y * y * y)) / 5.0;
+  }
+  return y;
+}
+
+constexpr std::array<uint8_t, 256> makeGammaTable()
+{
+  std::array<uint8_t, 256> table{};
+  for (int i = 0; i < 256; i++)
+  {
+    double x = i / 255.0;
+    table[i] = uint8_t(255.0 * x * x * fifthRoot(x) + 0.5);
+  }
+  return table;
+}
+
+// Exponential decay over one beat, ~10% left a quarter of the way in
+static const uint8_t FADE_STEPS = 64;
+
+constexpr std::array<uint8_t, FADE_STEPS> makeDecayCurve()
+{
+  std::array<uint8_t, FADE_STEPS> curve{};
+  uint32_t level = 255u << 8; // Q8 accumulator
+  for (int i = 0; i < FADE_STEPS; i++)
+  {
+    curve[i] = uint8_t(level >> 8);
+    level = (level * 222u) >> 8;
+  }
+  curve[FADE_STEPS - 1] = 0;
+  return curve;
+}
+
+constexpr std::array<uint8_t, 256> GAMMA_TABLE = makeGammaTable();
+constexpr std::array<uint8_t, FADE_STEPS> BEAT_DECAY = makeDecayCurve();
+
+// Level the playhead settles at after its beat-start glow (Q8)
+static const uint8_t CURRENT_REST_LEVEL = 120;
+
+constexpr ChannelPalette DEFAULT_PALETTES[PALETTE_COUNT] = {
+    // Global beat (ACTIVE is the bar progress fill)
+    {{CRGB(0, 0, 0), CRGB(0, 0, 0), CRGB(90, 90, 90), CRGB(160, 160, 160), CRGB(160, 160, 160), CRGB(255, 255, 255)}},
+    // Channel 1 - blue
+    {{CRGB(0, 0, 0), CRGB(0, 30, 46), CRGB(0, 89, 136), CRGB(0, 110, 170), CRGB(160, 160, 160), CRGB(0, 89, 136)}},
+    // Channel 2 - amber
+    {{CRGB(0, 0, 0), CRGB(46, 30, 0), CRGB(136, 89, 0), CRGB(170, 110, 0), CRGB(160, 160, 160), CRGB(136, 89, 0)}},
+};
+
+class ColorPipeline
+{
+private:
+  ChannelPalette palettes[PALETTE_COUNT];
+  CRGB roleColors[PALETTE_COUNT][ROLE_COUNT];
+
+  static uint8_t fadeAt(uint16_t phase) { return BEAT_DECAY[phase >> 10]; }
+
+  static CRGB scaleAndGamma(const CRGB &color, uint8_t level)
+  {
+    return CRGB(GAMMA_TABLE[(color.r * (level + 1)) >> 8],
+                GAMMA_TABLE[(color.g * (level + 1)) >> 8],
+                GAMMA_TABLE[(color.b * (level + 1)) >> 8]);
+  }
+
+public:
+  ColorPipeline()
+  {
+    for (uint8_t p = 0; p < PALETTE_COUNT; p++)
+    {
+      palettes[p] = DEFAULT_PALETTES[p];
+    }
+  }
+
+  void setPalette(uint8_t index, const ChannelPalette &palette)
+  {
+    if (index < PALETTE_COUNT)
+      palettes[index] = palette;
+  }
+
+  // Resolve every role colour for this frame. `flashPhase[p]` is the
+  // Q16 beat phase since palette p's blinker last fired (0xFFFF = idle).
+  void prepare(const FrameInfo &frame, const uint16_t flashPhase[PALETTE_COUNT])
+  {
+    uint8_t glow = fadeAt(frame.beatPhase);
+    uint8_t currentLevel = CURRENT_REST_LEVEL + (((255 - CURRENT_REST_LEVEL) * (glow + 1)) >> 8);
+
+    for (uint8_t p = 0; p < PALETTE_COUNT; p++)
+    {
+      const CRGB *colors = palettes[p].colors;
+      roleColors[p][ROLE_OFF] = CRGB(0, 0, 0);
+      roleColors[p][ROLE_BACKGROUND] = scaleAndGamma(colors[ROLE_BACKGROUND], 255);
+      roleColors[p][ROLE_ACTIVE] = scaleAndGamma(colors[ROLE_ACTIVE], 255);
+      roleColors[p][ROLE_CURRENT] = scaleAndGamma(colors[ROLE_CURRENT], currentLevel);
+      roleColors[p][ROLE_CURRENT_ACTIVE] = scaleAndGamma(colors[ROLE_CURRENT_ACTIVE], currentLevel);
+      roleColors[p][ROLE_FLASH] = scaleAndGamma(colors[ROLE_FLASH], fadeAt(flashPhase[p]));
+    }
+  }
+
+  const CRGB &color(uint8_t palette, PixelRole role) const { return roleColors[palette][role]; }
+  const CRGB *colors(uint8_t palette) const { return roleColors[palette]; }
+};
@@ -1,60 +1,89 @@
 #include "LEDController.h"
 
-#define LED_PIN 27
-#define NUM_LEDS 33
 #define LED_TYPE WS2812B
 #define COLOR_ORDER GRB
 
-LEDController::LEDController() : leds(nullptr), numLeds(NUM_LEDS)
+LEDController::LEDController()
 {
-  globalFlash = {0, false};
+  setMaxRefreshRate(LED_MAX_REFRESH_HZ);
   for (int i = 0; i < FIXED_CHANNEL_COUNT; i++)
   {
-    channelFlash[i] = {0, false};
+    channelFlash[i].startUs = 0;
+    channelFlash[i].isFlashing = false;
   }
 }
 
 LEDController::~LEDController()
 {
-  if (leds)
+  for (uint8_t i = 0; i < stripCount; i++)
   {
-    delete[] leds;
+    delete[] strips[i].front;
+    delete[] strips[i].back;
+#if LED_OUTPUT_RMT
+    delete strips[i].output;
+#endif
   }
 }
 
-bool LEDController::isFlashActive(const FlashState &flash) const
+void LEDController::prepareColors(const FrameInfo &frame)
 {
-  return flash.isFlashing && (millis() - flash.startTime) < LED_BEAT_DURATION_MS;
+  // Blinkers fade from the tick that fired them; the global one from the beat itself
+  uint16_t flashPhase[PALETTE_COUNT];
+  flashPhase[PALETTE_GLOBAL] = frame.locked ? frame.beatPhase : 0xFFFF;
+  for (uint8_t i = 0; i < FIXED_CHANNEL_COUNT; i++)
+  {
+    flashPhase[i + 1] = channelFlash[i].isFlashing ? frame.phaseSince(channelFlash[i].startUs) : 0xFFFF;
+  }
+  pipeline.prepare(frame, flashPhase);
 }
 
-void LEDController::startFlash(FlashState &flash)
+CRGB LEDController::blinkerColor(uint8_t palette, bool enabled, const MetronomeState &state) const
 {
-  flash.startTime = millis();
-  flash.isFlashing = true;
+  bool isActive = state.isRunning && !state.isPaused;
+  return isActive && enabled ? pipeline.color(palette, ROLE_FLASH) : CRGB::Black;
 }
 
 void LEDController::init()
 {
-  leds = new CRGB[NUM_LEDS];
-  FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS)
+#if LED_LAYOUT_STAGE
+  layout.loadStage();
+#else
+  layout.loadCompact();
+#endif
+
+  stripCount = layout.getOutputCount();
+  for (uint8_t i = 0; i < stripCount; i++)
+  {
+    const LEDOutputConfig &config = layout.getOutput(i);
+    Strip &strip = strips[i];
+    strip.numLeds = config.numLeds;
+    strip.front = new CRGB[config.numLeds];
+    strip.back = new CRGB[config.numLeds];
+#if LED_OUTPUT_RMT
+    // Each strip gets its own RMT channel so all of them stream in parallel
+    strip.output = new RmtLedOutput(config.pin, config.numLeds, static_cast<rmt_channel_t>(i));
+    strip.output->begin();
+    strip.output->setBrightness(GLOBAL_BRIGHTNESS);
+#endif
+  }
+
+#if !LED_OUTPUT_RMT
+  FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(strips[0].front, strips[0].numLeds)
       .setCorrection(TypicalLEDStrip);
   FastLED.setBrightness(GLOBAL_BRIGHTNESS);
+#endif
   clear();
   startupAnimation();
 }
 
-void LEDController::drawPattern(const MetronomeChannel &channel, uint8_t startLed,
-                                uint8_t size, const MetronomeState &state,
-                                const CRGB &baseColor)
+uint8_t LEDController::buildPatternCells(const MetronomeChannel &channel, const MetronomeState &state)
 {
   if (!channel.isEnabled())
   {
-    fill_solid(leds + startLed, size, CRGB::Black);
-    return;
+    cells[0] = CRGB::Black;
+    return 1;
   }
 
-  fill_solid(leds + startLed, size, CRGB::Black);
-
   uint8_t currentBeat;
   if (channel.getId() == 1 && state.isPolyrhythm())
   {
@@ -68,126 +97,347 @@ void LEDController::drawPattern(const MetronomeChannel &channel, uint8_t startLe
     currentBeat = channel.getCurrentBeat();
   }
 
+  // One lookup per step into this frame's resolved colours
+  const CRGB *colors = pipeline.colors(channel.getId() + 1);
+  uint16_t fullPattern = (channel.getPattern() << 1) | 1; // First beat always on
   uint8_t patternLength = channel.getBarLength();
-  for (uint8_t i = 0; i < patternLength && i < size; i++)
-  {
-    bool isActive = channel.getPatternBit(i);
-    bool isCurrent = (i == currentBeat);
-
-    CRGB color = CRGB::Black;
-    if (isCurrent && isActive)
-      color = CRGB(32, 32, 32); // Dimmed white
-    else if (isActive)
-      color = baseColor;
-    else if (isCurrent)
-      color = CRGB(baseColor).nscale8(32); // More subtle highlight
+  for (uint8_t i = 0; i < patternLength; i++)
+  {
+    uint8_t role = ((fullPattern >> i) & 1) ? ROLE_ACTIVE : ROLE_BACKGROUND;
+    if (i == currentBeat)
+      role += ROLE_CURRENT - ROLE_BACKGROUND;
+    cells[i] = colors[role];
+  }
+  return patternLength;
+}
+
+void LEDController::buildCompositeHits(uint8_t count, const MetronomeState &state)
+{
+  // Bit per channel that sounds inside each cell. Work depends on the
+  // cycle length, never on how many pixels the region spans.
+  uint32_t totalBeats = state.getTotalBeats();
+  memset(compositeHits, 0, sizeof(compositeHits));
+  for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++)
+  {
+    const MetronomeChannel &channel = state.getChannel(ch);
+    if (!channel.isEnabled())
+      continue;
+
+    uint8_t barLength = channel.getBarLength();
+    uint16_t fullPattern = (channel.getPattern() << 1) | 1;
+    if (state.isPolyrhythm() && ch > 0)
+    {
+      // Polyrhythm: the channel's steps are spread evenly over channel 1's bar
+      for (uint8_t step = 0; step < barLength; step++)
+      {
+        if ((fullPattern >> step) & 1)
+          compositeHits[uint32_t(step) * count / barLength] |= 1 << ch;
+      }
+    }
     else
-      color = CRGB(baseColor).nscale8(8); // Very dim background
+    {
+      for (uint32_t beat = 0; beat < totalBeats; beat++)
+      {
+        if ((fullPattern >> (beat % barLength)) & 1)
+          compositeHits[beat * count / totalBeats] |= 1 << ch;
+      }
+    }
+  }
+  compositeCount = count;
+  compositeStale = false;
+}
 
-    leds[startLed + i] = color;
+uint8_t LEDController::buildCompositeCells(const LEDRegion &region, const MetronomeState &state)
+{
+  uint32_t totalBeats = state.getTotalBeats();
+  uint8_t count = min<uint32_t>(min<uint32_t>(totalBeats, MAX_CELLS), region.length);
+  if (count == 0)
+    return 0;
+
+  if (compositeStale || count != compositeCount)
+    buildCompositeHits(count, state);
+  const uint8_t *hits = compositeHits;
+
+  bool isActive = state.isRunning || state.isPaused;
+  uint8_t current = isActive ? uint8_t((state.globalTick % totalBeats) * count / totalBeats) : 0xFF;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    // Single channel hits use that channel's colour, coincident hits the global one
+    uint8_t palette = hits[i] == 1 ? 1 : hits[i] == 2 ? 2 : PALETTE_GLOBAL;
+    PixelRole role = hits[i] ? ROLE_ACTIVE : ROLE_OFF;
+    if (i == current)
+      role = hits[i] ? ROLE_CURRENT_ACTIVE : ROLE_CURRENT;
+    cells[i] = pipeline.color(palette, role);
   }
+  return count;
 }
 
-uint8_t LEDController::calculatePatternSpace(uint8_t barLength) const
+uint8_t LEDController::buildProgressCells(const LEDRegion &region, const MetronomeState &state)
 {
-  return min(barLength, MAX_PATTERN_SIZE);
+  uint8_t count = min<uint16_t>(region.length, MAX_CELLS);
+  uint8_t filled = uint8_t(state.getProgress() * count);
+  const CRGB &fill = pipeline.color(PALETTE_GLOBAL, ROLE_ACTIVE);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    cells[i] = i < filled ? fill : CRGB(CRGB::Black);
+  }
+  return count;
 }
 
-void LEDController::updateSection(StripSection section, const MetronomeState &state)
+uint8_t LEDController::buildCells(const LEDRegion &region, const MetronomeState &state)
 {
-  uint8_t currentPos = 0;
-  bool isActive = state.isRunning && !state.isPaused;
+  switch (region.type)
+  {
+  case REGION_BEAT:
+    cells[0] = blinkerColor(PALETTE_GLOBAL, true, state);
+    return 1;
 
-  switch (section)
-  {
-  case BPM_START:
-    leds[0] = isActive && isFlashActive(globalFlash) ? CRGB::White : CRGB::Black;
-    break;
-
-  case CH1_BLINK:
-    leds[1] = isActive && state.getChannel(0).isEnabled() &&
-                      isFlashActive(channelFlash[0])
-                  ? CH1_COLOR
-                  : CRGB::Black;
-    break;
-
-  case CH1_PATTERN:
-    drawPattern(state.getChannel(0), 2, calculatePatternSpace(state.getChannel(0).getBarLength()),
-                state, CH1_COLOR);
-    break;
-
-  case BPM_MID:
-    currentPos = 2 + calculatePatternSpace(state.getChannel(0).getBarLength());
-    leds[currentPos] = isActive && isFlashActive(globalFlash) ? CRGB::White : CRGB::Black;
-    break;
-
-  case CH2_BLINK:
-    currentPos = 3 + calculatePatternSpace(state.getChannel(0).getBarLength());
-    leds[currentPos] = isActive && state.getChannel(1).isEnabled() &&
-                               isFlashActive(channelFlash[1])
-                           ? CH2_COLOR
-                           : CRGB::Black;
-    break;
-
-  case CH2_PATTERN:
-    currentPos = 4 + calculatePatternSpace(state.getChannel(0).getBarLength());
-    drawPattern(state.getChannel(1), currentPos, MAX_PATTERN_SIZE, state, CH2_COLOR);
-    break;
-
-  case BPM_END:
-    currentPos = 4 + calculatePatternSpace(state.getChannel(0).getBarLength()) +
-                 calculatePatternSpace(state.getChannel(1).getBarLength());
-    if (currentPos < NUM_LEDS)
-    {
-      leds[currentPos] = isActive && isFlashActive(globalFlash) ? CRGB::White : CRGB::Black;
-    }
-    break;
+  case REGION_CHANNEL_BLINK:
+    cells[0] = blinkerColor(region.channel + 1, state.getChannel(region.channel).isEnabled(), state);
+    return 1;
+
+  case REGION_CHANNEL_PATTERN:
+    return buildPatternCells(state.getChannel(region.channel), state);
+
+  case REGION_COMPOSITE:
+    return buildCompositeCells(region, state);
+
+  case REGION_BAR_PROGRESS:
+    return buildProgressCells(region, state);
   }
+  return 0;
 }
 
-void LEDController::update(const MetronomeState &state)
+void LEDController::expandCells(const LEDRegion &region, uint8_t count)
 {
-  for (int i = 0; i < SECTION_COUNT; i++)
+  CRGB *pixels = strips[region.output].back + region.start;
+  uint16_t length = region.length;
+
+  fill_solid(pixels, length, CRGB::Black);
+  for (uint8_t c = 0; c < count; c++)
   {
-    updateSection(static_cast<StripSection>(i), state);
+    // Cell c covers pixels [a, b); with fewer pixels than cells some cells share a pixel
+    uint16_t a = uint32_t(c) * length / count;
+    uint16_t b = uint32_t(c + 1) * length / count;
+    if (b == a)
+      b = a + 1;
+    if (b > length)
+      continue;
+    fill_solid(region.reversed ? pixels + length - b : pixels + a, b - a, cells[c]);
   }
-  FastLED.show();
 }
 
-void LEDController::onGlobalBeat()
+void LEDController::renderRegion(uint8_t index, const MetronomeState &state)
 {
-  startFlash(globalFlash);
+  const LEDRegion &region = layout.getRegion(index);
+  uint8_t count = buildCells(region, state);
+
+  // Only touch the pixels when the logical cells changed (FNV-1a over the cells)
+  uint32_t signature = 2166136261u ^ count;
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(cells);
+  for (uint16_t i = 0; i < count * sizeof(CRGB); i++)
+  {
+    signature = (signature ^ bytes[i]) * 16777619u;
+  }
+  if (signature == regionSignature[index])
+    return;
+
+  regionSignature[index] = signature;
+  expandCells(region, count);
 }
 
-void LEDController::onChannelBeat(uint8_t channel)
+void LEDController::clearBackBuffers()
+{
+  for (uint8_t i = 0; i < stripCount; i++)
+  {
+    fill_solid(strips[i].back, strips[i].numLeds, CRGB::Black);
+  }
+  memset(regionSignature, 0, sizeof(regionSignature));
+  nextRegion = 0;
+}
+
+void LEDController::update(const MetronomeState &state, const FrameInfo &frame)
+{
+  uint32_t startUs = micros();
+
+#if LED_OUTPUT_RMT
+  // Start frames that were queued while the previous ones were streaming
+  for (uint8_t i = 0; i < stripCount; i++)
+  {
+    strips[i].output->service();
+  }
+#endif
+
+  if (startupStep <= STARTUP_STEPS)
+  {
+    if (!state.isRunning)
+    {
+      renderStartupStep(frame.nowUs);
+      return;
+    }
+    // Playback started mid-chase
+    startupStep = STARTUP_STEPS + 1;
+    clear();
+  }
+
+  // Bar lengths, patterns and the rhythm mode only move with their
+  // generations; between changes the layout and composite hits stand
+  if (layoutChanges.poll(state, changeBit(CHANGE_PATTERN) | changeBit(CHANGE_MODE)) || !layoutPolled)
+  {
+    layoutPolled = true;
+    compositeStale = true;
+    if (layout.refresh(state))
+    {
+      clearBackBuffers();
+    }
+  }
+
+  prepareColors(frame);
+
+  // Render regions round-robin until the frame budget runs out; whatever
+  // is left goes first on the next frame
+  uint8_t regionCount = layout.getRegionCount();
+  uint8_t rendered = 0;
+  while (rendered < regionCount)
+  {
+    if (rendered > 0 && micros() - startUs > LED_FRAME_BUDGET_US)
+      break;
+    renderRegion((nextRegion + rendered) % regionCount, state);
+    rendered++;
+  }
+  if (regionCount)
+  {
+    telemetry.deferredRegions += regionCount - rendered;
+    nextRegion = (nextRegion + rendered) % regionCount;
+  }
+  telemetry.lastRenderUs = micros() - startUs;
+
+  commitFrame(frame.nowUs);
+}
+
+void LEDController::commitFrame(uint32_t nowUs)
+{
+  // Roll the shows-per-second window
+  if (nowUs - telemetryWindowStartUs >= 1000000UL)
+  {
+    telemetry.showsPerSecond = showsInWindow;
+    showsInWindow = 0;
+    telemetryWindowStartUs = nowUs;
+  }
+
+  // Identical frames never reach the strips
+  bool changed[LED_MAX_OUTPUTS] = {};
+  bool anyChanged = false;
+  for (uint8_t i = 0; i < stripCount; i++)
+  {
+    changed[i] = memcmp(strips[i].back, strips[i].front, strips[i].numLeds * sizeof(CRGB)) != 0;
+    anyChanged |= changed[i];
+  }
+  if (!anyChanged)
+  {
+    telemetry.unchangedFrames++;
+    return;
+  }
+
+  // Changed frames wait for the refresh cap; the next update redraws them
+  if (nowUs - lastShowUs < minShowIntervalUs)
+  {
+    telemetry.rateLimitedFrames++;
+    return;
+  }
+
+  uint32_t pushStartUs = micros();
+  for (uint8_t i = 0; i < stripCount; i++)
+  {
+    if (changed[i])
+    {
+      memcpy(strips[i].front, strips[i].back, strips[i].numLeds * sizeof(CRGB));
+      pushStrip(i);
+    }
+  }
+  telemetry.lastFrameCpuUs = micros() - pushStartUs;
+  if (telemetry.lastFrameCpuUs > telemetry.maxFrameCpuUs)
+  {
+    telemetry.maxFrameCpuUs = telemetry.lastFrameCpuUs;
+  }
+
+  lastShowUs = nowUs;
+  showsInWindow++;
+  telemetry.totalShows++;
+}
+
+void IRAM_ATTR LEDController::onChannelBeat(uint8_t channel, uint32_t tickUs)
 {
   if (channel < FIXED_CHANNEL_COUNT)
   {
-    startFlash(channelFlash[channel]);
+    channelFlash[channel].startUs = tickUs;
+    channelFlash[channel].isFlashing = true;
   }
 }
 
-void LEDController::clear()
+void LEDController::pushStrip(uint8_t index)
 {
-  FastLED.clear();
+#if LED_OUTPUT_RMT
+  // Encodes into the idle buffer and returns while the strip streams
+  strips[index].output->show(strips[index].front);
+#else
   FastLED.show();
+#endif
+}
+
+void LEDController::clear()
+{
+  for (uint8_t i = 0; i < stripCount; i++)
+  {
+    fill_solid(strips[i].front, strips[i].numLeds, CRGB::Black);
+    pushStrip(i);
+  }
+  clearBackBuffers();
 }
 
 void LEDController::setBrightness(uint8_t brightness)
 {
+#if LED_OUTPUT_RMT
+  for (uint8_t i = 0; i < stripCount; i++)
+  {
+    strips[i].output->setBrightness(brightness);
+  }
+#else
   FastLED.setBrightness(brightness);
+#endif
+}
+
+void LEDController::setMaxRefreshRate(uint16_t hz)
+{
+  minShowIntervalUs = 1000000UL / (hz ? hz : 1);
 }
 
 void LEDController::startupAnimation()
 {
-  for (int i = 0; i < NUM_LEDS; i++)
+  startupStep = 0;
+  startupStepUs = micros() - STARTUP_STEP_US;
+}
+
+void LEDController::renderStartupStep(uint32_t nowUs)
+{
+  if (nowUs - startupStepUs < STARTUP_STEP_US)
+    return;
+  startupStepUs = nowUs;
+
+  if (startupStep == STARTUP_STEPS)
   {
-    leds[i] = CRGB(0, 32, 0); // Dimmed green
-    FastLED.show();
-    delay(20);
-    leds[i] = CRGB::Black;
-    FastLED.show();
+    startupStep++;
+    clear();
+    return;
   }
-  FastLED.clear();
-  FastLED.show();
+
+  // The chase takes the same number of steps whatever the strip lengths
+  for (uint8_t i = 0; i < stripCount; i++)
+  {
+    fill_solid(strips[i].front, strips[i].numLeds, CRGB::Black);
+    uint16_t pixel = uint32_t(startupStep) * strips[i].numLeds / STARTUP_STEPS;
+    strips[i].front[pixel] = CRGB(0, 32, 0); // Dimmed green
+    pushStrip(i);
+  }
+  startupStep++;
 }
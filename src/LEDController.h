@@ -2,57 +2,114 @@
 
 #include <FastLED.h>
 #include "MetronomeState.h"
+#include "FrameClock.h"
+#include "LEDColor.h"
+#include "LEDLayout.h"
 #include "config.h"
+#if LED_OUTPUT_RMT
+#include "RmtLedOutput.h"
+#endif
 
-enum StripSection
+#if LED_LAYOUT_STAGE && !LED_OUTPUT_RMT
+#error "The multi-strip stage layout needs the RMT LED output (LED_OUTPUT_RMT 1)"
+#endif
+
+// Counters for the strip output, refreshed once per second
+struct LEDTelemetry
 {
-  BPM_START,
-  CH1_BLINK,
-  CH1_PATTERN,
-  BPM_MID,
-  CH2_BLINK,
-  CH2_PATTERN,
-  BPM_END,
-  SECTION_COUNT
+  uint16_t showsPerSecond;    // Frames pushed during the last full second
+  uint32_t totalShows;        // Frames pushed since boot
+  uint32_t unchangedFrames;   // Frames skipped because nothing changed
+  uint32_t rateLimitedFrames; // Frames skipped by the refresh cap
+  uint32_t lastFrameCpuUs;    // Calling-core time spent pushing the last frame
+  uint32_t maxFrameCpuUs;     // Worst push time since boot
+  uint32_t lastRenderUs;      // Time spent rendering regions in the last frame
+  uint32_t deferredRegions;   // Regions pushed to a later frame by the budget
 };
 
 class LEDController
 {
 private:
-  CRGB *leds;
-  const uint8_t numLeds;
-  static const uint8_t MAX_PATTERN_SIZE = 16;
-  static const uint8_t BLINKER_SIZE = 1;
+  static const uint8_t MAX_CELLS = 64; // Logical cells per region before pixel expansion
   static const uint8_t GLOBAL_BRIGHTNESS = 32; // ~12.5% of max power
+  static const uint8_t STARTUP_STEPS = 33;
+  static const uint32_t STARTUP_STEP_US = 20000;
+
+  // One physical strip: last pushed frame, frame being composed, output
+  struct Strip
+  {
+    CRGB *front;
+    CRGB *back;
+    uint16_t numLeds;
+#if LED_OUTPUT_RMT
+    RmtLedOutput *output;
+#endif
+  };
+
+  Strip strips[LED_MAX_OUTPUTS] = {};
+  uint8_t stripCount = 0;
+  LEDLayout layout;
+
+  // Region rendering state
+  CRGB cells[MAX_CELLS];
+  uint32_t regionSignature[LED_MAX_REGIONS] = {};
+  uint8_t nextRegion = 0;
+
+  // Channel bits sounding in each composite cell, rebuilt only when the
+  // pattern or rhythm mode generations move (or the cell count differs)
+  ChangeTracker layoutChanges;
+  bool layoutPolled = false;
+  uint8_t compositeHits[MAX_CELLS] = {};
+  uint8_t compositeCount = 0;
+  bool compositeStale = true;
+
+  uint32_t minShowIntervalUs;
+  uint32_t lastShowUs = 0;
+  uint32_t telemetryWindowStartUs = 0;
+  uint16_t showsInWindow = 0;
+  LEDTelemetry telemetry = {};
 
   struct FlashState
   {
-    uint32_t startTime;
-    bool isFlashing;
+    volatile uint32_t startUs; // Timestamp of the tick that triggered the flash
+    volatile bool isFlashing;
   };
 
-  FlashState globalFlash;
   FlashState channelFlash[FIXED_CHANNEL_COUNT];
 
-  static constexpr CRGB CH1_COLOR = CRGB(0, 25, 64); // Reduced from (0, 100, 255)
-  static constexpr CRGB CH2_COLOR = CRGB(64, 25, 0); // Reduced from (255, 100, 0)
+  ColorPipeline pipeline;
+
+  void prepareColors(const FrameInfo &frame);
+  CRGB blinkerColor(uint8_t palette, bool enabled, const MetronomeState &state) const;
+  uint8_t buildPatternCells(const MetronomeChannel &channel, const MetronomeState &state);
+  void buildCompositeHits(uint8_t count, const MetronomeState &state);
+  uint8_t buildCompositeCells(const LEDRegion &region, const MetronomeState &state);
+  uint8_t buildProgressCells(const LEDRegion &region, const MetronomeState &state);
+  uint8_t buildCells(const LEDRegion &region, const MetronomeState &state);
+  void expandCells(const LEDRegion &region, uint8_t count);
+  void renderRegion(uint8_t index, const MetronomeState &state);
+  void clearBackBuffers();
+  void commitFrame(uint32_t nowUs);
+  void pushStrip(uint8_t index);
+  void renderStartupStep(uint32_t nowUs);
 
-  bool isFlashActive(const FlashState &flash) const;
-  void startFlash(FlashState &flash);
-  void drawPattern(const MetronomeChannel &channel, uint8_t startLed,
-                   uint8_t size, const MetronomeState &state,
-                   const CRGB &baseColor);
-  uint8_t calculatePatternSpace(uint8_t barLength) const;
-  void updateSection(StripSection section, const MetronomeState &state);
+  // Boot chase, advanced from update() until it ends or playback starts;
+  // step STARTUP_STEPS clears the strips, anything past it is idle
+  uint8_t startupStep = STARTUP_STEPS + 1;
+  uint32_t startupStepUs = 0;
 
 public:
   LEDController();
   ~LEDController();
   void init();
-  void update(const MetronomeState &state);
+  void update(const MetronomeState &state, const FrameInfo &frame);
   void clear();
   void setBrightness(uint8_t brightness);
+  void setMaxRefreshRate(uint16_t hz);
+  void setPalette(uint8_t index, const ChannelPalette &palette) { pipeline.setPalette(index, palette); }
+  const LEDTelemetry &getTelemetry() const { return telemetry; }
+  const LEDLayout &getLayout() const { return layout; }
+  // Start the boot chase; it runs from update() without blocking
   void startupAnimation();
-  void onGlobalBeat();
-  void onChannelBeat(uint8_t channel);
+  void onChannelBeat(uint8_t channel, uint32_t tickUs);
 };
@@ -0,0 +1,102 @@
+#include "LEDLayout.h"
+
+// Stage rig: two 144-pixel strips plus an 8x8 serpentine matrix
+static const LEDOutputConfig STAGE_OUTPUTS[] = {
+    {27, 144},
+    {33, 144},
+    {13, 64},
+};
+
+static const LEDRegion STAGE_REGIONS[] = {
+    // Strip 0 - both channels with their blinkers
+    {REGION_BEAT, 0, 0, 0, 4, false},
+    {REGION_CHANNEL_BLINK, 0, 0, 4, 4, false},
+    {REGION_CHANNEL_PATTERN, 0, 0, 8, 64, false},
+    {REGION_CHANNEL_BLINK, 1, 0, 72, 4, false},
+    {REGION_CHANNEL_PATTERN, 1, 0, 76, 64, false},
+    {REGION_BEAT, 0, 0, 140, 4, false},
+    // Strip 1 - composite rhythm and bar progress
+    {REGION_COMPOSITE, 0, 1, 0, 120, false},
+    {REGION_BAR_PROGRESS, 0, 1, 120, 24, false},
+    // Matrix - one region per row, odd rows run backwards
+    {REGION_BAR_PROGRESS, 0, 2, 0, 8, false},
+    {REGION_CHANNEL_PATTERN, 0, 2, 8, 8, true},
+    {REGION_CHANNEL_PATTERN, 1, 2, 16, 8, false},
+    {REGION_COMPOSITE, 0, 2, 24, 8, true},
+    {REGION_BEAT, 0, 2, 32, 32, false},
+};
+
+void LEDLayout::addRegion(RegionType type, uint8_t channel, uint8_t output,
+                          uint16_t start, uint16_t length, bool reversed)
+{
+  if (regionCount >= LED_MAX_REGIONS || output >= outputCount)
+    return;
+
+  // Clip to the strip so a region can never write past its buffer
+  uint16_t numLeds = outputs[output].numLeds;
+  if (start >= numLeds)
+    return;
+  if (start + length > numLeds)
+    length = numLeds - start;
+
+  regions[regionCount++] = {type, channel, output, start, length, reversed};
+}
+
+void LEDLayout::loadCompact()
+{
+  compact = true;
+  outputs[0] = {LED_PIN, LED_COUNT};
+  outputCount = 1;
+  buildCompact(4, 4);
+}
+
+void LEDLayout::loadStage()
+{
+  compact = false;
+  outputCount = min<uint8_t>(sizeof(STAGE_OUTPUTS) / sizeof(STAGE_OUTPUTS[0]), LED_MAX_OUTPUTS);
+  for (uint8_t i = 0; i < outputCount; i++)
+  {
+    outputs[i] = STAGE_OUTPUTS[i];
+  }
+
+  regionCount = 0;
+  for (const LEDRegion &region : STAGE_REGIONS)
+  {
+    addRegion(region.type, region.channel, region.output, region.start, region.length, region.reversed);
+  }
+  generation++;
+}
+
+void LEDLayout::buildCompact(uint8_t ch1Length, uint8_t ch2Length)
+{
+  compactLengths[0] = ch1Length;
+  compactLengths[1] = ch2Length;
+
+  // Beat | ch1 blink | ch1 steps | beat | ch2 blink | ch2 steps | beat
+  regionCount = 0;
+  uint16_t pos = 0;
+  addRegion(REGION_BEAT, 0, 0, pos++, 1);
+  addRegion(REGION_CHANNEL_BLINK, 0, 0, pos++, 1);
+  addRegion(REGION_CHANNEL_PATTERN, 0, 0, pos, ch1Length);
+  pos += ch1Length;
+  addRegion(REGION_BEAT, 0, 0, pos++, 1);
+  addRegion(REGION_CHANNEL_BLINK, 1, 0, pos++, 1);
+  addRegion(REGION_CHANNEL_PATTERN, 1, 0, pos, ch2Length);
+  pos += ch2Length;
+  addRegion(REGION_BEAT, 0, 0, pos, 1);
+  generation++;
+}
+
+bool LEDLayout::refresh(const MetronomeState &state)
+{
+  if (!compact)
+    return false;
+
+  uint8_t ch1Length = state.getChannel(0).getBarLength();
+  uint8_t ch2Length = state.getChannel(1).getBarLength();
+  if (ch1Length == compactLengths[0] && ch2Length == compactLengths[1])
+    return false;
+
+  buildCompact(ch1Length, ch2Length);
+  return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <Arduino.h>
+#include "MetronomeState.h"
+#include "config.h"
+
+// What a group of pixels shows
+enum RegionType : uint8_t
+{
+  REGION_BEAT,            // Global beat blinker
+  REGION_CHANNEL_BLINK,   // Channel beat blinker
+  REGION_CHANNEL_PATTERN, // Channel steps spread over the region
+  REGION_COMPOSITE,       // All channels merged over the full cycle
+  REGION_BAR_PROGRESS     // Fill bar for the position in the cycle
+};
+
+// A logical visual region mapped onto a pixel range of one physical strip
+struct LEDRegion
+{
+  RegionType type;
+  uint8_t channel;  // Channel for the channel regions
+  uint8_t output;   // Strip index
+  uint16_t start;   // First pixel on that strip
+  uint16_t length;  // Pixels in the region
+  bool reversed;    // Draw from the far end (serpentine matrix rows)
+};
+
+struct LEDOutputConfig
+{
+  uint8_t pin;
+  uint16_t numLeds;
+};
+
+// Maps logical regions to physical pixel ranges on one or more strips.
+// The compact layout reproduces the original single strip, whose
+// sections move with the channel bar lengths; the stage layout is a
+// fixed table for multi-strip rigs and matrices.
+class LEDLayout
+{
+private:
+  LEDOutputConfig outputs[LED_MAX_OUTPUTS];
+  uint8_t outputCount = 0;
+  LEDRegion regions[LED_MAX_REGIONS];
+  uint8_t regionCount = 0;
+
+  bool compact = true;
+  uint8_t compactLengths[FIXED_CHANNEL_COUNT] = {};
+  uint32_t generation = 0;
+
+  void addRegion(RegionType type, uint8_t channel, uint8_t output,
+                 uint16_t start, uint16_t length, bool reversed = false);
+  void buildCompact(uint8_t ch1Length, uint8_t ch2Length);
+
+public:
+  void loadCompact();
+  void loadStage();
+
+  // Compact layout follows the bar lengths; returns true when regions moved
+  bool refresh(const MetronomeState &state);
+
+  uint8_t getOutputCount() const { return outputCount; }
+  const LEDOutputConfig &getOutput(uint8_t index) const { return outputs[index]; }
+  uint8_t getRegionCount() const { return regionCount; }
+  const LEDRegion &getRegion(uint8_t index) const { return regions[index]; }
+  uint32_t getGeneration() const { return generation; }
+};
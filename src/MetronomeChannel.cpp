@@ -1,11 +1,11 @@
 #include "MetronomeChannel.h"
-#include "WirelessSync.h"
 #include "MetronomeState.h"
 
 MetronomeChannel::MetronomeChannel(uint8_t channelId)
     : id(channelId), barLength(4), pattern(0), multiplier(1.0), currentBeat(0),
-      enabled(channelId == 0), lastBeatTime(0), editing(false), editStep(0), beatProgress(0.0f),
-      lastTriggeredBeatPosition(UINT32_MAX), lastTriggeredTick(0) {}
+      enabled(channelId == 0), lastBeatTime(0), editing(false), editStep(0), beatProgress(0.0f) {
+    memset(stepChance, 100, sizeof(stepChance));
+}
 
 void MetronomeChannel::update(uint32_t globalBpm, uint32_t globalTick) {
     if (!enabled)
@@ -29,10 +29,7 @@ void MetronomeChannel::toggleBeat(uint8_t step) {
         return; // Can't toggle first beat
     uint16_t mask = 1 << step;
     pattern ^= mask;
-    // Notify pattern change
-    if (globalWirelessSync) {
-        globalWirelessSync->notifyPatternChanged(id);
-    }
+    markChanged(CHANGE_PATTERN);
 }
 
 void MetronomeChannel::generateEuclidean(uint8_t activeBeats) {
@@ -41,6 +38,7 @@ void MetronomeChannel::generateEuclidean(uint8_t activeBeats) {
     
     // Reset pattern
     pattern = 0;
+    markChanged(CHANGE_PATTERN);
     
     // Debug output
     Serial.print("Generating Euclidean rhythm: ");
@@ -109,40 +107,131 @@ void MetronomeChannel::generateEuclidean(uint8_t activeBeats) {
 }
 
 uint8_t MetronomeChannel::getId() const { return id; }
-uint8_t MetronomeChannel::getBarLength() const { return barLength; }
+uint8_t IRAM_ATTR MetronomeChannel::getBarLength() const { return barLength; }
 uint16_t MetronomeChannel::getPattern() const { return pattern; }
 float MetronomeChannel::getMultiplier() const { return multiplier; }
 uint8_t MetronomeChannel::getCurrentBeat() const { return currentBeat; }
-bool MetronomeChannel::isEnabled() const { return enabled; }
+bool IRAM_ATTR MetronomeChannel::isEnabled() const { return enabled; }
 bool MetronomeChannel::isEditing() const { return editing; }
 uint8_t MetronomeChannel::getEditStep() const { return editStep; }
 
 void MetronomeChannel::setBarLength(uint8_t length) {
-    if (length > 0 && length <= MAX_BEATS) {
+    if (length > 0 && length <= MAX_BEATS && length != barLength) {
         barLength = length;
-        // Notify pattern change since this affects pattern playback
-        if (globalWirelessSync) {
-            globalWirelessSync->notifyPatternChanged(id);
-        }
+        markChanged(CHANGE_PATTERN);
     }
 }
 
 void MetronomeChannel::setPattern(uint16_t pat) {
+    if (pat == pattern)
+        return;
     pattern = pat;
-    // Notify pattern change
-    if (globalWirelessSync) {
-        globalWirelessSync->notifyPatternChanged(id);
-    }
+    markChanged(CHANGE_PATTERN);
 }
 
 void MetronomeChannel::setMultiplier(float mult) { multiplier = mult; }
 void MetronomeChannel::toggleEnabled() {
     enabled = !enabled;
-    // Notify pattern change since this affects pattern playback
-    if (globalWirelessSync) {
-        globalWirelessSync->notifyPatternChanged(id);
+    markChanged(CHANGE_PATTERN);
+}
+void MetronomeChannel::setVolume(uint8_t vol) {
+    if (vol == volume)
+        return;
+    volume = vol;
+    markChanged(CHANGE_VOLUME);
+}
+
+void MetronomeChannel::setStrongVolume(uint8_t vol) {
+    if (vol == strongVolume)
+        return;
+    strongVolume = vol;
+    markChanged(CHANGE_VOLUME);
+}
+
+void MetronomeChannel::setWeakVolume(uint8_t vol) {
+    if (vol == weakVolume)
+        return;
+    weakVolume = vol;
+    markChanged(CHANGE_VOLUME);
+}
+
+void MetronomeChannel::setSwing(uint8_t percent) {
+    percent = constrain(percent, MIN_SWING, MAX_SWING);
+    if (percent == swing)
+        return;
+    swing = percent;
+    markChanged(CHANGE_GROOVE);
+}
+
+void MetronomeChannel::setStepOffset(uint8_t step, int8_t ticks) {
+    if (step >= MAX_BEATS)
+        return;
+    ticks = constrain(ticks, -MAX_STEP_OFFSET_TICKS, MAX_STEP_OFFSET_TICKS);
+    if (ticks == stepOffsets[step])
+        return;
+    stepOffsets[step] = ticks;
+    markChanged(CHANGE_GROOVE);
+}
+
+void MetronomeChannel::clearStepOffsets() {
+    for (uint8_t i = 0; i < MAX_BEATS; i++) {
+        setStepOffset(i, 0);
+    }
+}
+
+// Shifts are in effective ticks * barLength, the units a step is barTicks
+// long in. Each stays within half a step, so steps keep their order and a
+// window only has to look at the steps next to the one the grid puts there.
+void MetronomeChannel::compileGroove(const MetronomeState& state, uint8_t table) {
+    int64_t barTicks = getBarTicks(state);
+    int64_t multiplier = int64_t(state.getCurrentMultiplier());
+    int64_t latest = barTicks / 2;
+    bool shifted = false;
+
+    for (uint8_t i = 0; i < MAX_BEATS; i++) {
+        int64_t shift = 0;
+        if (i < barLength) {
+            if (i & 1)
+                shift += barTicks * (swing - MIN_SWING) / 50;
+            shift += int64_t(stepOffsets[i]) * multiplier * barLength;
+            shift = shift > latest ? latest : shift <= -latest ? 1 - latest : shift;
+        }
+        stepShift[table][i] = int32_t(shift);
+        shifted |= shift != 0;
     }
+    grooved[table] = shifted;
 }
+
+void MetronomeChannel::setStepChance(uint8_t step, uint8_t percent) {
+    if (step == 0 || step >= MAX_BEATS)
+        return;
+    percent = min(percent, uint8_t(100));
+    if (percent == stepChance[step])
+        return;
+    stepChance[step] = percent;
+    markChanged(CHANGE_CHANCE);
+}
+
+void MetronomeChannel::clearStepChances() {
+    for (uint8_t i = 1; i < MAX_BEATS; i++) {
+        setStepChance(i, 100);
+    }
+}
+
+// splitmix64's finalizer
+static uint64_t IRAM_ATTR mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+bool IRAM_ATTR MetronomeChannel::rollChance(uint32_t seed, uint32_t bar, uint8_t channel, uint8_t step, uint8_t percent) {
+    uint64_t hash = mix64(mix64((uint64_t(seed) << 32) | bar) + (uint32_t(channel) << 8 | step));
+    // Top 32 bits scaled to 0-99 without a division
+    return uint32_t((hash >> 32) * 100 >> 32) < percent;
+}
+
 void MetronomeChannel::setEditing(bool edit) { editing = edit; }
 
 void MetronomeChannel::setEditStep(uint8_t step) {
@@ -175,7 +264,7 @@ void MetronomeChannel::updateProgress(uint32_t globalTick) {
     beatProgress = (globalTick % 1) / 1.0f;
 }
 
-void MetronomeChannel::updateBeat(uint32_t globalTick) {
+void IRAM_ATTR MetronomeChannel::updateBeat(uint32_t globalTick) {
     if (!enabled)
         return;
     currentBeat = globalTick % barLength;
@@ -189,8 +278,6 @@ void MetronomeChannel::resetBeat() {
     currentBeat = 0;
     lastBeatTime = 0;
     beatProgress = 0.0f;
-    lastTriggeredBeatPosition = UINT32_MAX;
-    lastTriggeredTick = 0;
 }
 
 // New methods for polyrhythm mode
@@ -225,79 +312,72 @@ void MetronomeChannel::updatePolyrhythmBeat(uint32_t masterTick, uint8_t ch1Leng
     lastBeatTime = masterTick;
 }
 
-BeatState MetronomeChannel::getPolyrhythmBeatState(uint32_t ppqnTick, const MetronomeState& state) const {
-    // Basic checks
-    if (!enabled)
-        return SILENT;
-    
-    // Channel 1 is processed normally
-    if (id == 0) {
-        return getBeatState();
+// Number of steps started at or before effective tick `tick`: step k
+// starts on tick ceil(k * barTicks / barLength), hence floor(x * barLength / barTicks)
+static int64_t IRAM_ATTR stepsUpTo(int64_t tick, uint8_t barLength, int64_t barTicks) {
+    int64_t scaled = tick * barLength;
+    return scaled >= 0 ? scaled / barTicks : -((-scaled + barTicks - 1) / barTicks);
+}
+
+// The channel plays barLength steps per bar of barTicks effective ticks.
+// In polyrhythm mode channel 2's steps are spread over channel 1's bar.
+int64_t IRAM_ATTR MetronomeChannel::getBarTicks(const MetronomeState& state) const {
+    if (id > 0 && state.isPolyrhythm())
+        return int64_t(state.getChannel(0).getBarLength()) * 96;
+    return int64_t(barLength) * 96;
+}
+
+// Index of the step (counted from the start of the cycle) that starts
+// inside the window, as getStepBetween() describes
+bool IRAM_ATTR MetronomeChannel::findStep(int64_t fromTick, int64_t toTick, const MetronomeState& state, int64_t& index) const {
+    if (!enabled || barLength == 0)
+        return false;
+
+    int64_t barTicks = getBarTicks(state);
+    int64_t first = stepsUpTo(fromTick, barLength, barTicks);
+    int64_t last = stepsUpTo(toTick, barLength, barTicks);
+
+    uint8_t table = state.getGrooveTable();
+    if (!grooved[table]) {
+        if (last == first)
+            return false;
+        index = last;
+        return true;
     }
-    
-    // For channel 2, determine if this PPQN tick should trigger a beat
-    uint8_t ch1Length = state.getChannel(0).getBarLength();
-    uint8_t ch2Length = barLength;
-    
-    // Skip calculation if either channel length is 0
-    if (ch1Length == 0 || ch2Length == 0)
-        return SILENT;
-    
-    // Calculate effective tick based on multiplier
-    float multiplier = state.getCurrentMultiplier();
-    uint32_t effectiveTick = uint32_t(ppqnTick * multiplier);
-    
-    // Calculate the total ticks in one bar of channel 1
-    // PPQN_96 means 96 ticks per quarter note
-    uint32_t totalTicksInBar = ch1Length * 96;
-    
-    // Calculate how many ticks per beat for channel 2
-    // We need to distribute ch2Length beats evenly across totalTicksInBar ticks
-    float ticksPerBeat = float(totalTicksInBar) / float(ch2Length);
-    
-    // Get the position within the current bar
-    uint32_t tickInBar = effectiveTick % totalTicksInBar;
-    
-    // Calculate the exact beat position using floating point
-    float exactBeatPosition = float(tickInBar) / ticksPerBeat;
-    
-    // Get the integer beat position and fractional part
-    uint32_t beatPosition = uint32_t(exactBeatPosition);
-    float fractionalPart = exactBeatPosition - beatPosition;
-    
-    // Define tolerance for beat detection (0.05 = 5% of a beat)
-    float tolerance = 0.05f;
-    
-    // If we're close to a beat boundary (within tolerance)
-    if (fractionalPart < tolerance || fractionalPart > (1.0f - tolerance)) {
-        // Ensure we don't exceed the bar length
-        beatPosition = beatPosition % ch2Length;
-        
-        // IMPORTANT: Check if this is a new beat position to prevent double triggers
-        // Only trigger if this is a different beat than the last one we processed
-        
-        // Only trigger if:
-        // 1. This is a different beat position than the last one we processed, OR
-        // 2. We've gone through a complete bar (tickInBar < last tickInBar)
-        bool shouldTrigger = (beatPosition != lastTriggeredBeatPosition) || 
-                             (ppqnTick - lastTriggeredTick > totalTicksInBar/2);
-        
-        if (shouldTrigger) {
-            // Update the last triggered position and tick
-            // We need to cast away const here because we're modifying member variables
-            // This is safe because we're not changing the logical state of the object
-            MetronomeChannel* nonConstThis = const_cast<MetronomeChannel*>(this);
-            nonConstThis->lastTriggeredBeatPosition = beatPosition;
-            nonConstThis->lastTriggeredTick = ppqnTick;
-            
-            // Return appropriate beat state based on pattern
-            if (beatPosition == 0) {
-                return ACCENT; // First beat is always accented
-            } else if ((pattern >> (beatPosition - 1)) & 1) {
-                return WEAK;   // Other beats follow the pattern
-            }
+
+    // Shifted steps: the latest one that lands inside the window. A shift
+    // is under half a step, so only the grid's neighbours can land here.
+    int64_t from = fromTick * barLength;
+    int64_t to = toTick * barLength;
+    for (int64_t j = last + 1; j >= first && j >= 0; j--) {
+        int64_t at = j * barTicks + stepShift[table][j % barLength];
+        if (at > from && at <= to) {
+            index = j;
+            return true;
         }
     }
-    
-    return SILENT;
-} 
\ No newline at end of file
+    return false;
+}
+
+bool IRAM_ATTR MetronomeChannel::getStepBetween(int64_t fromTick, int64_t toTick, const MetronomeState& state, uint8_t& step) const {
+    int64_t index;
+    if (!findStep(fromTick, toTick, state, index))
+        return false;
+    step = uint8_t(index % barLength);
+    return true;
+}
+
+BeatState IRAM_ATTR MetronomeChannel::getBeatStateBetween(int64_t fromTick, int64_t toTick, const MetronomeState& state) const {
+    int64_t index;
+    if (!findStep(fromTick, toTick, state, index))
+        return SILENT;
+    uint8_t step = uint8_t(index % barLength);
+    if (step == 0)
+        return ACCENT; // First beat is always accented
+    if (!((pattern >> (step - 1)) & 1))
+        return SILENT;
+    if (stepChance[step] < 100 &&
+        !rollChance(state.getSessionSeed(), uint32_t(index / barLength), id, step, stepChance[step]))
+        return SILENT;
+    return WEAK;
+}
@@ -2,11 +2,6 @@
 #include <Arduino.h>
 #include "config.h"
 
-// Forward declaration of WirelessSync class
-class WirelessSync;
-// External declaration of the global instance
-extern WirelessSync *globalWirelessSync;
-
 // Forward declaration for MetronomeState to avoid circular includes
 class MetronomeState;
 
@@ -17,6 +12,24 @@ enum BeatState
     ACCENT = 2
 };
 
+// Groups of settings tracked for change detection. Every mutator bumps
+// the generation of the group it touched; consumers remember the
+// generations they last acted on (see ChangeTracker).
+enum ChangeGroup : uint8_t
+{
+    CHANGE_TEMPO = 0,   // BPM
+    CHANGE_MULTIPLIER,
+    CHANGE_MODE,        // Polymeter / polyrhythm
+    CHANGE_PATTERN,     // Channel enabled, bar length, pattern
+    CHANGE_VOLUME,      // Channel volumes
+    CHANGE_GROOVE,      // Channel swing and step offsets
+    CHANGE_CHANCE,      // Channel step trigger chances
+    CHANGE_GROUP_COUNT
+};
+
+constexpr uint8_t changeBit(ChangeGroup group) { return 1 << group; }
+constexpr uint8_t CHANGE_ALL = (1 << CHANGE_GROUP_COUNT) - 1;
+
 class MetronomeChannel
 {
 private:
@@ -31,15 +44,31 @@ private:
     uint8_t editStep;
     float beatProgress;
 
-    // For polyrhythm mode to prevent double triggers
-    uint32_t lastTriggeredBeatPosition;
-    uint32_t lastTriggeredTick;
-
     // Volume control parameters
     uint8_t volume = 255;       // Channel volume (0-255)
     uint8_t strongVolume = 255; // Volume for strong beats (0-255)
     uint8_t weakVolume = 192;   // Volume for weak beats (0-255)
 
+    // Groove: swing delays every odd step, step offsets move single steps
+    uint8_t swing = MIN_SWING;          // Percent; 50 is straight
+    int8_t stepOffsets[MAX_BEATS] = {}; // PPQN ticks, + is late
+
+    // Groove compiled for the tick path: each step's shift from the grid
+    // in the units getStepBetween compares (effective tick * bar length).
+    // Two sets, picked by MetronomeState::getGrooveTable().
+    int32_t stepShift[2][MAX_BEATS] = {};
+    bool grooved[2] = {};
+
+    // Trigger chance of each step in percent; below 100 the step plays on
+    // the bars rollChance() picks
+    uint8_t stepChance[MAX_BEATS];
+
+    uint32_t generations[CHANGE_GROUP_COUNT] = {};
+
+    void markChanged(ChangeGroup group) { generations[group]++; }
+    int64_t getBarTicks(const MetronomeState &state) const;
+    bool findStep(int64_t fromTick, int64_t toTick, const MetronomeState &state, int64_t &index) const;
+
 public:
     MetronomeChannel(uint8_t channelId);
 
@@ -71,21 +100,44 @@ public:
 
     // New methods for polyrhythm mode
     void updatePolyrhythmBeat(uint32_t masterTick, uint8_t ch1Length, uint8_t ch2Length);
-    BeatState getPolyrhythmBeatState(uint32_t ppqnTick, const MetronomeState &state) const;
+
+    // Step that starts inside the effective-tick window (fromTick, toTick].
+    // Pure, so beats can be evaluated ahead of the clock. Polyrhythm steps
+    // start on the exact tick ceil(k * bar / steps), never twice.
+    bool getStepBetween(int64_t fromTick, int64_t toTick, const MetronomeState &state, uint8_t &step) const;
+    BeatState getBeatStateBetween(int64_t fromTick, int64_t toTick, const MetronomeState &state) const;
 
     // Volume control methods
     uint8_t getVolume() const { return volume; }
     uint8_t getStrongVolume() const { return strongVolume; }
     uint8_t getWeakVolume() const { return weakVolume; }
 
-    void setVolume(uint8_t vol)
-    {
-        volume = vol;
-        // Remove WirelessSync notification for now
-    }
+    void setVolume(uint8_t vol);
+    void setStrongVolume(uint8_t vol);
+    void setWeakVolume(uint8_t vol);
+
+    // Groove settings. They take effect once compileGroove() has run,
+    // which Timing does from the loop whenever they or the layout change.
+    uint8_t getSwing() const { return swing; }
+    int8_t getStepOffset(uint8_t step) const { return step < MAX_BEATS ? stepOffsets[step] : 0; }
+    void setSwing(uint8_t percent);
+    void setStepOffset(uint8_t step, int8_t ticks);
+    void clearStepOffsets();
+    void compileGroove(const MetronomeState &state, uint8_t table);
+
+    // Step trigger chances. Step 0 always plays, like its pattern bit.
+    uint8_t getStepChance(uint8_t step) const { return step < MAX_BEATS ? stepChance[step] : 100; }
+    void setStepChance(uint8_t step, uint8_t percent);
+    void clearStepChances();
+
+    // Whether a step with `percent` chance plays in `bar`. A counter-based
+    // hash of (seed, bar, channel, step) with no other state, so any device
+    // with the session seed gets the same answer for any beat in O(1).
+    static bool rollChance(uint32_t seed, uint32_t bar, uint8_t channel, uint8_t step, uint8_t percent);
 
-    void setStrongVolume(uint8_t vol) { strongVolume = vol; }
-    void setWeakVolume(uint8_t vol) { weakVolume = vol; }
+    // Bumped by every change to the group; only CHANGE_PATTERN,
+    // CHANGE_VOLUME, CHANGE_GROOVE and CHANGE_CHANCE apply to a channel
+    uint32_t getGeneration(ChangeGroup group) const { return generations[group]; }
 
     // Get effective volumes (main volume * beat volume)
     uint8_t getEffectiveStrongVolume() const
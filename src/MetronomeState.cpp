@@ -1,5 +1,7 @@
 #include "MetronomeState.h"
-#include "ConfigManager.h"
+#include "ConfigStore.h"
+
+extern ConfigStore *globalConfigStore;
 
 uint32_t MetronomeState::gcd(uint32_t a, uint32_t b) const {
     while (b != 0) {
@@ -16,11 +18,11 @@ uint32_t MetronomeState::lcm(uint32_t a, uint32_t b) const {
 
 MetronomeState::MetronomeState() : channels{MetronomeChannel(0), MetronomeChannel(1)} {}
 
-const MetronomeChannel &MetronomeState::getChannel(uint8_t index) const {
+IRAM_ATTR const MetronomeChannel &MetronomeState::getChannel(uint8_t index) const {
     return channels[index];
 }
 
-MetronomeChannel &MetronomeState::getChannel(uint8_t index) {
+IRAM_ATTR MetronomeChannel &MetronomeState::getChannel(uint8_t index) {
     return channels[index];
 }
 
@@ -32,7 +34,7 @@ void MetronomeState::update() {
     }
 }
 
-void MetronomeState::updateTickFraction(uint32_t ppqnTick) {
+void IRAM_ATTR MetronomeState::updateTickFraction(uint32_t ppqnTick) {
     // If paused, don't update the fraction
     if (isPaused) {
         return;
@@ -124,20 +126,63 @@ const char *MetronomeState::getCurrentMultiplierName() const {
     return multiplierNames[currentMultiplierIndex];
 }
 
-float MetronomeState::getCurrentMultiplier() const {
+float IRAM_ATTR MetronomeState::getCurrentMultiplier() const {
     return multiplierValues[currentMultiplierIndex];
 }
 
+void MetronomeState::setBpm(uint16_t value) {
+    if (value == bpm)
+        return;
+    bpm = value;
+    markChanged(CHANGE_TEMPO);
+}
+
+void MetronomeState::setMultiplierIndex(uint8_t index) {
+    if (index == currentMultiplierIndex)
+        return;
+    currentMultiplierIndex = index;
+    markChanged(CHANGE_MULTIPLIER);
+}
+
+void MetronomeState::setRhythmMode(MetronomeMode mode) {
+    if (mode == rhythmMode)
+        return;
+    rhythmMode = mode;
+    markChanged(CHANGE_MODE);
+}
+
 void MetronomeState::adjustMultiplier(int8_t delta) {
-    currentMultiplierIndex = (currentMultiplierIndex + MULTIPLIER_COUNT + delta) % MULTIPLIER_COUNT;
+    setMultiplierIndex((currentMultiplierIndex + MULTIPLIER_COUNT + delta) % MULTIPLIER_COUNT);
 }
 
 void MetronomeState::toggleRhythmMode() {
-    rhythmMode = (rhythmMode == POLYMETER) ? POLYRHYTHM : POLYMETER;
+    setRhythmMode(rhythmMode == POLYMETER ? POLYRHYTHM : POLYMETER);
+}
+
+void MetronomeState::buildGroove() {
+    for (auto &channel : channels) {
+        channel.compileGroove(*this, grooveTable ^ 1);
+    }
+}
+
+uint32_t MetronomeState::getGeneration(ChangeGroup group) const {
+    uint32_t generation = generations[group];
+    for (const auto &channel : channels) {
+        generation += channel.getGeneration(group);
+    }
+    return generation;
+}
+
+uint32_t MetronomeState::getGeneration() const {
+    uint32_t generation = 0;
+    for (uint8_t i = 0; i < CHANGE_GROUP_COUNT; i++) {
+        generation += getGeneration(static_cast<ChangeGroup>(i));
+    }
+    return generation;
 }
 
 void MetronomeState::resetBpmToDefault() {
-    bpm = DEFAULT_BPM;
+    setBpm(DEFAULT_BPM);
     
     // Debug output
     Serial.print("BPM reset to default: ");
@@ -146,7 +191,7 @@ void MetronomeState::resetBpmToDefault() {
 
 void MetronomeState::resetPatternsAndMultiplier() {
     // Reset multiplier to default (1.0)
-    currentMultiplierIndex = 0;
+    setMultiplierIndex(0);
     
     // Reset all channel patterns
     for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
@@ -160,7 +205,7 @@ void MetronomeState::resetPatternsAndMultiplier() {
     }
     
     // Reset rhythm mode to default (POLYMETER)
-    rhythmMode = POLYMETER;
+    setRhythmMode(POLYMETER);
     
     // Debug output
     Serial.println("Patterns and multiplier reset to defaults");
@@ -183,15 +228,15 @@ void MetronomeState::resetChannelPattern(uint8_t channelIndex) {
 // Configuration persistence methods
 bool MetronomeState::saveToStorage() {
     Serial.println("Saving configuration to storage...");
-    return ConfigManager::saveConfig(*this);
+    return globalConfigStore && globalConfigStore->commit(*this);
 }
 
 bool MetronomeState::loadFromStorage() {
     Serial.println("Loading configuration from storage...");
-    return ConfigManager::loadConfig(*this);
+    return globalConfigStore && globalConfigStore->load(*this);
 }
 
 bool MetronomeState::clearStorage() {
     Serial.println("Clearing configuration storage...");
-    return ConfigManager::clearConfig();
+    return globalConfigStore && globalConfigStore->clear();
 } 
\ No newline at end of file
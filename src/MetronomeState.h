@@ -33,6 +33,13 @@ class MetronomeState
 private:
     MetronomeChannel channels[FIXED_CHANNEL_COUNT];
     uint32_t longPressStart = 0;
+    uint32_t generations[CHANGE_GROUP_COUNT] = {};
+    uint32_t sessionSeed = 0;
+
+    // Groove table set the tick path reads; the other one is rebuilt
+    volatile uint8_t grooveTable = 0;
+
+    void markChanged(ChangeGroup group) { generations[group]++; }
 
     uint32_t gcd(uint32_t a, uint32_t b) const;
     uint32_t lcm(uint32_t a, uint32_t b) const;
@@ -45,6 +52,8 @@ public:
     const float multiplierValues[MULTIPLIER_COUNT] = MULTIPLIERS;
     const char *multiplierNames[MULTIPLIER_COUNT] = MULTIPLIER_NAMES;
 
+    // Settings are read directly but written through the setters below,
+    // which track the change
     uint16_t bpm = DEFAULT_BPM;
     bool isRunning = false;
     bool isPaused = false;
@@ -85,15 +94,41 @@ public:
     float getEffectiveBpm() const;
     const char *getCurrentMultiplierName() const;
     float getCurrentMultiplier() const;
+    void setBpm(uint16_t value);
+    void setMultiplierIndex(uint8_t index);
+    void setRhythmMode(MetronomeMode mode);
     void adjustMultiplier(int8_t delta);
     void toggleRhythmMode();
     bool isPolyrhythm() const { return rhythmMode == POLYRHYTHM; }
 
+    // Seed of the step chance rolls; the leader picks one per start and
+    // sends it with CMD_START
+    uint32_t getSessionSeed() const { return sessionSeed; }
+    void setSessionSeed(uint32_t seed) { sessionSeed = seed; }
+
+    // Rebuild every channel's groove table after groove, layout, mode or
+    // multiplier changes. The tables are double-buffered: buildGroove()
+    // writes the set the tick path is not reading and swapGroove() makes
+    // it the one it reads, so no tick sees a half-built table. Timing
+    // swaps the live state's under its preset mux.
+    void buildGroove();
+    void swapGroove() { grooveTable ^= 1; }
+    void compileGroove()
+    {
+        buildGroove();
+        swapGroove();
+    }
+    uint8_t getGrooveTable() const { return grooveTable; }
+
     // Reset methods
     void resetBpmToDefault();
     void resetPatternsAndMultiplier();
     void resetChannelPattern(uint8_t channelIndex);
 
+    // Change generations; channel groups sum over the channels
+    uint32_t getGeneration(ChangeGroup group) const;
+    uint32_t getGeneration() const; // Any group
+
     // Configuration persistence methods
     bool saveToStorage();
     bool loadFromStorage();
@@ -104,4 +139,31 @@ public:
         static MetronomeState instance;
         return instance;
     }
-};
\ No newline at end of file
+};
+
+// Generations a consumer has already acted on. poll() returns, as
+// changeBit() flags, which of the requested groups changed since the
+// previous poll, so each consumer keeps its own view of what is dirty.
+class ChangeTracker
+{
+private:
+    uint32_t seen[CHANGE_GROUP_COUNT] = {};
+
+public:
+    uint8_t poll(const MetronomeState &state, uint8_t groups = CHANGE_ALL)
+    {
+        uint8_t dirty = 0;
+        for (uint8_t i = 0; i < CHANGE_GROUP_COUNT; i++)
+        {
+            if (!(groups & (1 << i)))
+                continue;
+            uint32_t generation = state.getGeneration(static_cast<ChangeGroup>(i));
+            if (generation != seen[i])
+            {
+                seen[i] = generation;
+                dirty |= 1 << i;
+            }
+        }
+        return dirty;
+    }
+};
@@ -0,0 +1,67 @@
+#include "PiezoCalibrator.h"
+
+PiezoCalibrator *PiezoCalibrator::_instance = nullptr;
+
+void IRAM_ATTR PiezoCalibrator::onStrikeStatic()
+{
+    PiezoCalibrator *self = _instance;
+    if (!self || !self->armed || self->struck)
+        return;
+
+    uint32_t now = micros();
+    if (now - self->fireUs < BLANKING_US)
+        return;
+
+    self->strikeUs = now;
+    self->struck = true;
+}
+
+void PiezoCalibrator::begin()
+{
+    pinMode(piezoPin, INPUT);
+    attachInterrupt(digitalPinToInterrupt(piezoPin), onStrikeStatic, RISING);
+}
+
+void PiezoCalibrator::end()
+{
+    detachInterrupt(digitalPinToInterrupt(piezoPin));
+}
+
+uint32_t PiezoCalibrator::measure(SolenoidController &solenoids, uint8_t channel, uint8_t shots)
+{
+    if (channel >= FIXED_CHANNEL_COUNT || shots == 0)
+        return 0;
+
+    SolenoidHit hits[FIXED_CHANNEL_COUNT] = {};
+    hits[channel] = {ACCENT, 255};
+
+    uint32_t samples[CALIBRATION_SHOTS];
+    uint8_t count = 0;
+    shots = min<uint8_t>(shots, CALIBRATION_SHOTS);
+
+    for (uint8_t shot = 0; shot < shots; shot++)
+    {
+        struck = false;
+        fireUs = micros();
+        armed = true;
+        solenoids.processBeats(hits);
+
+        while (!struck && micros() - fireUs < CALIBRATION_TIMEOUT_US)
+        {
+            yield();
+        }
+        armed = false;
+
+        if (struck)
+        {
+            samples[count++] = strikeUs - fireUs;
+        }
+        delay(CALIBRATION_INTERVAL_MS);
+    }
+
+    if (count == 0)
+        return 0;
+
+    std::sort(samples, samples + count);
+    return samples[count / 2];
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+#include "SolenoidController.h"
+#include "config.h"
+
+// Measures solenoid fire-to-strike latency with a piezo pickup.
+// The piezo (conditioned to a logic edge) is wired to its own input pin;
+// each shot fires the solenoid and timestamps the first edge that
+// follows. The median over several shots is the channel's latency.
+class PiezoCalibrator
+{
+private:
+    // Edges this soon after firing are switching noise, not the strike
+    static const uint32_t BLANKING_US = 300;
+
+    uint8_t piezoPin;
+
+    static PiezoCalibrator *_instance;
+    static void IRAM_ATTR onStrikeStatic();
+
+    volatile bool armed = false;
+    volatile bool struck = false;
+    volatile uint32_t fireUs = 0;
+    volatile uint32_t strikeUs = 0;
+
+public:
+    explicit PiezoCalibrator(uint8_t pin) : piezoPin(pin)
+    {
+        _instance = this;
+    }
+
+    ~PiezoCalibrator()
+    {
+        if (_instance == this)
+        {
+            _instance = nullptr;
+        }
+    }
+
+    void begin();
+    void end();
+
+    // Median latency in us over `shots` strikes, 0 if no strike was detected
+    uint32_t measure(SolenoidController &solenoids, uint8_t channel, uint8_t shots = CALIBRATION_SHOTS);
+};
@@ -0,0 +1,139 @@
+#include "PresetBank.h"
+
+static const char *PRESET_NAMESPACE = "presets";
+
+void PresetBank::slotKey(uint8_t slot, char *key, size_t size)
+{
+    snprintf(key, size, "p%02u", slot);
+}
+
+void PresetBank::capture(const MetronomeState &state, Preset &preset)
+{
+    preset.format = PRESET_FORMAT;
+    preset.bpm = state.bpm;
+    preset.flags = state.currentMultiplierIndex & FLAG_MULTIPLIER_MASK;
+    if (state.isPolyrhythm())
+    {
+        preset.flags |= FLAG_POLYRHYTHM;
+    }
+
+    for (uint8_t i = 0; i < FIXED_CHANNEL_COUNT; i++)
+    {
+        const MetronomeChannel &channel = state.getChannel(i);
+        if (channel.isEnabled())
+        {
+            preset.flags |= 1 << (FLAG_ENABLED_SHIFT + i);
+        }
+        preset.channels[i].barLength = channel.getBarLength();
+        preset.channels[i].pattern = channel.getPattern();
+        preset.channels[i].volume = channel.getVolume();
+    }
+}
+
+void PresetBank::apply(const Preset &preset, MetronomeState &state)
+{
+    state.setBpm(constrain(preset.bpm, MIN_GLOBAL_BPM, MAX_GLOBAL_BPM));
+    state.setMultiplierIndex(constrain(preset.flags & FLAG_MULTIPLIER_MASK, 0, MULTIPLIER_COUNT - 1));
+    state.setRhythmMode((preset.flags & FLAG_POLYRHYTHM) ? POLYRHYTHM : POLYMETER);
+
+    for (uint8_t i = 0; i < FIXED_CHANNEL_COUNT; i++)
+    {
+        MetronomeChannel &channel = state.getChannel(i);
+        bool enabled = preset.flags & (1 << (FLAG_ENABLED_SHIFT + i));
+        if (channel.isEnabled() != enabled)
+        {
+            channel.toggleEnabled();
+        }
+        channel.setBarLength(constrain(preset.channels[i].barLength, 1, MAX_BEATS));
+        channel.setPattern(preset.channels[i].pattern & channel.getMaxPattern());
+        channel.setVolume(preset.channels[i].volume);
+    }
+}
+
+bool PresetBank::read(uint8_t slot, Preset &preset)
+{
+    char key[8];
+    slotKey(slot, key, sizeof(key));
+    if (prefs.getBytesLength(key) != sizeof(Preset))
+    {
+        return false;
+    }
+    prefs.getBytes(key, &preset, sizeof(Preset));
+    return preset.format == PRESET_FORMAT;
+}
+
+bool PresetBank::begin()
+{
+    opened = prefs.begin(PRESET_NAMESPACE, false);
+    if (!opened)
+    {
+        Serial.println("Failed to open preset bank");
+        return false;
+    }
+
+    occupied = 0;
+    for (uint8_t slot = 0; slot < PRESET_COUNT; slot++)
+    {
+        Preset preset;
+        if (read(slot, preset))
+        {
+            occupied |= 1UL << slot;
+            index[slot].bpm = preset.bpm;
+            for (uint8_t i = 0; i < FIXED_CHANNEL_COUNT; i++)
+            {
+                index[slot].barLengths[i] = preset.channels[i].barLength;
+            }
+        }
+    }
+
+    Serial.printf("Preset bank: %u of %u slots used\n", count(), PRESET_COUNT);
+    return true;
+}
+
+bool PresetBank::save(uint8_t slot, const MetronomeState &state)
+{
+    if (!opened || slot >= PRESET_COUNT)
+    {
+        return false;
+    }
+
+    Preset preset = {};
+    capture(state, preset);
+    char key[8];
+    slotKey(slot, key, sizeof(key));
+    if (prefs.putBytes(key, &preset, sizeof(Preset)) != sizeof(Preset))
+    {
+        return false;
+    }
+
+    occupied |= 1UL << slot;
+    index[slot].bpm = preset.bpm;
+    for (uint8_t i = 0; i < FIXED_CHANNEL_COUNT; i++)
+    {
+        index[slot].barLengths[i] = preset.channels[i].barLength;
+    }
+    return true;
+}
+
+bool PresetBank::recall(uint8_t slot, Preset &preset)
+{
+    if (!opened || !isOccupied(slot))
+    {
+        return false;
+    }
+    return read(slot, preset);
+}
+
+bool PresetBank::erase(uint8_t slot)
+{
+    if (!opened || slot >= PRESET_COUNT)
+    {
+        return false;
+    }
+
+    char key[8];
+    slotKey(slot, key, sizeof(key));
+    occupied &= ~(1UL << slot);
+    index[slot] = {};
+    return prefs.remove(key);
+}
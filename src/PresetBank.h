@@ -0,0 +1,65 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include "config.h"
+#include "MetronomeState.h"
+
+// One stored setup, 12 bytes in flash
+struct __attribute__((packed)) Preset
+{
+    uint8_t format;          // PRESET_FORMAT; anything else is an empty slot
+    uint16_t bpm;
+    uint8_t flags;           // Bits 0-1 multiplier index, bit 2 polyrhythm, bits 4.. channel enabled
+    struct __attribute__((packed))
+    {
+        uint8_t barLength;
+        uint16_t pattern;
+        uint8_t volume;
+    } channels[FIXED_CHANNEL_COUNT];
+};
+
+// Bank of PRESET_COUNT presets, one small NVS blob per slot so saving a
+// preset rewrites 12 bytes rather than the whole bank. begin() scans the
+// slots once into an in-RAM index, which is enough to list the bank
+// without touching flash; recall() reads a single slot.
+class PresetBank
+{
+public:
+    // What the index keeps per slot for listing
+    struct Summary
+    {
+        uint16_t bpm;
+        uint8_t barLengths[FIXED_CHANNEL_COUNT];
+    };
+
+private:
+    static const uint8_t FLAG_MULTIPLIER_MASK = 0x03;
+    static const uint8_t FLAG_POLYRHYTHM = 0x04;
+    static const uint8_t FLAG_ENABLED_SHIFT = 4;
+
+    Preferences prefs;
+    bool opened = false;
+    uint32_t occupied = 0;   // Bit per slot
+    Summary index[PRESET_COUNT] = {};
+
+    static void slotKey(uint8_t slot, char *key, size_t size);
+    bool read(uint8_t slot, Preset &preset);
+
+public:
+    bool begin();
+
+    // Store the live settings in `slot`
+    bool save(uint8_t slot, const MetronomeState &state);
+
+    // Load `slot` from flash; apply it with Timing::queuePreset()
+    bool recall(uint8_t slot, Preset &preset);
+
+    bool erase(uint8_t slot);
+
+    bool isOccupied(uint8_t slot) const { return slot < PRESET_COUNT && (occupied & (1UL << slot)); }
+    const Summary &getSummary(uint8_t slot) const { return index[slot < PRESET_COUNT ? slot : 0]; }
+    uint8_t count() const { return __builtin_popcount(occupied); }
+
+    static void capture(const MetronomeState &state, Preset &preset);
+    static void apply(const Preset &preset, MetronomeState &state);
+};
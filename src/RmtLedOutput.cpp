@@ -0,0 +1,162 @@
+#include "RmtLedOutput.h"
+
+RmtLedOutput::RmtLedOutput(uint8_t pin, uint16_t numLeds, rmt_channel_t channel)
+    : channel(channel), pin(pin), numLeds(numLeds)
+{
+  updateScale();
+  buildNibbleTable();
+}
+
+RmtLedOutput::~RmtLedOutput()
+{
+  if (buffers[0])
+  {
+    rmt_driver_uninstall(channel);
+  }
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    delete[] buffers[i];
+  }
+}
+
+bool RmtLedOutput::begin()
+{
+  rmt_config_t config = RMT_DEFAULT_CONFIG_TX(static_cast<gpio_num_t>(pin), channel);
+  config.clk_div = CLK_DIV;
+  config.tx_config.idle_output_en = true;
+  config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+
+  if (rmt_config(&config) != ESP_OK || rmt_driver_install(channel, 0, 0) != ESP_OK)
+  {
+    Serial.println("RMT LED output init failed");
+    return false;
+  }
+
+  // 24 bits per pixel, one RMT item per bit
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    buffers[i] = new rmt_item32_t[numLeds * 24];
+  }
+  return true;
+}
+
+void RmtLedOutput::setBrightness(uint8_t value)
+{
+  brightness = value;
+  updateScale();
+}
+
+void RmtLedOutput::setCorrection(const CRGB &value)
+{
+  correction = value;
+  updateScale();
+}
+
+void RmtLedOutput::updateScale()
+{
+  // Wire order is GRB
+  scale[0] = scale8(correction.g, brightness);
+  scale[1] = scale8(correction.r, brightness);
+  scale[2] = scale8(correction.b, brightness);
+}
+
+void RmtLedOutput::buildNibbleTable()
+{
+  const rmt_item32_t bit0 = {{{T0H, 1, T0L, 0}}};
+  const rmt_item32_t bit1 = {{{T1H, 1, T1L, 0}}};
+
+  for (uint8_t value = 0; value < 16; value++)
+  {
+    for (uint8_t bit = 0; bit < 4; bit++)
+    {
+      nibbleItems[value][bit] = (value & (0x8 >> bit)) ? bit1 : bit0;
+    }
+  }
+}
+
+void RmtLedOutput::encode(const CRGB *pixels, rmt_item32_t *items) const
+{
+  // Four RMT items per nibble straight from the table, MSB first
+  for (uint16_t i = 0; i < numLeds; i++)
+  {
+    const uint8_t grb[3] = {scale8(pixels[i].g, scale[0]),
+                            scale8(pixels[i].r, scale[1]),
+                            scale8(pixels[i].b, scale[2])};
+    for (uint8_t c = 0; c < 3; c++)
+    {
+      memcpy(items, nibbleItems[grb[c] >> 4], sizeof(nibbleItems[0]));
+      memcpy(items + 4, nibbleItems[grb[c] & 0x0F], sizeof(nibbleItems[0]));
+      items += 8;
+    }
+  }
+}
+
+bool RmtLedOutput::isIdle()
+{
+  if (streaming && rmt_wait_tx_done(channel, 0) == ESP_OK)
+  {
+    streaming = false;
+  }
+  return !streaming;
+}
+
+bool RmtLedOutput::isBusy()
+{
+  return !isIdle() || pending;
+}
+
+void RmtLedOutput::startStreaming(uint8_t index)
+{
+  streamingIndex = index;
+  streaming = true;
+  pending = false;
+  rmt_write_items(channel, buffers[index], numLeds * 24, false);
+}
+
+void RmtLedOutput::show(const CRGB *pixels)
+{
+  if (!buffers[0])
+    return;
+
+  uint32_t startUs = micros();
+
+  // Encode into whichever buffer the driver is not reading from
+  uint8_t backIndex = streamingIndex ^ 1;
+  encode(pixels, buffers[backIndex]);
+
+  if (isIdle())
+  {
+    startStreaming(backIndex);
+  }
+  else
+  {
+    pending = true; // Replaces any older pending frame
+  }
+
+  lastFrameCpuUs = micros() - startUs;
+  if (lastFrameCpuUs > maxFrameCpuUs)
+  {
+    maxFrameCpuUs = lastFrameCpuUs;
+  }
+}
+
+void RmtLedOutput::service()
+{
+  if (pending && isIdle())
+  {
+    startStreaming(streamingIndex ^ 1);
+  }
+}
+
+void RmtLedOutput::flush()
+{
+  while (isBusy())
+  {
+    if (streaming)
+    {
+      rmt_wait_tx_done(channel, portMAX_DELAY);
+      streaming = false;
+    }
+    service();
+  }
+}
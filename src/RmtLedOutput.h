@@ -0,0 +1,67 @@
+#pragma once
+#include <Arduino.h>
+#include <FastLED.h>
+#include <driver/rmt.h>
+
+// Non-blocking WS2812B output on an RMT channel.
+// Frames are encoded into one of two RMT item buffers and handed to the
+// RMT driver without waiting; the next frame is encoded into the other
+// buffer while the current one streams. A frame that arrives while the
+// strip is still busy stays pending and is started by service().
+class RmtLedOutput
+{
+private:
+  // WS2812B bit timings in RMT ticks (80 MHz APB / 2 = 25 ns per tick)
+  static const uint8_t CLK_DIV = 2;
+  static const uint16_t T0H = 16; // 0.40 us
+  static const uint16_t T0L = 34; // 0.85 us
+  static const uint16_t T1H = 32; // 0.80 us
+  static const uint16_t T1L = 18; // 0.45 us
+
+  rmt_channel_t channel;
+  uint8_t pin;
+  uint16_t numLeds;
+
+  rmt_item32_t *buffers[2] = {nullptr, nullptr};
+  uint8_t streamingIndex = 0; // Buffer owned by the RMT driver
+  bool streaming = false;
+  bool pending = false;       // Back buffer holds a frame waiting to start
+
+  uint8_t brightness = 255;
+  uint8_t scale[3] = {255, 255, 255}; // Per-channel brightness x correction, GRB order
+  CRGB correction = CRGB(255, 176, 240); // TypicalLEDStrip
+
+  rmt_item32_t nibbleItems[16][4]; // RMT items for every 4-bit value
+
+  uint32_t lastFrameCpuUs = 0;
+  uint32_t maxFrameCpuUs = 0;
+
+  void updateScale();
+  void buildNibbleTable();
+  void encode(const CRGB *pixels, rmt_item32_t *items) const;
+  bool isIdle();
+  void startStreaming(uint8_t index);
+
+public:
+  RmtLedOutput(uint8_t pin, uint16_t numLeds, rmt_channel_t channel = RMT_CHANNEL_0);
+  ~RmtLedOutput();
+
+  bool begin();
+
+  // Encode and start a frame. Returns immediately; the frame is either
+  // streaming or pending when this returns.
+  void show(const CRGB *pixels);
+
+  // Start a pending frame once the previous one has finished
+  void service();
+
+  // Block until the strip has received everything queued so far
+  void flush();
+
+  void setBrightness(uint8_t value);
+  void setCorrection(const CRGB &value);
+
+  bool isBusy();
+  uint32_t getLastFrameCpuUs() const { return lastFrameCpuUs; }
+  uint32_t getMaxFrameCpuUs() const { return maxFrameCpuUs; }
+};
@@ -0,0 +1,184 @@
+#include "SerialConsole.h"
+
+void SerialConsole::update()
+{
+    while (Serial.available() > 0)
+    {
+        int c = Serial.read();
+        if (c < 0)
+            return;
+
+        if (c == '\n' || c == '\r')
+        {
+            line[length] = '\0';
+            if (length)
+            {
+                execute(line);
+            }
+            length = 0;
+        }
+        else if (length + 1 < SERIAL_CONSOLE_LINE)
+        {
+            line[length++] = char(c);
+        }
+    }
+}
+
+// Slots are numbered from 1 on the console, as in the other messages
+bool SerialConsole::parseSlot(const char *text, uint8_t &slot)
+{
+    char *end;
+    long value = text ? strtol(text, &end, 10) : 0;
+    if (!text || end == text || *end || value < 1 || value > PRESET_COUNT)
+    {
+        Serial.printf("Slot must be 1-%u\n", PRESET_COUNT);
+        return false;
+    }
+    slot = uint8_t(value - 1);
+    return true;
+}
+
+void SerialConsole::execute(char *command)
+{
+    char *context = nullptr;
+    char *verb = strtok_r(command, " ", &context);
+    if (!verb)
+        return;
+
+    if (!strcmp(verb, "presets"))
+    {
+        listPresets();
+        return;
+    }
+    if (!strcmp(verb, "song"))
+    {
+        songCommand(context);
+        return;
+    }
+
+    bool slotCommand = !strcmp(verb, "save") || !strcmp(verb, "recall") || !strcmp(verb, "erase");
+    if (!slotCommand)
+    {
+        Serial.println("Commands: presets, save N, recall N, erase N, song [add N BARS [BPM] | clear | loop on|off | save]");
+        return;
+    }
+    char *argument = strtok_r(nullptr, " ", &context);
+    uint8_t slot;
+    if (!parseSlot(argument, slot))
+        return;
+
+    if (!strcmp(verb, "save"))
+    {
+        Serial.printf(presetBank.save(slot, state) ? "Saved preset %u\n" : "Preset %u not saved\n", slot + 1);
+    }
+    else if (!strcmp(verb, "recall"))
+    {
+        // One small blob read, then the switch waits for its bar
+        Preset preset;
+        if (!presetBank.recall(slot, preset))
+        {
+            Serial.printf("Preset %u is empty\n", slot + 1);
+            return;
+        }
+        timing.queuePreset(preset);
+        Serial.printf("Preset %u %s\n", slot + 1, timing.isPresetPending() ? "queued for the next bar" : "loaded");
+    }
+    else
+    {
+        presetBank.erase(slot);
+        Serial.printf("Erased preset %u\n", slot + 1);
+    }
+}
+
+void SerialConsole::listPresets()
+{
+    for (uint8_t slot = 0; slot < PRESET_COUNT; slot++)
+    {
+        if (!presetBank.isOccupied(slot))
+            continue;
+        const PresetBank::Summary &summary = presetBank.getSummary(slot);
+        Serial.printf("%2u: %u BPM, %u / %u steps\n", slot + 1, summary.bpm, summary.barLengths[0],
+                      summary.barLengths[1]);
+    }
+    Serial.printf("%u of %u slots used\n", presetBank.count(), PRESET_COUNT);
+}
+
+// Edits the chain in RAM; `song save` stores it and hands it to Timing
+void SerialConsole::songCommand(char *context)
+{
+    char *action = strtok_r(nullptr, " ", &context);
+    if (!action)
+    {
+        listSong();
+    }
+    else if (!strcmp(action, "add"))
+    {
+        uint8_t slot;
+        char *barsText = nullptr;
+        if (!parseSlot(strtok_r(nullptr, " ", &context), slot) ||
+            !(barsText = strtok_r(nullptr, " ", &context)))
+        {
+            Serial.println("Usage: song add N BARS [BPM]");
+            return;
+        }
+        char *bpmText = strtok_r(nullptr, " ", &context);
+        long bars = strtol(barsText, nullptr, 10);
+        long bpm = bpmText ? strtol(bpmText, nullptr, 10) : 0;
+        ChainEntry entry = {slot, uint8_t(constrain(bars, 0L, 255L)),
+                            uint16_t(bpm ? constrain(bpm, long(MIN_GLOBAL_BPM), long(MAX_GLOBAL_BPM)) : 0)};
+        if (!songChain.append(entry))
+        {
+            Serial.printf("Song full or bars out of range (1-255, at most %u entries)\n", SONG_MAX_ENTRIES);
+            return;
+        }
+        Serial.printf("Song entry %u: preset %u for %u bars\n", songChain.size(), slot + 1, entry.bars);
+    }
+    else if (!strcmp(action, "clear"))
+    {
+        songChain.clear();
+        Serial.println("Song cleared");
+    }
+    else if (!strcmp(action, "loop"))
+    {
+        char *value = strtok_r(nullptr, " ", &context);
+        songChain.setLoop(value && !strcmp(value, "on"));
+        Serial.printf("Song %s\n", songChain.isLooping() ? "loops" : "plays once");
+    }
+    else if (!strcmp(action, "save"))
+    {
+        // Timing takes a new song only while stopped
+        if (state.isRunning || state.isPaused)
+        {
+            Serial.println("Stop first");
+            return;
+        }
+        if (!songChain.save())
+        {
+            Serial.println("Song not saved");
+            return;
+        }
+        static SongEntry entries[SONG_MAX_ENTRIES];
+        uint8_t count = songChain.resolve(presetBank, entries);
+        timing.loadSong(entries, count, songChain.isLooping());
+        Serial.printf("Song saved, %u entries play from the next start\n", count);
+    }
+    else
+    {
+        Serial.println("Usage: song [add N BARS [BPM] | clear | loop on|off | save]");
+    }
+}
+
+void SerialConsole::listSong()
+{
+    for (uint8_t i = 0; i < songChain.size(); i++)
+    {
+        const ChainEntry &entry = songChain.getEntry(i);
+        Serial.printf("%2u: preset %u, %u bars", i + 1, entry.presetSlot + 1, entry.bars);
+        if (entry.bpm)
+        {
+            Serial.printf(" at %u BPM", entry.bpm);
+        }
+        Serial.println();
+    }
+    Serial.printf("%u entries%s\n", songChain.size(), songChain.isLooping() ? ", looping" : "");
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "MetronomeState.h"
+#include "PresetBank.h"
+#include "SongChain.h"
+#include "Timing.h"
+
+// Line commands over the serial port, read from the loop without
+// blocking. There is no preset screen, so this is how presets are stored
+// and recalled on the device:
+//   presets      list the occupied slots
+//   save N       store the live settings in slot N
+//   recall N     switch to slot N at the next bar (at once when stopped)
+//   erase N      empty slot N
+//   song                      list the stored song
+//   song add N BARS [BPM]     append slot N for BARS bars (at BPM)
+//   song clear / song loop on|off
+//   song save                 store the song and load it (while stopped)
+// Slots are numbered 1 to PRESET_COUNT.
+class SerialConsole
+{
+private:
+    MetronomeState &state;
+    Timing &timing;
+    PresetBank &presetBank;
+    SongChain &songChain;
+
+    char line[SERIAL_CONSOLE_LINE];
+    uint8_t length = 0;
+
+    void execute(char *command);
+    void listPresets();
+    void songCommand(char *context);
+    void listSong();
+    static bool parseSlot(const char *text, uint8_t &slot);
+
+public:
+    SerialConsole(MetronomeState &state, Timing &timing, PresetBank &presetBank, SongChain &songChain)
+        : state(state), timing(timing), presetBank(presetBank), songChain(songChain)
+    {
+    }
+
+    // Consume what has arrived; runs a command per complete line
+    void update();
+};
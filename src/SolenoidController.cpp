@@ -1,34 +1,330 @@
 #include "SolenoidController.h"
+#include "TraceBuffer.h"
+#include <soc/gpio_struct.h>
+#include <hal/ledc_ll.h>
 
-// Initialize static member
-SolenoidController* SolenoidController::_instance = nullptr;
+SolenoidController::PinMask SolenoidController::maskForPin(uint8_t pin)
+{
+    PinMask mask = {0, 0};
+    if (pin < 32)
+    {
+        mask.low = 1UL << pin;
+    }
+    else
+    {
+        mask.high = 1UL << (pin - 32);
+    }
+    return mask;
+}
+
+void IRAM_ATTR SolenoidController::setPins(const PinMask &mask)
+{
+    if (mask.low)
+        GPIO.out_w1ts = mask.low;
+    if (mask.high)
+        GPIO.out1_w1ts.val = mask.high;
+}
+
+void IRAM_ATTR SolenoidController::clearPins(const PinMask &mask)
+{
+    if (mask.low)
+        GPIO.out_w1tc = mask.low;
+    if (mask.high)
+        GPIO.out1_w1tc.val = mask.high;
+}
+
+// ledcWrite() runs from flash, so the envelope sets the duty through the
+// inlined LL register helpers, the same steps ledcWrite() takes. Arduino
+// channels 0-7 are high speed, 8-15 low speed.
+void IRAM_ATTR SolenoidController::setDuty(uint8_t ledcChannel, uint32_t duty)
+{
+    ledc_dev_t *hw = LEDC_LL_GET_HW();
+    ledc_mode_t mode = ledc_mode_t(ledcChannel / 8);
+    ledc_channel_t channel = ledc_channel_t(ledcChannel % 8);
+    ledc_ll_set_duty_int_part(hw, mode, channel, duty);
+    ledc_ll_set_duty_direction(hw, mode, channel, LEDC_DUTY_DIR_INCREASE);
+    ledc_ll_set_duty_num(hw, mode, channel, 1);
+    ledc_ll_set_duty_cycle(hw, mode, channel, 1);
+    ledc_ll_set_duty_scale(hw, mode, channel, 0);
+    ledc_ll_set_sig_out_en(hw, mode, channel, true);
+    ledc_ll_set_duty_start(hw, mode, channel, true);
+    if (mode == LEDC_LOW_SPEED_MODE)
+    {
+        ledc_ll_ls_channel_update(hw, mode, channel);
+    }
+}
+
+// Runs from the esp_timer task when a pulse (or envelope phase) has elapsed
+void IRAM_ATTR SolenoidController::endPulseCallback(void *arg)
+{
+    PulseOutput *output = static_cast<PulseOutput *>(arg);
+    SolenoidController *controller = output->controller;
+    uint32_t now = micros();
 
-// Implementation of the static callback function
-void IRAM_ATTR SolenoidController::endPulseCallback()
+    portENTER_CRITICAL_SAFE(&controller->pulseMux);
+    // A dispatch that raced with a restart of this output is stale
+    if (now - output->startUs < output->pulseUs)
+    {
+        portEXIT_CRITICAL_SAFE(&controller->pulseMux);
+        return;
+    }
+
+#if SOLENOID_DRIVE_LEDC
+    if (output->phase == PHASE_KICK && output->strike.holdUs)
+    {
+        // Kick done, drop to the hold duty until the envelope ends
+        setDuty(SOLENOID_LEDC_CHANNEL + output->channel, output->strike.holdDuty);
+        output->phase = PHASE_HOLD;
+        output->pulseUs += output->strike.holdUs;
+        esp_timer_start_once(output->timer, output->strike.holdUs);
+        portEXIT_CRITICAL_SAFE(&controller->pulseMux);
+        return;
+    }
+
+    setDuty(SOLENOID_LEDC_CHANNEL + output->channel, 0);
+    output->phase = PHASE_IDLE;
+    output->active = false;
+    TRACE(TRACE_PULSE_OFF, output->channel, now - output->startUs);
+#else
+    clearPins(output->clearMask);
+    for (PulseOutput &ended : controller->outputs)
+    {
+        if (output->clearChannels & (1 << ended.channel))
+        {
+            ended.active = false;
+            TRACE(TRACE_PULSE_OFF, ended.channel, now - ended.startUs);
+        }
+    }
+    output->clearMask = {0, 0};
+    output->clearChannels = 0;
+#endif
+    portEXIT_CRITICAL_SAFE(&controller->pulseMux);
+}
+
+// Runs from the esp_timer task when a batch scheduled ahead is due
+void IRAM_ATTR SolenoidController::firePulseCallback(void *arg)
 {
-  if (_instance)
-  {
-    digitalWrite(_instance->solenoidPin, LOW);
-    digitalWrite(_instance->solenoidPin2, LOW);
-    _instance->pulseActive = false;
-  }
+    PulseOutput *output = static_cast<PulseOutput *>(arg);
+    output->controller->processBeats(output->batch);
 }
 
 void SolenoidController::init() {
-    pinMode(solenoidPin, OUTPUT);
-    pinMode(solenoidPin2, OUTPUT);
-    digitalWrite(solenoidPin, LOW);
-    digitalWrite(solenoidPin2, LOW);
+    for (PulseOutput &output : outputs) {
+#if SOLENOID_DRIVE_LEDC
+        uint8_t ledcChannel = SOLENOID_LEDC_CHANNEL + output.channel;
+        ledcSetup(ledcChannel, SOLENOID_PWM_FREQ, SOLENOID_PWM_RES);
+        ledcAttachPin(output.pin, ledcChannel);
+        ledcWrite(ledcChannel, 0);
+#else
+        pinMode(output.pin, OUTPUT);
+        digitalWrite(output.pin, LOW);
+#endif
+
+        esp_timer_create_args_t timerArgs = {};
+        timerArgs.callback = endPulseCallback;
+        timerArgs.arg = &output;
+        timerArgs.dispatch_method = ESP_TIMER_TASK;
+        timerArgs.name = "solenoid";
+        if (esp_timer_create(&timerArgs, &output.timer) != ESP_OK) {
+            Serial.println("Failed to create solenoid pulse timer");
+        }
+
+        timerArgs.callback = firePulseCallback;
+        timerArgs.name = "solenoid_fire";
+        if (esp_timer_create(&timerArgs, &output.fireTimer) != ESP_OK) {
+            Serial.println("Failed to create solenoid fire timer");
+        }
+    }
+}
+
+SolenoidController::Strike IRAM_ATTR SolenoidController::planStrike(const SolenoidHit &hit) const {
+    Strike strike = {0, 0, 0};
+#if SOLENOID_DRIVE_LEDC
+    // Velocity sets the full-power kick; hard hits keep the plunger down
+    // with a PWM hold instead of full current
+    strike.kickUs = SOLENOID_KICK_MIN_US +
+                    uint32_t(SOLENOID_KICK_MAX_US - SOLENOID_KICK_MIN_US) * hit.velocity / 255;
+    if (hit.velocity >= SOLENOID_HOLD_VELOCITY) {
+        strike.holdUs = SOLENOID_HOLD_US;
+        strike.holdDuty = SOLENOID_HOLD_DUTY;
+    }
+#else
+    strike.kickUs = uint32_t(hit.state == ACCENT ? accentPulseMs : weakPulseMs) * 1000UL;
+#endif
+    return strike;
 }
 
-void SolenoidController::processBeat(uint8_t channel, BeatState beatState) {
-    if (beatState == ACCENT || beatState == WEAK) {
-        digitalWrite((channel ? solenoidPin : solenoidPin2), HIGH);
+void IRAM_ATTR SolenoidController::recordStrike(PulseOutput &output, const Strike &strike, uint32_t now) {
+    // The hold counts at its duty; energy is V^2/R over that full-power time
+    uint32_t equivalentUs = strike.kickUs +
+                            uint32_t(uint64_t(strike.holdUs) * strike.holdDuty / SOLENOID_PWM_FULL_DUTY);
+    uint64_t powerMw = uint64_t(SOLENOID_SUPPLY_MV) * SOLENOID_SUPPLY_MV / SOLENOID_COIL_MOHM;
 
-        // Schedule turning off the solenoid after the appropriate duration
-        float pulseDuration = (beatState == ACCENT) ? (accentPulseMs / 1000.0f) : (weakPulseMs / 1000.0f);
+    SolenoidStats &stats = output.stats;
+    stats.lastKickUs = strike.kickUs;
+    stats.lastHoldUs = strike.holdUs;
+    stats.lastEnergyUj = uint32_t(powerMw * equivalentUs / 1000); // mW x us = nJ
+    stats.totalStrikes++;
 
-        pulseTicker.once(pulseDuration, endPulseCallback);
+    uint32_t elapsed = now - output.windowStartUs;
+    if (stats.totalStrikes == 1 || elapsed >= 1000000UL) {
+        if (stats.totalStrikes > 1) {
+            stats.dutyPermille = uint16_t(uint64_t(output.windowOnUs) * 1000 / elapsed);
+        }
+        output.windowStartUs = now;
+        output.windowOnUs = 0;
+    }
+    output.windowOnUs += equivalentUs;
+
+    TRACE(TRACE_STRIKE, output.channel, stats.lastEnergyUj);
+}
+
+// Ends a grouped pulse on the output's own timer, at the width it has left
+void IRAM_ATTR SolenoidController::splitFromGroup(PulseOutput &member, uint32_t now) {
+    uint32_t elapsed = now - member.startUs;
+    if (elapsed >= member.pulseUs) {
+        // Due already; the group's stopped timer would have ended it
+        clearPins(member.mask);
+        member.active = false;
+        TRACE(TRACE_PULSE_OFF, member.channel, elapsed);
+        return;
+    }
+    member.clearMask = member.mask;
+    member.clearChannels = 1 << member.channel;
+    esp_timer_start_once(member.timer, member.pulseUs - elapsed);
+}
+
+uint32_t IRAM_ATTR SolenoidController::startGpioPulses(const Strike strikes[FIXED_CHANNEL_COUNT], uint8_t firing) {
+    PinMask setMask = {0, 0};
+    for (PulseOutput &output : outputs) {
+        if (firing & (1 << output.channel)) {
+            setMask.low |= output.mask.low;
+            setMask.high |= output.mask.high;
+        }
+    }
+
+    // A new beat restarts the channel's pulse; take it out of any group
+    // a previous tick left pending so that group cannot end it early. A
+    // group it owned hands its other members their own timers.
+    uint32_t restartUs = micros();
+    for (PulseOutput &output : outputs) {
+        if (firing & (1 << output.channel)) {
+            esp_timer_stop(output.timer);
+            for (PulseOutput &member : outputs) {
+                uint8_t bit = 1 << member.channel;
+                if (&member != &output && (output.clearChannels & bit) && !(firing & bit)) {
+                    splitFromGroup(member, restartUs);
+                }
+            }
+            output.clearMask = {0, 0};
+            output.clearChannels = 0;
+        } else {
+            output.clearChannels &= ~firing;
+            output.clearMask.low &= ~setMask.low;
+            output.clearMask.high &= ~setMask.high;
+        }
+    }
+
+    // Group the firing channels by pulse width under the first one's timer
+    uint8_t grouped = 0;
+    for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++) {
+        if (!(firing & (1 << ch)) || (grouped & (1 << ch))) {
+            continue;
+        }
+        PulseOutput &owner = outputs[ch];
+        for (uint8_t other = ch; other < FIXED_CHANNEL_COUNT; other++) {
+            if ((firing & (1 << other)) && strikes[other].kickUs == strikes[ch].kickUs) {
+                owner.clearMask.low |= outputs[other].mask.low;
+                owner.clearMask.high |= outputs[other].mask.high;
+                owner.clearChannels |= 1 << other;
+                grouped |= 1 << other;
+            }
+        }
+    }
+
+    // All pins HIGH together; the cycles between the bank writes are the skew
+    uint32_t startCycles = ESP.getCycleCount();
+    setPins(setMask);
+    uint32_t skewCycles = ESP.getCycleCount() - startCycles;
+    uint32_t now = micros();
+
+    for (PulseOutput &output : outputs) {
+        if (firing & (1 << output.channel)) {
+            output.startUs = now;
+            output.pulseUs = strikes[output.channel].kickUs;
+            output.active = true;
+        }
+        if (output.clearChannels && (firing & (1 << output.channel))) {
+            esp_timer_start_once(output.timer, output.pulseUs);
+        }
+    }
+    return skewCycles;
+}
+
+void IRAM_ATTR SolenoidController::startLedcEnvelope(PulseOutput &output, const Strike &strike) {
+    esp_timer_stop(output.timer);
+    setDuty(SOLENOID_LEDC_CHANNEL + output.channel, SOLENOID_PWM_FULL_DUTY);
+
+    output.strike = strike;
+    output.phase = PHASE_KICK;
+    output.startUs = micros();
+    output.pulseUs = strike.kickUs;
+    output.active = true;
+    esp_timer_start_once(output.timer, strike.kickUs);
+}
+
+void IRAM_ATTR SolenoidController::processBeats(const SolenoidHit hits[FIXED_CHANNEL_COUNT]) {
+    Strike strikes[FIXED_CHANNEL_COUNT] = {};
+    uint8_t firing = 0;
+
+    for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++) {
+        if ((hits[ch].state == ACCENT || hits[ch].state == WEAK) && outputs[ch].timer) {
+            strikes[ch] = planStrike(hits[ch]);
+            firing |= 1 << ch;
+        }
+    }
+    if (!firing) {
+        return;
+    }
+
+    portENTER_CRITICAL(&pulseMux);
+#if SOLENOID_DRIVE_LEDC
+    for (PulseOutput &output : outputs) {
+        if (firing & (1 << output.channel)) {
+            startLedcEnvelope(output, strikes[output.channel]);
+        }
+    }
+#else
+    [[maybe_unused]] uint32_t skewCycles = startGpioPulses(strikes, firing);
+#endif
+    portEXIT_CRITICAL(&pulseMux);
+
+#if !SOLENOID_DRIVE_LEDC
+    TRACE(TRACE_TRIGGER, firing, skewCycles);
+#endif
+    uint32_t now = micros();
+    for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++) {
+        if (firing & (1 << ch)) {
+            recordStrike(outputs[ch], strikes[ch], now);
+            TRACE(TRACE_PULSE_ON, ch, strikes[ch].kickUs + strikes[ch].holdUs);
+        }
+    }
+}
+
+void IRAM_ATTR SolenoidController::scheduleBeats(const SolenoidHit hits[FIXED_CHANNEL_COUNT], uint32_t delayUs) {
+    if (delayUs == 0) {
+        processBeats(hits);
+        return;
+    }
+
+    // The first firing channel's fire timer carries the whole batch
+    for (PulseOutput &output : outputs) {
+        if (hits[output.channel].state != SILENT && output.fireTimer) {
+            esp_timer_stop(output.fireTimer);
+            memcpy(output.batch, hits, sizeof(output.batch));
+            esp_timer_start_once(output.fireTimer, delayUs);
+            return;
+        }
     }
 }
 
@@ -38,5 +334,14 @@ void SolenoidController::setPulseDurations(uint16_t weakMs, uint16_t accentMs) {
 }
 
 bool SolenoidController::isPulseActive() const {
-    return pulseActive;
+    for (const PulseOutput &output : outputs) {
+        if (output.active) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SolenoidController::isPulseActive(uint8_t channel) const {
+    return channel < FIXED_CHANNEL_COUNT && outputs[channel].active;
 }
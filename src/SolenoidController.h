@@ -2,42 +2,141 @@
 #define SOLENOID_CONTROLLER_H
 
 #include <Arduino.h>
-#include <Ticker.h>
+#include <esp_timer.h>
 #include "MetronomeState.h"
 #include "config.h"
 
+// One channel's beat on a tick: accent level plus strike velocity (0-255)
+struct SolenoidHit
+{
+  BeatState state;
+  uint8_t velocity;
+};
+
+// Per-channel drive figures, refreshed on every strike
+struct SolenoidStats
+{
+  uint32_t lastKickUs;      // Full-power part of the last strike
+  uint32_t lastHoldUs;      // PWM hold part of the last strike
+  uint32_t lastEnergyUj;    // Coil energy of the last strike
+  uint16_t dutyPermille;    // Full-power equivalent on-time over the last second
+  uint32_t totalStrikes;
+};
+
 class SolenoidController
 {
 private:
-  uint8_t solenoidPin;
-  uint8_t solenoidPin2;
-  uint16_t accentPulseMs;
+  // Output pins as GPIO register masks: GPIO 0-31 and GPIO 32-39
+  struct PinMask
+  {
+    uint32_t low;
+    uint32_t high;
+  };
+
+  // Envelope of one strike: full power for kickUs, then holdDuty for holdUs
+  struct Strike
+  {
+    uint32_t kickUs;
+    uint32_t holdUs;
+    uint16_t holdDuty;
+  };
+
+  enum PulsePhase : uint8_t
+  {
+    PHASE_IDLE,
+    PHASE_KICK,
+    PHASE_HOLD
+  };
+
+  // Each output has its own one-shot timer and pulse state, so a beat on
+  // one channel never cuts short a pulse on the other. In GPIO drive,
+  // outputs fired on the same tick with the same width share the first
+  // one's timer and are cleared together.
+  struct PulseOutput
+  {
+    SolenoidController *controller;
+    uint8_t pin;
+    uint8_t channel;
+    PinMask mask;
+    esp_timer_handle_t timer;
+    volatile bool active;
+    volatile uint32_t startUs;
+    uint32_t pulseUs;
+    PinMask clearMask;     // Pins this output's timer clears
+    uint8_t clearChannels; // Channels whose pulse ends with this timer
+    esp_timer_handle_t fireTimer;            // Starts a batch scheduled ahead of time
+    SolenoidHit batch[FIXED_CHANNEL_COUNT];  // Hits the fire timer will play
+    volatile PulsePhase phase;               // LEDC drive envelope state
+    Strike strike;
+    SolenoidStats stats;
+    uint32_t windowStartUs;
+    uint32_t windowOnUs;
+  };
+
+  PulseOutput outputs[FIXED_CHANNEL_COUNT] = {};
   uint16_t weakPulseMs;
-  Ticker pulseTicker;
-  bool pulseActive = false;
+  uint16_t accentPulseMs;
+  portMUX_TYPE pulseMux = portMUX_INITIALIZER_UNLOCKED;
+
+  static PinMask maskForPin(uint8_t pin);
+  static void IRAM_ATTR setPins(const PinMask &mask);
+  static void IRAM_ATTR clearPins(const PinMask &mask);
+  static void IRAM_ATTR setDuty(uint8_t ledcChannel, uint32_t duty);
+  static void IRAM_ATTR endPulseCallback(void *arg);
+  static void IRAM_ATTR firePulseCallback(void *arg);
 
-  static SolenoidController *_instance;
-  static void IRAM_ATTR endPulseCallback(); // Just declaration, implementation in cpp
+  Strike IRAM_ATTR planStrike(const SolenoidHit &hit) const;
+  void IRAM_ATTR recordStrike(PulseOutput &output, const Strike &strike, uint32_t now);
+  void IRAM_ATTR splitFromGroup(PulseOutput &member, uint32_t now);
+  uint32_t IRAM_ATTR startGpioPulses(const Strike strikes[FIXED_CHANNEL_COUNT], uint8_t firing);
+  void IRAM_ATTR startLedcEnvelope(PulseOutput &output, const Strike &strike);
 
 public:
   SolenoidController(uint8_t pin_1, uint8_t pin_2, uint16_t weakMs = SOLENOID_PULSE_MS, uint16_t accentMs = ACCENT_PULSE_MS)
-      : solenoidPin(pin_1), solenoidPin2(pin_2), weakPulseMs(weakMs), accentPulseMs(accentMs)
+      : weakPulseMs(weakMs), accentPulseMs(accentMs)
   {
-    _instance = this;
+    const uint8_t pins[FIXED_CHANNEL_COUNT] = {pin_1, pin_2};
+    for (uint8_t ch = 0; ch < FIXED_CHANNEL_COUNT; ch++)
+    {
+      outputs[ch].controller = this;
+      outputs[ch].pin = pins[ch];
+      outputs[ch].channel = ch;
+      outputs[ch].mask = maskForPin(pins[ch]);
+    }
   }
 
   ~SolenoidController()
   {
-    if (_instance == this)
+    for (PulseOutput &output : outputs)
     {
-      _instance = nullptr;
+      if (output.timer)
+      {
+        esp_timer_stop(output.timer);
+        esp_timer_delete(output.timer);
+      }
+      if (output.fireTimer)
+      {
+        esp_timer_stop(output.fireTimer);
+        esp_timer_delete(output.fireTimer);
+      }
     }
   }
 
   void init();
-  void processBeat(uint8_t channel, BeatState beatState);
+
+  // Fire every channel with a sounding beat on this tick. In GPIO drive
+  // all pins go HIGH in one register write per GPIO bank; in LEDC drive
+  // each channel plays its velocity envelope.
+  void IRAM_ATTR processBeats(const SolenoidHit hits[FIXED_CHANNEL_COUNT]);
+
+  // Same as processBeats(), but `delayUs` from now. Used to fire early
+  // enough that the strike lands on the tick despite solenoid travel.
+  void IRAM_ATTR scheduleBeats(const SolenoidHit hits[FIXED_CHANNEL_COUNT], uint32_t delayUs);
+
   void setPulseDurations(uint16_t weakMs, uint16_t accentMs);
   bool isPulseActive() const;
+  bool isPulseActive(uint8_t channel) const;
+  const SolenoidStats &getStats(uint8_t channel) const { return outputs[channel < FIXED_CHANNEL_COUNT ? channel : 0].stats; }
 };
 
-#endif // SOLENOID_CONTROLLER_H
\ No newline at end of file
+#endif // SOLENOID_CONTROLLER_H
@@ -0,0 +1,88 @@
+#include "SongChain.h"
+
+static const char *SONG_NAMESPACE = "song";
+static const char *SONG_KEY = "chain";
+
+bool SongChain::begin()
+{
+    opened = prefs.begin(SONG_NAMESPACE, false);
+    if (!opened)
+    {
+        Serial.println("Failed to open song storage");
+        return false;
+    }
+
+    count = 0;
+    size_t length = prefs.getBytesLength(SONG_KEY);
+    uint8_t blob[sizeof(Header) + sizeof(entries)];
+    if (length < sizeof(Header) || length > sizeof(blob))
+    {
+        return true;
+    }
+    prefs.getBytes(SONG_KEY, blob, length);
+
+    Header header;
+    memcpy(&header, blob, sizeof(Header));
+    if (header.format != SONG_FORMAT || header.count > SONG_MAX_ENTRIES ||
+        length != sizeof(Header) + header.count * sizeof(ChainEntry))
+    {
+        return true;
+    }
+    count = header.count;
+    loop = header.flags & FLAG_LOOP;
+    memcpy(entries, blob + sizeof(Header), count * sizeof(ChainEntry));
+
+    Serial.printf("Song: %u entries%s\n", count, loop ? ", looping" : "");
+    return true;
+}
+
+bool SongChain::save()
+{
+    if (!opened)
+    {
+        return false;
+    }
+    if (count == 0)
+    {
+        prefs.remove(SONG_KEY);
+        return true;
+    }
+
+    Header header = {SONG_FORMAT, count, uint8_t(loop ? FLAG_LOOP : 0), 0};
+    uint8_t blob[sizeof(Header) + sizeof(entries)];
+    memcpy(blob, &header, sizeof(Header));
+    memcpy(blob + sizeof(Header), entries, count * sizeof(ChainEntry));
+    size_t length = sizeof(Header) + count * sizeof(ChainEntry);
+    return prefs.putBytes(SONG_KEY, blob, length) == length;
+}
+
+bool SongChain::append(const ChainEntry &entry)
+{
+    if (count >= SONG_MAX_ENTRIES || entry.presetSlot >= PRESET_COUNT || entry.bars == 0)
+    {
+        return false;
+    }
+    entries[count++] = entry;
+    return true;
+}
+
+uint8_t SongChain::resolve(PresetBank &bank, SongEntry *out) const
+{
+    uint8_t resolved = 0;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        SongEntry &entry = out[resolved];
+        if (!bank.recall(entries[i].presetSlot, entry.preset))
+        {
+            Serial.printf("Song entry %u: preset %u is empty, skipped\n", i + 1, entries[i].presetSlot + 1);
+            continue;
+        }
+        if (entries[i].bpm)
+        {
+            entry.preset.bpm = constrain(entries[i].bpm, MIN_GLOBAL_BPM, MAX_GLOBAL_BPM);
+        }
+        entry.bars = entries[i].bars;
+        resolved++;
+    }
+    return resolved;
+}
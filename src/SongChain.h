@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include "config.h"
+#include "PresetBank.h"
+
+// One stored song step, 4 bytes
+struct __attribute__((packed)) ChainEntry
+{
+    uint8_t presetSlot;     // Preset bank slot
+    uint8_t bars;           // Bars of channel 1 it plays for (1-255)
+    uint16_t bpm;           // Tempo; 0 plays the preset's own
+};
+
+// A song step ready to play: the preset with its tempo resolved
+struct SongEntry
+{
+    Preset preset;
+    uint8_t bars;
+};
+
+// Song (set list) mode: a chain of preset slots, each played for a number
+// of bars, optionally at its own tempo and optionally looping. Stored as
+// one small NVS blob of SONG_MAX_ENTRIES entries at most. Before playing,
+// resolve() reads each slot's preset once, so nothing touches flash while
+// the song runs; Timing plays the resolved entries (see Timing::loadSong).
+class SongChain
+{
+private:
+    struct __attribute__((packed)) Header
+    {
+        uint8_t format;     // SONG_FORMAT
+        uint8_t count;
+        uint8_t flags;      // Bit 0 loop
+        uint8_t reserved;
+    };
+
+    static const uint8_t FLAG_LOOP = 0x01;
+
+    Preferences prefs;
+    bool opened = false;
+    uint8_t count = 0;
+    bool loop = false;
+    ChainEntry entries[SONG_MAX_ENTRIES] = {};
+
+public:
+    // Open the store and load the saved chain
+    bool begin();
+    bool save();
+
+    void clear() { count = 0; }
+    bool append(const ChainEntry &entry);
+    void setLoop(bool value) { loop = value; }
+
+    bool isLooping() const { return loop; }
+    uint8_t size() const { return count; }
+    const ChainEntry &getEntry(uint8_t index) const { return entries[index < count ? index : 0]; }
+
+    // Resolve the chain into `out` (SONG_MAX_ENTRIES long) from the bank.
+    // Entries whose slot is empty are left out; returns how many remain.
+    uint8_t resolve(PresetBank &bank, SongEntry *out) const;
+};
@@ -0,0 +1,75 @@
+#include "TempoRamp.h"
+#include <math.h>
+
+// Length of a PPQN tick at 1 BPM
+static const float TICK_US_AT_1_BPM = 60000000.0f / 96;
+
+// 2^y for the exponents a ramp reaches, without libm: 2^round(y) goes
+// straight into the float's exponent, the rest is a Taylor series of e^t
+// with |t| <= ln(2) / 2, exact to float precision after eight terms
+static float IRAM_ATTR exp2Fast(float y)
+{
+    int32_t whole = int32_t(y >= 0.0f ? y + 0.5f : y - 0.5f);
+    float t = (y - whole) * 0.69314718f;
+    float fraction = 1.0f + t * (1.0f + t * (1.0f / 2 + t * (1.0f / 6 + t * (1.0f / 24 +
+                     t * (1.0f / 120 + t * (1.0f / 720 + t * (1.0f / 5040)))))));
+    union
+    {
+        uint32_t bits;
+        float value;
+    } scale = {uint32_t(whole + 127) << 23};
+    return fraction * scale.value;
+}
+
+void TempoRamp::set(uint32_t startTick, uint32_t lengthTicks, uint16_t fromBpm, uint16_t toBpm, RampShape shape)
+{
+    this->startTick = startTick;
+    this->lengthTicks = !lengthTicks || !fromBpm || !toBpm ? 0 : max(lengthTicks, MIN_LENGTH_TICKS);
+    this->fromBpm = fromBpm;
+    this->toBpm = toBpm;
+    this->shape = shape;
+    if (!this->lengthTicks)
+        return;
+
+    slope = float(int32_t(toBpm) - int32_t(fromBpm)) / this->lengthTicks;
+    rate = log2f(float(toBpm) / fromBpm) / this->lengthTicks;
+
+    // The first tick lasts (1 - 2^-rate) / (rate ln 2) of one at the start
+    // tempo; every later tick is 2^-rate times the one before
+    float decay = rate * float(M_LN2);
+    firstPeriodUs = TICK_US_AT_1_BPM / fromBpm * (decay != 0.0f ? -expm1f(-decay) / decay : 1.0f);
+}
+
+float IRAM_ATTR TempoRamp::bpmAt(uint32_t tick) const
+{
+    int32_t x = position(tick);
+    if (x < 0)
+        return fromBpm;
+    if (x >= int32_t(lengthTicks))
+        return toBpm;
+    if (shape == RAMP_EXPONENTIAL)
+        return fromBpm * exp2Fast(rate * x);
+    return fromBpm + slope * x;
+}
+
+float IRAM_ATTR TempoRamp::periodUs(uint32_t tick) const
+{
+    int32_t x = position(tick);
+    if (x < 0)
+        return TICK_US_AT_1_BPM / fromBpm;
+    if (x >= int32_t(lengthTicks))
+        return TICK_US_AT_1_BPM / toBpm;
+    if (shape == RAMP_EXPONENTIAL)
+        return firstPeriodUs * exp2Fast(-rate * x);
+
+    // Linear: the beat length 1/bpm integrates to ln(1 + s / bpm) / s over
+    // the tick, s the slope. As 2 atanh(z) with z = s / (2 bpm + s), which
+    // stays below 0.15 across the tempo range for a ramp of a quarter note
+    // or more, five series terms are exact to float precision and a flat
+    // ramp needs no special case.
+    float twiceBpm = 2.0f * (fromBpm + slope * x) + slope;
+    float z = slope / twiceBpm;
+    float w = z * z;
+    return 2.0f * TICK_US_AT_1_BPM / twiceBpm *
+           (1.0f + w * (1.0f / 3 + w * (1.0f / 5 + w * (1.0f / 7 + w * (1.0f / 9)))));
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+enum RampShape : uint8_t
+{
+    RAMP_LINEAR = 0,    // Same BPM change every beat
+    RAMP_EXPONENTIAL    // Same tempo ratio every beat
+};
+
+// Tempo ramp (accelerando or ritardando) over a stretch of PPQN ticks.
+// The tempo is a function of the tick position, and every tick lasts the
+// integral of the beat length over it, in closed form. A tick's length
+// therefore never depends on how earlier ticks were rounded, and every
+// device that plays the same ramp computes the same beat times.
+// periodUs() and bpmAt() are constant time and stay in IRAM (no libm).
+class TempoRamp
+{
+public:
+    static constexpr uint32_t MIN_LENGTH_TICKS = 96;    // A quarter note
+
+private:
+    uint32_t startTick = 0;
+    uint32_t lengthTicks = 0;   // 0 = no ramp
+    uint16_t fromBpm = DEFAULT_BPM;
+    uint16_t toBpm = DEFAULT_BPM;
+    RampShape shape = RAMP_LINEAR;
+
+    // Set up by set()
+    float slope = 0.0f;         // Linear: BPM per tick
+    float rate = 0.0f;          // Exponential: log2 of the tempo ratio per tick
+    float firstPeriodUs = 0.0f; // Exponential: length of the first tick
+
+    int32_t position(uint32_t tick) const { return int32_t(tick - startTick); }
+
+public:
+    void set(uint32_t startTick, uint32_t lengthTicks, uint16_t fromBpm, uint16_t toBpm, RampShape shape);
+    void clear() { lengthTicks = 0; }
+
+    bool isSet() const { return lengthTicks > 0; }
+    bool hasStarted(uint32_t tick) const { return position(tick) >= 0; }
+    bool isOver(uint32_t tick) const { return position(tick) >= int32_t(lengthTicks); }
+
+    uint32_t getStartTick() const { return startTick; }
+    uint32_t getLengthTicks() const { return lengthTicks; }
+    uint16_t getFromBpm() const { return fromBpm; }
+    uint16_t getToBpm() const { return toBpm; }
+    RampShape getShape() const { return shape; }
+
+    // Tempo at the start of `tick`
+    float bpmAt(uint32_t tick) const;
+
+    // Time from the start of `tick` to the start of the next one
+    float periodUs(uint32_t tick) const;
+};
@@ -1,15 +1,15 @@
 #include "Timing.h"
 #include "SolenoidController.h"
 // Remove AudioController include
-#include "Display.h"
 #include "LEDController.h"
+#include "FrameClock.h"
 #include "BuzzerController.h"
 
 // Initialize static instance pointer
 Timing *Timing::instance = nullptr;
 
 // Static callback wrappers
-void Timing::onClockPulseStatic(uint32_t tick)
+void IRAM_ATTR Timing::onClockPulseStatic(uint32_t tick)
 {
     if (instance)
     {
@@ -25,7 +25,7 @@ void Timing::onSync24Static(uint32_t tick)
     }
 }
 
-void Timing::onPPQNStatic(uint32_t tick)
+void IRAM_ATTR Timing::onPPQNStatic(uint32_t tick)
 {
     if (instance)
     {
@@ -48,9 +48,9 @@ void Timing::onStepStatic(uint32_t tick)
     }
 }
 
-void Timing::setDisplay(Display *displayRef)
+void Timing::setFrameClock(FrameClock *clock)
 {
-    display = displayRef;
+    frameClock = clock;
 }
 
 void Timing::setLEDController(LEDController *controller)
@@ -63,25 +63,10 @@ void Timing::init()
     // Initialize uClock
     uClock.init();
 
-    // Set uClock mode based on leader status
-    if (wirelessSync.isInitialized())
-    {
-        if (wirelessSync.isLeader())
-        {
-            // Leader mode - internal clock
-            uClock.setMode(uClock.INTERNAL_CLOCK);
-        }
-        else
-        {
-            // Follower mode - external clock
-            uClock.setMode(uClock.EXTERNAL_CLOCK);
-        }
-    }
-    else
-    {
-        // No wireless sync, use internal clock
-        uClock.setMode(uClock.INTERNAL_CLOCK);
-    }
+    // Play from the internal clock until leader negotiation says
+    // otherwise (see followLeadership)
+    externalClock = false;
+    uClock.setMode(uClock.INTERNAL_CLOCK);
 
     // Register callbacks
     uClock.setOnSync24(onSync24Static);
@@ -90,60 +75,302 @@ void Timing::init()
 
     uClock.setPPQN(uClock.PPQN_96);
     uClock.setTempo(state.bpm);
+    refreshTickPeriod();
+
+    if (!transportLock)
+    {
+        transportLock = xSemaphoreCreateMutex();
+    }
+}
+
+void Timing::refreshTickPeriod()
+{
+    // A ramp sets the period tick by tick
+    if (tempoRamp.isSet() && tempoRamp.hasStarted(lastTick))
+        return;
+
+    // Follows the measured tempo of an external clock as well
+    float tempo = uClock.getTempo();
+    if (tempo > 0.0f)
+    {
+        tickPeriodUs = uint32_t(60000000.0f / (tempo * 96));
+    }
+}
+
+// Wireless sync comes up in the background and negotiates a leader
+// after boot; switch the clock source whenever the outcome changes
+void Timing::followLeadership()
+{
+    if (!wirelessSync.isInitialized() || !wirelessSync.hasNegotiated() || wirelessSync.isNegotiating())
+        return;
+
+    bool follow = !wirelessSync.isLeader();
+    if (follow != externalClock)
+    {
+        externalClock = follow;
+        uClock.setMode(follow ? uClock.EXTERNAL_CLOCK : uClock.INTERNAL_CLOCK);
+    }
 }
 
 void Timing::update()
 {
-    // Check if running state has changed
-    if (state.isRunning != previousRunningState)
+    // The control task may be starting or stopping the clock
+    xSemaphoreTake(transportLock, portMAX_DELAY);
+
+    adoptPreset();
+    refreshTickPeriod();
+    followLeadership();
+
+    TempoRamp received;
+    if (wirelessSync.takeRamp(received))
+    {
+        installRamp(received);
+    }
+    steerRamp();
+
+    if (!state.isRunning && !state.isPaused && wirelessSync.takeSong(song, songLength, songLoop))
+    {
+        Serial.printf("Song received: %u entries\n", songLength);
+    }
+
+    if (grooveChanges.poll(state, GROOVE_LAYOUT))
+    {
+        recompileGroove();
+    }
+
+    applyTransport();
+    followSong();
+
+    xSemaphoreGive(transportLock);
+}
+
+void Timing::requestTransport(TransportRequest request, uint32_t us)
+{
+    portENTER_CRITICAL(&transportMux);
+    uint8_t next = (transportHead + 1) % TRANSPORT_QUEUE_SIZE;
+    if (next != transportTail)
     {
-        previousRunningState = state.isRunning;
+        transportRing[transportHead] = {us, request};
+        transportHead = next;
+    }
+    portEXIT_CRITICAL(&transportMux);
+}
+
+void Timing::serviceTransport()
+{
+    if (!transportLock)
+        return;
+    xSemaphoreTake(transportLock, portMAX_DELAY);
+    applyTransport();
+    xSemaphoreGive(transportLock);
+}
 
-        // Handle state changes
-        if (state.isRunning && !state.isPaused)
+// The one place the transport changes; the caller holds transportLock
+void Timing::applyTransport()
+{
+    for (;;)
+    {
+        portENTER_CRITICAL(&transportMux);
+        bool pending = transportTail != transportHead;
+        TransportEvent event = transportRing[transportTail];
+        if (pending)
         {
-            start();
+            transportTail = (transportTail + 1) % TRANSPORT_QUEUE_SIZE;
         }
-        else if (!state.isRunning)
+        portEXIT_CRITICAL(&transportMux);
+        if (!pending)
+            return;
+
+        if (event.request == TRANSPORT_STOP)
         {
-            if (state.isPaused)
+            state.isRunning = false;
+            state.isPaused = false;
+            state.currentBeat = 0;
+            state.globalTick = 0;
+            state.lastBeatTime = 0;
+            state.tickFraction = 0.0f;
+            state.lastPpqnTick = 0;
+            stop();
+            for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++)
             {
-                pause();
+                state.getChannel(i).resetBeat();
             }
+        }
+        else if (state.isRunning)
+        {
+            state.isRunning = false;
+            state.isPaused = true;
+            pause();
+        }
+        else
+        {
+            // uClock.pause() toggles, so it also resumes
+            bool resume = state.isPaused;
+            state.isRunning = true;
+            state.isPaused = false;
+            if (resume)
+                pause();
             else
-            {
-                stop();
-            }
+                start();
+        }
+
+        uint32_t latencyUs = micros() - event.us;
+        transportLatencyUs = latencyUs;
+        if (latencyUs > maxTransportLatencyUs)
+        {
+            maxTransportLatencyUs = latencyUs;
         }
     }
 }
 
-void Timing::onBeatEvent(uint8_t channel, BeatState beatState)
+// Configuration that plays PPQN tick `tick`: an armed preset from its
+// switch tick on, the live state before that
+IRAM_ATTR const MetronomeState &Timing::configAt(uint32_t tick, uint32_t &originTick) const
 {
-    solenoidController.processBeat(channel, beatState);
-    // Remove audioController.processBeat call
-    if (buzzerController)
+    if (nextConfig && int32_t(tick - nextConfigTick) >= 0)
     {
-        buzzerController->processBeat(channel, beatState);
+        originTick = nextConfigTick;
+        return *nextConfig;
+    }
+    originTick = cycleOriginTick;
+    return *playingConfig;
+}
+
+BeatState IRAM_ATTR Timing::beatAt(uint8_t channel, uint32_t tick) const
+{
+    uint32_t originTick;
+    const MetronomeState &config = configAt(tick, originTick);
+
+    // Effective-tick window covered by PPQN tick `tick` within its cycle
+    float multiplier = config.getCurrentMultiplier();
+    int64_t cycleTick = int64_t(tick - originTick);
+    int64_t toTick = int64_t(cycleTick * multiplier);
+    int64_t fromTick = int64_t(cycleTick * multiplier - multiplier);
+    return config.getChannel(channel).getBeatStateBetween(fromTick, toTick, config);
+}
+
+SolenoidHit IRAM_ATTR Timing::hitAt(uint8_t channel, uint32_t tick) const
+{
+    // Velocity comes from the channel's accent and weak volumes
+    uint32_t originTick;
+    const MetronomeChannel &ch = configAt(tick, originTick).getChannel(channel);
+    BeatState beatState = beatAt(channel, tick);
+    uint8_t velocity = beatState == ACCENT ? ch.getEffectiveStrongVolume() : ch.getEffectiveWeakVolume();
+    return {beatState, velocity};
+}
+
+// Every output is fired early by its own latency so that they all land on
+// the beat's tick: look `ahead` whole ticks forward, then wait out the rest.
+void IRAM_ATTR Timing::scheduleOutputs(uint32_t tick, uint32_t tickUs)
+{
+    uint32_t tickPeriodUs = this->tickPeriodUs;
+    if (tickPeriodUs == 0)
+        return;
+
+    // Solenoids: channels with the same latency share one batch so they
+    // keep firing in the same register write
+    uint8_t handled = 0;
+    for (uint8_t channel = 0; channel < FIXED_CHANNEL_COUNT; channel++)
+    {
+        if (handled & (1 << channel))
+            continue;
+
+        uint32_t latencyUs = outputLatencyUs[LATENCY_SOLENOID1 + channel];
+        uint32_t ahead = (latencyUs + tickPeriodUs - 1) / tickPeriodUs;
+        uint32_t target = tick + ahead;
+        SolenoidHit hits[FIXED_CHANNEL_COUNT] = {};
+        SolenoidHit late[FIXED_CHANNEL_COUNT] = {};
+        bool firing = false;
+        bool lateFiring = false;
+
+        for (uint8_t other = channel; other < FIXED_CHANNEL_COUNT; other++)
+        {
+            if (outputLatencyUs[LATENCY_SOLENOID1 + other] != latencyUs)
+                continue;
+            handled |= 1 << other;
+
+            // Already scheduled while the lookahead was longer
+            uint32_t next = solenoidNextTick[other];
+            if (target < next)
+                continue;
+            solenoidNextTick[other] = target + 1;
+
+            hits[other] = hitAt(other, target);
+            firing |= hits[other].state != SILENT;
+
+            // Ticks no lookahead reached (the first ones after start, or
+            // the ones a longer lookahead jumps over) play late, merged
+            for (uint32_t skipped = next < tick ? tick : next; skipped < target; skipped++)
+            {
+                SolenoidHit hit = hitAt(other, skipped);
+                if (hit.state > late[other].state)
+                {
+                    late[other] = hit;
+                }
+            }
+            lateFiring |= late[other].state != SILENT;
+        }
+
+        if (lateFiring)
+            solenoidController.processBeats(late);
+        if (firing)
+            solenoidController.scheduleBeats(hits, ahead * tickPeriodUs - latencyUs);
+    }
+
+    // LED flashes are timestamps, so they can be placed exactly
+    if (ledController)
+    {
+        uint32_t latencyUs = outputLatencyUs[LATENCY_LEDS];
+        uint32_t ahead = (latencyUs + tickPeriodUs - 1) / tickPeriodUs;
+        for (uint8_t channel = 0; channel < FIXED_CHANNEL_COUNT; channel++)
+        {
+            if (beatAt(channel, tick + ahead) != SILENT)
+            {
+                ledController->onChannelBeat(channel, tickUs + ahead * tickPeriodUs - latencyUs);
+            }
+        }
     }
 
-    // Trigger LED flash on active beats
-    if (ledController && beatState != SILENT)
+    // The buzzer shapes its sound in software, so it fires on the nearest
+    // tick and goes last
+    if (buzzerController)
     {
-        ledController->onChannelBeat(channel);
+        uint32_t ahead = (outputLatencyUs[LATENCY_BUZZER] + tickPeriodUs / 2) / tickPeriodUs;
+        for (uint8_t channel = 0; channel < FIXED_CHANNEL_COUNT; channel++)
+        {
+            BeatState beatState = beatAt(channel, tick + ahead);
+            if (beatState != SILENT)
+            {
+                buzzerController->processBeat(channel, beatState);
+            }
+        }
     }
 }
 
-void Timing::onClockPulse(uint32_t tick)
+void IRAM_ATTR Timing::onClockPulse(uint32_t tick)
 {
-    // Update the fractional tick position on every pulse
-    state.updateTickFraction(tick);
+    // Timestamp shared by every output and visual triggered by this tick
+    uint32_t tickUs = micros();
 
-    // Trigger global beat flash on quarter notes
-    if (tick % 96 == 0 && ledController)
+    if (tick == lastTick + 1 && lastTickUs)
     {
-        ledController->onGlobalBeat();
+        uint32_t interval = tickUs - lastTickUs;
+        if (interval > tickPeriodUs && interval - tickPeriodUs > maxTickDelayUs)
+        {
+            maxTickDelayUs = interval - tickPeriodUs;
+        }
     }
+    lastTick = tick;
+    lastTickUs = tickUs;
+
+    // Take over an armed preset on its bar boundary
+    switchPreset(tick);
+    followRamp(tick, tickUs);
+    uint32_t cycleTick = tick - cycleOriginTick;
+    const MetronomeState &config = *playingConfig;
+
+    // Update the fractional tick position on every pulse
+    state.updateTickFraction(cycleTick);
 
     // Always store the last PPQN tick for polyrhythm calculations
     state.lastPpqnTick = tick;
@@ -153,28 +380,24 @@ void Timing::onClockPulse(uint32_t tick)
         return;
 
     // Calculate effective tick based on multiplier
-    float multiplier = state.getCurrentMultiplier();
-    uint32_t effectiveTick = uint32_t(tick * multiplier);
+    float multiplier = config.getCurrentMultiplier();
+    uint32_t effectiveTick = uint32_t(cycleTick * multiplier);
 
     // Convert PPQN ticks to quarter note beats
     uint32_t quarterNoteTick = effectiveTick / 96;
 
-    // In polyrhythm mode, we need more frequent checks
-    if (state.isPolyrhythm() && state.getChannel(1).isEnabled())
-    {
-        // Check for channel 2 beats more frequently for smoother polyrhythm
-        MetronomeChannel &channel2 = state.getChannel(1);
-        BeatState ch2State = channel2.getPolyrhythmBeatState(tick, state);
+    // Outputs are scheduled ahead of the visual state below
+    scheduleOutputs(tick, tickUs);
 
-        if (ch2State != SILENT)
+    // In polyrhythm mode channel 2's steps fall between quarter notes
+    if (config.isPolyrhythm() && config.getChannel(1).isEnabled())
+    {
+        uint8_t step;
+        if (config.getChannel(1).getStepBetween(int64_t(effectiveTick) - int64_t(multiplier), effectiveTick, config,
+                                                step))
         {
-            onBeatEvent(1, ch2State);
             // Update the current beat for visualization
-            uint8_t ch1Length = state.getChannel(0).getBarLength();
-            float cycleProgress = float(state.globalTick % ch1Length) / float(ch1Length);
-            cycleProgress += state.tickFraction / float(ch1Length);
-            float beatPosition = cycleProgress * float(channel2.getBarLength());
-            channel2.updateBeat(uint32_t(beatPosition));
+            state.getChannel(1).updateBeat(step);
         }
     }
 
@@ -184,47 +407,405 @@ void Timing::onClockPulse(uint32_t tick)
         state.globalTick = quarterNoteTick;
         state.lastBeatTime = quarterNoteTick;
 
-        // Always process channel 1 on quarter notes
-        MetronomeChannel &channel1 = state.getChannel(0);
-        if (channel1.isEnabled())
+        // Publish the beat phase for the display and LED frame clock
+        if (frameClock)
         {
-            channel1.updateBeat(quarterNoteTick);
-            BeatState ch1State = channel1.getBeatState();
-            if (ch1State != SILENT)
-            {
-                onBeatEvent(0, ch1State);
-            }
+            uint32_t beatPeriodUs = tickPeriodUs * 96 / uint32_t(multiplier);
+            frameClock->publishBeat(quarterNoteTick, tickUs, beatPeriodUs);
         }
 
-        // Only process channel 2 here if NOT in polyrhythm mode
-        if (!state.isPolyrhythm())
+        // Channel 1 always steps on quarter notes
+        state.getChannel(0).updateBeat(quarterNoteTick);
+
+        // Channel 2 too, unless it runs as a polyrhythm
+        if (!config.isPolyrhythm())
         {
-            MetronomeChannel &channel2 = state.getChannel(1);
-            if (channel2.isEnabled())
-            {
-                channel2.updateBeat(quarterNoteTick);
-                BeatState ch2State = channel2.getBeatState();
-                if (ch2State != SILENT)
-                {
-                    onBeatEvent(1, ch2State);
-                }
-            }
+            state.getChannel(1).updateBeat(quarterNoteTick);
+        }
+    }
+}
+
+// Runs first on every tick: switches to a preset whose switch tick has
+// come, or exposes an armed one to the lookahead in beatAt(). The staged
+// state is complete, so taking it over is a pointer swap.
+void IRAM_ATTR Timing::switchPreset(uint32_t tick)
+{
+    portENTER_CRITICAL(&presetMux);
+    int8_t slot = armedSlot;
+    uint32_t at = switchTick;
+    bool due = slot >= 0 && int32_t(tick - at) >= 0;
+    if (due)
+    {
+        playingConfig = &presetStaging[slot];
+        playingSlot = slot;
+        armedSlot = -1;
+        cycleOriginTick = at;
+        if (stagedPeriodUs[slot])
+        {
+            tickPeriodUs = stagedPeriodUs[slot];
+        }
+    }
+    portEXIT_CRITICAL(&presetMux);
+
+    nextConfig = nullptr;
+    if (slot >= 0 && !due)
+    {
+        nextConfig = &presetStaging[slot];
+        nextConfigTick = at;
+    }
+}
+
+// Copies a preset that has taken over into the live state, then hands
+// the tick path back to it. Runs from the loop (or the transport), so the
+// clock follows a new tempo from here rather than from the tick path.
+void Timing::adoptPreset()
+{
+    int8_t slot = playingSlot;
+    if (slot < 0)
+        return;
+
+    uint16_t previousBpm = state.bpm;
+    PresetBank::apply(stagedPresets[slot], state);
+    recompileGroove();
+    grooveChanges.poll(state, GROOVE_LAYOUT);
+
+    portENTER_CRITICAL(&presetMux);
+    playingConfig = &state;
+    playingSlot = -1;
+    portEXIT_CRITICAL(&presetMux);
+
+    if (state.bpm != previousBpm)
+    {
+        setTempo(state.bpm);
+    }
+}
+
+// The live state's groove: built into the spare tables while the tick
+// path keeps reading the others, then swapped in with one store
+void Timing::recompileGroove()
+{
+    state.buildGroove();
+    portENTER_CRITICAL(&presetMux);
+    state.swapGroove();
+    portEXIT_CRITICAL(&presetMux);
+}
+
+// Length of this tick as the ramp integrates it, for the lookahead. The
+// tick path only notes where the clock is; the loop steers the tempo.
+void IRAM_ATTR Timing::followRamp(uint32_t tick, uint32_t tickUs)
+{
+    portENTER_CRITICAL(&rampMux);
+    TempoRamp ramp = tempoRamp;
+    if (ramp.isSet() && ramp.isOver(tick))
+    {
+        tempoRamp.clear();
+    }
+    rampTick = tick;
+    rampTickUs = tickUs;
+    portEXIT_CRITICAL(&rampMux);
+
+    if (!ramp.isSet() || !ramp.hasStarted(tick))
+        return;
+
+    tickPeriodUs = uint32_t(ramp.periodUs(tick));
+}
+
+// Keeps the internal clock on the ramp's timeline. The timer runs whole
+// microseconds per tick, so setting it to each tick's length would drift;
+// the tempo is set instead to the next tick's length less part of how
+// far the last tick came off the integrated timeline. On an external
+// clock only the displayed tempo follows.
+void Timing::steerRamp()
+{
+    if (!steeredRamp.isSet())
+        return;
+
+    portENTER_CRITICAL(&rampMux);
+    bool over = !tempoRamp.isSet();
+    uint32_t tick = rampTick;
+    uint32_t tickUs = rampTickUs;
+    portEXIT_CRITICAL(&rampMux);
+
+    // The tick path cleared it on its last tick; stay at the end tempo
+    if (over)
+    {
+        uint16_t bpm = steeredRamp.getToBpm();
+        steeredRamp.clear();
+        if (!externalClock)
+        {
+            uClock.setTempo(bpm);
+        }
+        refreshTickPeriod();
+        state.setBpm(bpm);
+        return;
+    }
+    if (!state.isRunning || !tickUs || !steeredRamp.hasStarted(tick))
+        return;
+
+    if (!rampAnchored)
+    {
+        rampAnchored = true;
+        anchorTickUs = tickUs;
+        idealTick = tick;
+        idealUs = 0.0;
+    }
+    for (; int32_t(tick - idealTick) > 0; idealTick++)
+    {
+        idealUs += steeredRamp.periodUs(idealTick);
+    }
+
+    if (!externalClock)
+    {
+        float periodUs = steeredRamp.periodUs(tick + 1);
+        float errorUs = float(double(tickUs - anchorTickUs) - idealUs);
+        float steerUs = constrain(errorUs * RAMP_STEER_GAIN, -periodUs * RAMP_STEER_LIMIT,
+                                  periodUs * RAMP_STEER_LIMIT);
+        uClock.setTempo(60000000.0f / (96 * (periodUs - steerUs)));
+    }
+
+    uint16_t bpm = uint16_t(steeredRamp.bpmAt(tick) + 0.5f);
+    if (bpm != state.bpm)
+    {
+        state.setBpm(bpm);
+    }
+}
+
+void Timing::installRamp(const TempoRamp &ramp)
+{
+    portENTER_CRITICAL(&rampMux);
+    tempoRamp = ramp;
+    portEXIT_CRITICAL(&rampMux);
+    steeredRamp = ramp;
+    rampAnchored = false;
+}
+
+// The clock starts or resumes; the ramp's timeline starts over from the
+// next tick, not from one noted before the gap
+void Timing::restartRampTimeline()
+{
+    portENTER_CRITICAL(&rampMux);
+    rampTickUs = 0;
+    portEXIT_CRITICAL(&rampMux);
+    rampAnchored = false;
+}
+
+void Timing::rampTempo(uint16_t bpm, uint16_t bars, RampShape shape)
+{
+    bool playing = state.isRunning || state.isPaused;
+    TempoRamp ramp;
+    ramp.set(playing ? nextBarTick() : 0, uint32_t(min(bars, uint16_t(MAX_RAMP_BARS))) * barTicks(state), state.bpm,
+             constrain(bpm, MIN_GLOBAL_BPM, MAX_GLOBAL_BPM), shape);
+    installRamp(ramp);
+
+    if (wirelessSync.isInitialized() && wirelessSync.isLeader())
+    {
+        wirelessSync.sendRamp(ramp);
+    }
+}
+
+void Timing::cancelRamp()
+{
+    if (!tempoRamp.isSet())
+        return;
+    setTempo(state.bpm);
+
+    if (wirelessSync.isInitialized() && wirelessSync.isLeader())
+    {
+        wirelessSync.sendRamp(TempoRamp());
+    }
+}
+
+uint32_t Timing::lookaheadTicks() const
+{
+    uint32_t period = tickPeriodUs ? tickPeriodUs : 1;
+    uint32_t ticks = 0;
+    for (uint8_t output = 0; output < LATENCY_OUTPUT_COUNT; output++)
+    {
+        uint32_t ahead = (outputLatencyUs[output] + period - 1) / period;
+        if (ahead > ticks)
+            ticks = ahead;
+    }
+    return ticks;
+}
+
+// PPQN ticks in a bar of channel 1
+uint32_t Timing::barTicks(const MetronomeState &config) const
+{
+    float multiplier = config.getCurrentMultiplier();
+    return uint32_t(config.getChannel(0).getBarLength() * 96 / multiplier);
+}
+
+// First bar boundary of the playing cycle that no output has looked
+// ahead to yet
+uint32_t Timing::nextBarTick() const
+{
+    uint32_t ticks = barTicks(*playingConfig);
+    uint32_t earliest = lastTick + lookaheadTicks() + PRESET_SWITCH_MARGIN_TICKS;
+    uint32_t bars = (earliest - cycleOriginTick + ticks - 1) / ticks;
+    return cycleOriginTick + bars * ticks;
+}
+
+void Timing::queuePreset(const Preset &preset)
+{
+    // Not while the control task starts or stops the transport
+    xSemaphoreTake(transportLock, portMAX_DELAY);
+    songPlaying = false;
+    songQueued = false;
+    songSetup = false;
+    wirelessSync.setSongPlaying(false);
+
+    if (!state.isRunning && !state.isPaused)
+    {
+        // Nothing is playing, so there is no boundary to wait for
+        portENTER_CRITICAL(&presetMux);
+        armedSlot = -1;
+        portEXIT_CRITICAL(&presetMux);
+        PresetBank::apply(preset, state);
+        setTempo(state.bpm);
+    }
+    else
+    {
+        armPreset(preset, nextBarTick());
+    }
+    xSemaphoreGive(transportLock);
+}
+
+// Arm `preset` to take over on tick `at`; returns its staging state
+const MetronomeState &Timing::armPreset(const Preset &preset, uint32_t at)
+{
+    // Build the preset in the slot the tick path is not reading. Accent
+    // and weak volumes, the groove and the step chances are not part of a
+    // preset and carry over.
+    portENTER_CRITICAL(&presetMux);
+    int8_t armed = armedSlot;
+    int8_t playing = playingSlot;
+    portEXIT_CRITICAL(&presetMux);
+    uint8_t slot = 0;
+    while (slot == armed || slot == playing)
+    {
+        slot++;
+    }
+    MetronomeState &staging = presetStaging[slot];
+    for (uint8_t i = 0; i < FIXED_CHANNEL_COUNT; i++)
+    {
+        const MetronomeChannel &live = state.getChannel(i);
+        MetronomeChannel &staged = staging.getChannel(i);
+        staged.setStrongVolume(live.getStrongVolume());
+        staged.setWeakVolume(live.getWeakVolume());
+        staged.setSwing(live.getSwing());
+        for (uint8_t step = 0; step < MAX_BEATS; step++)
+        {
+            staged.setStepOffset(step, live.getStepOffset(step));
+            staged.setStepChance(step, live.getStepChance(step));
+        }
+    }
+    staging.setSessionSeed(state.getSessionSeed());
+    PresetBank::apply(preset, staging);
+    staging.compileGroove();
+    stagedPresets[slot] = preset;
+    stagedPeriodUs[slot] = staging.bpm != state.bpm ? 60000000UL / (staging.bpm * 96UL) : 0;
+
+    portENTER_CRITICAL(&presetMux);
+    switchTick = at;
+    armedSlot = slot;
+    portEXIT_CRITICAL(&presetMux);
+    return staging;
+}
+
+void Timing::loadSong(const SongEntry *entries, uint8_t count, bool loop)
+{
+    // Not while the control task is starting the song
+    xSemaphoreTake(transportLock, portMAX_DELAY);
+    songLength = min(count, uint8_t(SONG_MAX_ENTRIES));
+    memcpy(song, entries, songLength * sizeof(SongEntry));
+    songLoop = loop;
+    xSemaphoreGive(transportLock);
+}
+
+// Arms the entry after the playing one on its boundary. Runs from the
+// loop; the ticks come from the entries' own staging states, not from
+// the live state the tick path is switching.
+void Timing::followSong()
+{
+    if (!songPlaying)
+        return;
+
+    if (songQueued)
+    {
+        if (isPresetPending())
+            return;
+
+        // The armed entry has taken over
+        songQueued = false;
+        songIndex = songIndex + 1 < songLength ? songIndex + 1 : 0;
+        songEntryTick = songNextTick;
+        songEntryTicks = songNextTicks;
+    }
+
+    uint8_t next = songIndex + 1;
+    if (next >= songLength)
+    {
+        if (!songLoop)
+        {
+            // The last entry plays on
+            songPlaying = false;
+            wirelessSync.setSongPlaying(false);
+            return;
         }
+        next = 0;
     }
+
+    // A loop pass too late for a very short entry moves to the next bar
+    uint32_t at = songEntryTick + songEntryTicks;
+    uint32_t earliest = nextBarTick();
+    if (int32_t(at - earliest) < 0)
+    {
+        at = earliest;
+    }
+    const MetronomeState &staged = armPreset(song[next].preset, at);
+    songQueued = true;
+    songNextTick = at;
+    songNextTicks = song[next].bars * barTicks(staged);
 }
 
 void Timing::start()
 {
-    // Start the display animation if available
-    if (display)
+    // Fresh step chance rolls every start; followers use the leader's seed
+    if (!externalClock)
+    {
+        state.setSessionSeed(esp_random());
+    }
+
+    // A song starts from its first entry; followers get the whole chain
+    // before the start
+    songPlaying = songLength > 0;
+    songQueued = false;
+    if (songPlaying)
     {
-        display->startAnimation();
+        PresetBank::capture(state, songReturn);
+        songSetup = true;
+        PresetBank::apply(song[0].preset, state);
+        recompileGroove();
+        setTempo(state.bpm);
+        songIndex = 0;
+        songEntryTick = 0;
+        songEntryTicks = song[0].bars * barTicks(state);
     }
+    wirelessSync.setSongPlaying(songPlaying);
 
     if (wirelessSync.isInitialized() && wirelessSync.isLeader())
     {
-        wirelessSync.sendControl(CMD_START);
+        wirelessSync.sendSong(song, songLength, songLoop);
+        wirelessSync.sendControl(CMD_START, state.getSessionSeed());
+    }
+    cycleOriginTick = 0;
+    lastTick = 0;
+    lastTickUs = 0;
+    for (uint32_t &next : solenoidNextTick)
+    {
+        next = 0;
     }
+    restartRampTimeline();
     uClock.start();
 }
 
@@ -235,6 +816,44 @@ void Timing::stop()
         wirelessSync.sendControl(CMD_STOP);
     }
     uClock.stop();
+
+    // A ramp ends where it got to
+    if (tempoRamp.isSet())
+    {
+        setTempo(state.bpm);
+    }
+
+    // A preset that has taken over stays; one still waiting for its bar
+    // takes effect now. A song's next entry does not, the song restarts
+    // from the top.
+    adoptPreset();
+    bool wasSong = songPlaying;
+    songPlaying = false;
+    songQueued = false;
+    wirelessSync.setSongPlaying(false);
+    portENTER_CRITICAL(&presetMux);
+    int8_t slot = armedSlot;
+    armedSlot = -1;
+    portEXIT_CRITICAL(&presetMux);
+    if (slot >= 0 && !wasSong)
+    {
+        PresetBank::apply(stagedPresets[slot], state);
+        setTempo(state.bpm);
+    }
+
+    // The song's entries were never the user's setup
+    if (songSetup)
+    {
+        songSetup = false;
+        PresetBank::apply(songReturn, state);
+        setTempo(state.bpm);
+    }
+    cycleOriginTick = 0;
+
+    if (frameClock)
+    {
+        frameClock->reset();
+    }
 }
 
 void Timing::pause()
@@ -243,10 +862,24 @@ void Timing::pause()
     {
         wirelessSync.sendControl(CMD_PAUSE);
     }
+    restartRampTimeline();
     uClock.pause();
 }
 
 void Timing::setTempo(uint16_t bpm)
 {
+    if (tempoRamp.isSet())
+    {
+        installRamp(TempoRamp());
+    }
     uClock.setTempo(bpm);
-}
\ No newline at end of file
+    refreshTickPeriod();
+}
+
+void Timing::setOutputLatency(LatencyOutput output, uint32_t latencyUs)
+{
+    if (output < LATENCY_OUTPUT_COUNT)
+    {
+        outputLatencyUs[output] = latencyUs;
+    }
+}
@@ -4,12 +4,33 @@
 #include "MetronomeState.h"
 #include "WirelessSync.h"
 #include "BuzzerController.h" // Change from forward declaration to include
+#include "SolenoidController.h"
+#include "PresetBank.h"
+#include "TempoRamp.h"
+#include "SongChain.h"
 
 // Forward declarations
 class SolenoidController;
 // Remove AudioController forward declaration
-class Display;
 class LEDController;
+class FrameClock;
+
+// Outputs whose actuator latency the scheduler compensates by firing early
+enum LatencyOutput : uint8_t
+{
+    LATENCY_SOLENOID1,
+    LATENCY_SOLENOID2,
+    LATENCY_BUZZER,
+    LATENCY_LEDS,
+    LATENCY_OUTPUT_COUNT
+};
+
+// Transport change asked for by a button (or a host scenario)
+enum TransportRequest : uint8_t
+{
+    TRANSPORT_START_PAUSE,  // Start when stopped, pause when playing, resume when paused
+    TRANSPORT_STOP          // Stop and rewind
+};
 
 class Timing
 {
@@ -18,24 +39,146 @@ private:
     WirelessSync &wirelessSync;
     SolenoidController &solenoidController;
     // Remove AudioController reference
-    Display *display;
-    LEDController *ledController;
+    LEDController *ledController = nullptr;
+    FrameClock *frameClock = nullptr;
     BuzzerController *buzzerController;
 
-    // Track previous running state to detect changes
-    bool previousRunningState = false;
+    // Transport requests with the time they were made. Any task posts
+    // them; only applyTransport() acts on them, holding transportLock, so
+    // each runs exactly once whichever task gets to it first.
+    struct TransportEvent
+    {
+        uint32_t us;
+        TransportRequest request;
+    };
+    static const uint8_t TRANSPORT_QUEUE_SIZE = 4;
+    TransportEvent transportRing[TRANSPORT_QUEUE_SIZE];
+    volatile uint8_t transportHead = 0;
+    volatile uint8_t transportTail = 0;
+    portMUX_TYPE transportMux = portMUX_INITIALIZER_UNLOCKED;
+    SemaphoreHandle_t transportLock = nullptr;
+    volatile uint32_t transportLatencyUs = 0;
+    volatile uint32_t maxTransportLatencyUs = 0;
+
+    // uClock follows the wireless leader's clock
+    bool externalClock = false;
 
     // Private callback handlers
-    static void onClockPulseStatic(uint32_t tick);
+    static void IRAM_ATTR onClockPulseStatic(uint32_t tick);
     static void onSync24Static(uint32_t tick);
-    static void onPPQNStatic(uint32_t tick);
+    static void IRAM_ATTR onPPQNStatic(uint32_t tick);
     static void onStepStatic(uint32_t tick);
 
     // Pointer to the singleton instance for static callbacks
     static Timing *instance;
 
+    // Time from trigger to the output being seen or heard, per output
+    uint32_t outputLatencyUs[LATENCY_OUTPUT_COUNT] = {
+        SOLENOID_LATENCY_US, SOLENOID_LATENCY_US, BUZZER_LATENCY_US, LED_LATENCY_US};
+
+    // PPQN tick length, refreshed from the loop so the tick path does not
+    // call into uClock or divide floats
+    volatile uint32_t tickPeriodUs = 60000000UL / (DEFAULT_BPM * 96);
+
+    // Tempo ramp being played, or waiting for its start tick. The loop
+    // sets it and the tick path follows it, both under rampMux. The tick
+    // path also notes the last tick it followed and when it came.
+    TempoRamp tempoRamp;
+    uint32_t rampTick = 0;
+    uint32_t rampTickUs = 0;
+    portMUX_TYPE rampMux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Loop side of the ramp. The ideal timeline starts at the first ramp
+    // tick the loop sees and adds up the ramp's tick lengths from there;
+    // the clock is steered onto it, so rounding in the timer interval
+    // does not build up over the ramp.
+    TempoRamp steeredRamp;
+    bool rampAnchored = false;
+    uint32_t anchorTickUs = 0;
+    uint32_t idealTick = 0;
+    double idealUs = 0.0;       // From anchorTickUs to the start of idealTick
+
+    // Largest amount a tick arrived later than one period after the last
+    volatile uint32_t lastTick = 0;
+    volatile uint32_t lastTickUs = 0;
+    volatile uint32_t maxTickDelayUs = 0;
+
+    // PPQN tick the playing configuration's cycle started on; a preset
+    // switch restarts the cycle on its bar boundary
+    volatile uint32_t cycleOriginTick = 0;
+
+    // First PPQN tick each solenoid is not scheduled for yet. The
+    // lookahead follows tempo and latency, and every tick is still
+    // scheduled exactly once as it grows or shrinks.
+    uint32_t solenoidNextTick[FIXED_CHANNEL_COUNT] = {};
+
+    // Armed preset. The loop builds the complete state in a staging slot
+    // the tick path is not reading, then publishes the slot with the tick
+    // it takes over. On that tick the tick path only repoints
+    // playingConfig at it; the loop then copies the preset into the live
+    // state and points it back (adoptPreset). One slot can be armed and
+    // another still playing while a third is being built.
+    static const uint8_t STAGING_SLOTS = 3;
+    MetronomeState presetStaging[STAGING_SLOTS];
+    Preset stagedPresets[STAGING_SLOTS];
+    uint32_t stagedPeriodUs[STAGING_SLOTS] = {};    // 0 = same tempo
+    volatile int8_t armedSlot = -1;
+    volatile int8_t playingSlot = -1;
+    volatile uint32_t switchTick = 0;
+    portMUX_TYPE presetMux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Configuration the tick path plays: the live state, or a preset that
+    // has taken over until the loop has copied it in
+    const MetronomeState *volatile playingConfig = &state;
+
+    // Settings the compiled groove tables depend on
+    static constexpr uint8_t GROOVE_LAYOUT = changeBit(CHANGE_GROOVE) | changeBit(CHANGE_PATTERN) |
+                                             changeBit(CHANGE_MODE) | changeBit(CHANGE_MULTIPLIER);
+    ChangeTracker grooveChanges;
+
+    // Song mode. The loop arms the next entry as soon as the current one
+    // has taken over, so its staging state is ready bars ahead and the tick
+    // path swaps it in on the exact boundary like any armed preset.
+    SongEntry song[SONG_MAX_ENTRIES];
+    uint8_t songLength = 0;
+    bool songLoop = false;
+    bool songPlaying = false;
+    uint8_t songIndex = 0;          // Entry playing
+    uint32_t songEntryTick = 0;     // Tick it started on
+    uint32_t songEntryTicks = 0;    // Ticks it plays for
+    bool songQueued = false;        // Next entry armed
+    uint32_t songNextTick = 0;      // Its switch tick
+    uint32_t songNextTicks = 0;
+    bool songSetup = false;         // The live state is a song entry's
+    Preset songReturn;              // Setup the song replaced, back on stop
+
+    // Armed preset as seen by the tick being processed
+    const MetronomeState *nextConfig = nullptr;
+    uint32_t nextConfigTick = 0;
+
     // Process beat events
-    void onBeatEvent(uint8_t channel, BeatState beatState);
+    IRAM_ATTR const MetronomeState &configAt(uint32_t tick, uint32_t &originTick) const;
+    BeatState IRAM_ATTR beatAt(uint8_t channel, uint32_t tick) const;
+    SolenoidHit IRAM_ATTR hitAt(uint8_t channel, uint32_t tick) const;
+    void IRAM_ATTR scheduleOutputs(uint32_t tick, uint32_t tickUs);
+    void refreshTickPeriod();
+    uint32_t lookaheadTicks() const;
+    uint32_t barTicks(const MetronomeState &config) const;
+    uint32_t nextBarTick() const;
+    const MetronomeState &armPreset(const Preset &preset, uint32_t at);
+    void IRAM_ATTR switchPreset(uint32_t tick);
+    void adoptPreset();
+    void recompileGroove();
+    void followSong();
+    void IRAM_ATTR followRamp(uint32_t tick, uint32_t tickUs);
+    void steerRamp();
+    void installRamp(const TempoRamp &ramp);
+    void restartRampTimeline();
+    void followLeadership();
+    void applyTransport();
+    void start();
+    void stop();
+    void pause();
 
 public:
     Timing(MetronomeState &state,
@@ -49,8 +192,8 @@ public:
         instance = this;
     }
 
-    // Set display reference
-    void setDisplay(Display *displayRef);
+    // Set the frame clock that receives the published beat phase
+    void setFrameClock(FrameClock *clock);
 
     // Initialize timing system
     void init();
@@ -58,17 +201,62 @@ public:
     // Update timing state
     void update();
 
-    // Process clock pulse
-    void onClockPulse(uint32_t tick);
+    // Process clock pulse. Everything it reaches is IRAM-resident, but it
+    // still runs from uClock's task, which waits out any flash operation.
+    void IRAM_ATTR onClockPulse(uint32_t tick);
 
-    // Start/stop/pause playback
-    void start();
-    void stop();
-    void pause();
+    // Post a transport change made at `us` (micros()); safe from any
+    // task. It takes effect on the next serviceTransport() or update().
+    void requestTransport(TransportRequest request, uint32_t us);
 
-    // Set tempo
+    // Act on the posted transport changes. The control task calls it
+    // straight after posting, so a press does not wait for the loop.
+    void serviceTransport();
+
+    // Request-to-action delay of the last transport change, and the worst
+    // since the last reset, for diagnostics
+    uint32_t getTransportLatencyUs() const { return transportLatencyUs; }
+    uint32_t getMaxTransportLatencyUs() const { return maxTransportLatencyUs; }
+    void resetTransportLatency() { maxTransportLatencyUs = 0; }
+
+    // Set tempo; cancels a tempo ramp
     void setTempo(uint16_t bpm);
 
+    // Ramp from the current tempo to `bpm` over `bars` bars of channel 1,
+    // from the next bar boundary (from the start when stopped). The loop
+    // keeps the clock on the ramp's timeline and stays at `bpm` after it;
+    // followers get the ramp and play the same tick lengths.
+    void rampTempo(uint16_t bpm, uint16_t bars, RampShape shape = RAMP_LINEAR);
+    void cancelRamp();
+    bool isRamping() const { return tempoRamp.isSet(); }
+
+    // Actuator latency the scheduler fires early by
+    void setOutputLatency(LatencyOutput output, uint32_t latencyUs);
+    uint32_t getOutputLatency(LatencyOutput output) const { return outputLatencyUs[output]; }
+
+    // Worst tick lateness since the last reset, e.g. while NVS was writing
+    uint32_t getMaxTickDelayUs() const { return maxTickDelayUs; }
+    void resetTickDelay() { maxTickDelayUs = 0; }
+
+    // Switch to `preset` at the next bar boundary of the playing cycle
+    // (immediately when stopped). Called from the loop; the tick path
+    // swaps it in, so no beat is dropped or played twice.
+    void queuePreset(const Preset &preset);
+    bool isPresetPending() const { return armedSlot >= 0; }
+
+    // Song to play from the next start, its first entry first and each
+    // for its bars (see SongChain::resolve); count 0 leaves song mode.
+    // Call while stopped. The leader sends it to followers on start. A
+    // queued preset stops the song where it is.
+    void loadSong(const SongEntry *entries, uint8_t count, bool loop);
+    bool isSongPlaying() const { return songPlaying; }
+
+    // From a song's start until the stop that puts back the setup it
+    // replaced, however the song ended. The live state is not the user's
+    // meanwhile, so it is not saved.
+    bool isSongSetup() const { return songSetup; }
+    uint8_t getSongIndex() const { return songIndex; }
+
     // Set LED controller
     void setLEDController(LEDController *controller);
 };
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "TraceBuffer.h"
+
+TraceRecord TraceBuffer::records[TRACE_CAPACITY];
+volatile uint16_t TraceBuffer::head = 0;
+volatile uint16_t TraceBuffer::tail = 0;
+volatile uint32_t TraceBuffer::dropped = 0;
+portMUX_TYPE TraceBuffer::mux = portMUX_INITIALIZER_UNLOCKED;
+
+void IRAM_ATTR TraceBuffer::record(TraceEvent event, uint8_t channel, uint32_t value)
+{
+    uint32_t now = micros();
+
+    portENTER_CRITICAL_SAFE(&mux);
+    uint16_t next = (head + 1) % TRACE_CAPACITY;
+    if (next == tail)
+    {
+        dropped = dropped + 1;
+    }
+    else
+    {
+        records[head] = {now, value, event, channel};
+        head = next;
+    }
+    portEXIT_CRITICAL_SAFE(&mux);
+}
+
+bool TraceBuffer::pop(TraceRecord &record)
+{
+    bool available = false;
+
+    portENTER_CRITICAL(&mux);
+    if (tail != head)
+    {
+        record = records[tail];
+        tail = (tail + 1) % TRACE_CAPACITY;
+        available = true;
+    }
+    portEXIT_CRITICAL(&mux);
+
+    return available;
+}
+
+void TraceBuffer::printPending(uint8_t maxRecords)
+{
+    static const char *const EVENT_NAMES[] = {"pulse_on", "pulse_off", "trigger", "strike"};
+
+    TraceRecord record;
+    for (uint8_t i = 0; i < maxRecords && pop(record); i++)
+    {
+        Serial.printf("TRACE %lu %s ch%u %lu\n", (unsigned long)record.us,
+                      EVENT_NAMES[record.event], record.channel, (unsigned long)record.value);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Timestamped event ring for timing measurements on the tick path.
+// record() may be called from interrupts, timer callbacks and tasks;
+// the main loop drains the ring and prints it. With TRACE_ENABLED 0
+// the TRACE() macro compiles to nothing.
+
+enum TraceEvent : uint8_t
+{
+    TRACE_PULSE_ON,  // value = requested width in us
+    TRACE_PULSE_OFF, // value = measured width in us
+    TRACE_TRIGGER,   // channel = mask of outputs fired together, value = skew in CPU cycles
+    TRACE_STRIKE,    // value = solenoid coil energy in uJ
+};
+
+struct TraceRecord
+{
+    uint32_t us;
+    uint32_t value;
+    TraceEvent event;
+    uint8_t channel;
+};
+
+class TraceBuffer
+{
+private:
+    static TraceRecord records[TRACE_CAPACITY];
+    static volatile uint16_t head; // Next slot to write
+    static volatile uint16_t tail; // Next slot to read
+    static volatile uint32_t dropped;
+    static portMUX_TYPE mux;
+
+public:
+    // Full ring: the new record is dropped and counted
+    static void IRAM_ATTR record(TraceEvent event, uint8_t channel, uint32_t value);
+
+    static bool pop(TraceRecord &record);
+    static uint32_t getDropped() { return dropped; }
+
+    // Print up to `maxRecords` pending records to Serial
+    static void printPending(uint8_t maxRecords);
+};
+
+#if TRACE_ENABLED
+#define TRACE(event, channel, value) TraceBuffer::record(event, channel, value)
+#else
+#define TRACE(event, channel, value) ((void)0)
+#endif
@@ -58,7 +58,7 @@ void WirelessSync::onDataReceived(const uint8_t *mac, const uint8_t *data, int l
       
     case MSG_PATTERN:
       // Process pattern message (for followers)
-      if (wirelessSyncInstance && !wirelessSyncInstance->_isLeader) {
+      if (wirelessSyncInstance && !wirelessSyncInstance->_isLeader && wirelessSyncInstance->_state) {
         // Get channel ID and validate
         uint8_t channelId = msg->data.pattern.channelId;
         if (channelId < MetronomeState::CHANNEL_COUNT) {
@@ -73,8 +73,92 @@ void WirelessSync::onDataReceived(const uint8_t *mac, const uint8_t *data, int l
       }
       break;
       
+    case MSG_GROOVE:
+      // Process groove message (for followers); Timing compiles it
+      if (wirelessSyncInstance && !wirelessSyncInstance->_isLeader && wirelessSyncInstance->_state) {
+        uint8_t channelId = msg->data.groove.channelId;
+        uint8_t firstStep = msg->data.groove.firstStep;
+        if (channelId < MetronomeState::CHANNEL_COUNT && firstStep < MAX_BEATS) {
+          MetronomeChannel &channel = wirelessSyncInstance->_state->getChannel(channelId);
+          channel.setSwing(msg->data.groove.swing);
+          for (uint8_t i = 0; i < 8 && firstStep + i < MAX_BEATS; i++) {
+            channel.setStepOffset(firstStep + i, msg->data.groove.offsets[i]);
+          }
+        }
+      }
+      break;
+      
+    case MSG_RAMP:
+      // Process tempo ramp (for followers); Timing takes it from the loop
+      if (wirelessSyncInstance && !wirelessSyncInstance->_isLeader) {
+        wirelessSyncInstance->_receivedRamp.set(msg->data.ramp.startTick,
+                                                uint32_t(msg->data.ramp.lengthPulses) * 4,
+                                                msg->data.ramp.fromBpm, msg->data.ramp.toBpm,
+                                                static_cast<RampShape>(msg->data.ramp.shape));
+        wirelessSyncInstance->_rampReceived = true;
+      }
+      break;
+      
+    case MSG_CHANCE:
+      // Process step chances (for followers)
+      if (wirelessSyncInstance && !wirelessSyncInstance->_isLeader && wirelessSyncInstance->_state) {
+        uint8_t channelId = msg->data.chance.channelId;
+        uint8_t firstStep = msg->data.chance.firstStep;
+        if (channelId < MetronomeState::CHANNEL_COUNT && firstStep < MAX_BEATS) {
+          MetronomeChannel &channel = wirelessSyncInstance->_state->getChannel(channelId);
+          for (uint8_t i = 0; i < 8 && firstStep + i < MAX_BEATS; i++) {
+            channel.setStepChance(firstStep + i, msg->data.chance.chances[i]);
+          }
+        }
+      }
+      break;
+      
+    case MSG_SONG:
+      // Process a song header (for followers); the first message starts over
+      if (wirelessSyncInstance && !wirelessSyncInstance->_isLeader) {
+        WirelessSync &sync = *wirelessSyncInstance;
+        uint8_t count = msg->data.song.count;
+        uint8_t firstEntry = msg->data.song.firstEntry;
+        if (count > SONG_MAX_ENTRIES || (count && firstEntry >= count) || firstEntry % 8) break;
+        if (firstEntry == 0) {
+          sync._songReceived = false;
+          sync._songCount = count;
+          sync._songLoop = msg->data.song.flags & 0x01;
+          sync._songEntriesMissing = count < 32 ? (1UL << count) - 1 : 0xFFFFFFFFUL;
+          sync._songChunksMissing = ((1 << ((count + 7) / 8)) - 1) | 0x01;
+        } else if (count != sync._songCount) {
+          break;
+        }
+        for (uint8_t i = 0; i < 8 && firstEntry + i < count; i++) {
+          sync._receivedSong[firstEntry + i].bars = msg->data.song.bars[i];
+        }
+        sync._songChunksMissing &= ~(1 << (firstEntry / 8));
+        sync._songReceived = !sync._songChunksMissing && !sync._songEntriesMissing;
+      }
+      break;
+      
+    case MSG_SONG_ENTRY:
+      // Process a song entry's preset (for followers)
+      if (wirelessSyncInstance && !wirelessSyncInstance->_isLeader) {
+        WirelessSync &sync = *wirelessSyncInstance;
+        uint8_t index = msg->data.songEntry.index;
+        if (index >= sync._songCount || !(sync._songEntriesMissing & (1UL << index))) break;
+        Preset &preset = sync._receivedSong[index].preset;
+        preset.format = PRESET_FORMAT;
+        memcpy(reinterpret_cast<uint8_t *>(&preset) + 1, msg->data.songEntry.settings,
+               sizeof(msg->data.songEntry.settings));
+        sync._songEntriesMissing &= ~(1UL << index);
+        sync._songReceived = !sync._songChunksMissing && !sync._songEntriesMissing;
+      }
+      break;
+      
     case MSG_CONTROL:
       // Process control messages
+      if (msg->data.control.command == CMD_START && wirelessSyncInstance &&
+          !wirelessSyncInstance->_isLeader && wirelessSyncInstance->_state) {
+        // Same seed, so every step chance rolls the same way here
+        wirelessSyncInstance->_state->setSessionSeed(msg->data.control.value);
+      }
       if (msg->data.control.command == CMD_RESET && msg->data.control.param1 == 1) {
         // This is a leader negotiation message
         if (wirelessSyncInstance) {
@@ -135,6 +219,7 @@ bool WirelessSync::init() {
 
 void WirelessSync::setAsLeader(bool isLeader) {
   _isLeader = isLeader;
+  _leaderNegotiated = true;
 }
 
 void WirelessSync::sendMessage(SyncMessage &msg) {
@@ -173,7 +258,8 @@ void WirelessSync::onPPQN(uint32_t tick, MetronomeState &state) {
     // Every quarter note (96 PPQN ticks)
     if (tick % 96 == 0) {
       uint32_t quarterNote = tick / 96;
-      if (quarterNote != _lastQuarterNote) {
+      // Tick 0 always sends, so followers get the tempo from the start
+      if (quarterNote != _lastQuarterNote || tick == 0) {
         _lastQuarterNote = quarterNote;
         sendBeat(quarterNote, state);
       }
@@ -274,6 +360,103 @@ void WirelessSync::sendPattern(MetronomeState &state, uint8_t channelId) {
   sendMessage(msg);
 }
 
+void WirelessSync::sendGroove(MetronomeState &state, uint8_t channelId) {
+  if (channelId >= MetronomeState::CHANNEL_COUNT) return;
+  
+  const MetronomeChannel &channel = state.getChannel(channelId);
+  
+  // Eight offsets per message, so a channel takes two
+  for (uint8_t firstStep = 0; firstStep < MAX_BEATS; firstStep += 8) {
+    SyncMessage msg;
+    msg.type = MSG_GROOVE;
+    msg.data.groove.channelId = channelId;
+    msg.data.groove.swing = channel.getSwing();
+    msg.data.groove.firstStep = firstStep;
+    for (uint8_t i = 0; i < 8; i++) {
+      msg.data.groove.offsets[i] = channel.getStepOffset(firstStep + i);
+    }
+    memset(msg.data.groove.reserved, 0, sizeof(msg.data.groove.reserved));
+    sendMessage(msg);
+  }
+}
+
+void WirelessSync::sendChance(MetronomeState &state, uint8_t channelId) {
+  if (channelId >= MetronomeState::CHANNEL_COUNT) return;
+  
+  const MetronomeChannel &channel = state.getChannel(channelId);
+  
+  // Eight steps per message, so a channel takes two
+  for (uint8_t firstStep = 0; firstStep < MAX_BEATS; firstStep += 8) {
+    SyncMessage msg;
+    msg.type = MSG_CHANCE;
+    msg.data.chance.channelId = channelId;
+    msg.data.chance.firstStep = firstStep;
+    for (uint8_t i = 0; i < 8; i++) {
+      msg.data.chance.chances[i] = channel.getStepChance(firstStep + i);
+    }
+    memset(msg.data.chance.reserved, 0, sizeof(msg.data.chance.reserved));
+    sendMessage(msg);
+  }
+}
+
+void WirelessSync::sendRamp(const TempoRamp &ramp) {
+  SyncMessage msg;
+  msg.type = MSG_RAMP;
+  msg.data.ramp.startTick = ramp.getStartTick();
+  msg.data.ramp.fromBpm = ramp.getFromBpm();
+  msg.data.ramp.toBpm = ramp.getToBpm();
+  // Ramps span whole bars (at most MAX_RAMP_BARS), a multiple of 4 PPQN ticks
+  msg.data.ramp.lengthPulses = uint16_t(ramp.getLengthTicks() / 4);
+  msg.data.ramp.shape = ramp.getShape();
+  msg.data.ramp.reserved = 0;
+  
+  sendMessage(msg);
+}
+
+bool WirelessSync::takeRamp(TempoRamp &ramp) {
+  if (!_rampReceived) return false;
+  ramp = _receivedRamp;
+  _rampReceived = false;
+  return true;
+}
+
+void WirelessSync::sendSong(const SongEntry *entries, uint8_t count, bool loop) {
+  static_assert(sizeof(Preset) == 1 + sizeof(SyncMessage::data.songEntry.settings),
+                "A song entry message carries a whole preset");
+  
+  // Bar counts first, eight entries per message, then one message per
+  // preset. No song still sends the header, so followers drop theirs.
+  for (uint8_t firstEntry = 0; firstEntry == 0 || firstEntry < count; firstEntry += 8) {
+    SyncMessage msg;
+    msg.type = MSG_SONG;
+    msg.data.song.count = count;
+    msg.data.song.flags = loop ? 0x01 : 0;
+    msg.data.song.firstEntry = firstEntry;
+    for (uint8_t i = 0; i < 8; i++) {
+      msg.data.song.bars[i] = firstEntry + i < count ? entries[firstEntry + i].bars : 0;
+    }
+    msg.data.song.reserved = 0;
+    sendMessage(msg);
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    SyncMessage msg;
+    msg.type = MSG_SONG_ENTRY;
+    msg.data.songEntry.index = i;
+    memcpy(msg.data.songEntry.settings, reinterpret_cast<const uint8_t *>(&entries[i].preset) + 1,
+           sizeof(msg.data.songEntry.settings));
+    sendMessage(msg);
+  }
+}
+
+bool WirelessSync::takeSong(SongEntry *entries, uint8_t &count, bool &loop) {
+  if (!_songReceived) return false;
+  _songReceived = false;
+  count = _songCount;
+  loop = _songLoop;
+  memcpy(entries, _receivedSong, count * sizeof(SongEntry));
+  return true;
+}
+
 void WirelessSync::sendControl(uint8_t command, uint32_t value) {
   SyncMessage msg;
   msg.type = MSG_CONTROL;
@@ -286,21 +469,28 @@ void WirelessSync::sendControl(uint8_t command, uint32_t value) {
   sendMessage(msg);
 }
 
-void WirelessSync::notifyPatternChanged(uint8_t channelId) {
-  _patternChanged = true;
-}
-
 void WirelessSync::update(MetronomeState &state) {
   _state = &state; // Store state reference for pattern updates
-  
-  // Check for pattern changes
-  if (_patternChanged) {
-    _patternChanged = false;
-    
-    // Send updated pattern info for all channels
-    for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
+  if (!_initialized) return;
+  
+  // Check for pattern changes (enabled, bar length or pattern), groove
+  // changes (swing, step offsets) and step chance changes
+  uint8_t changed = _changes.poll(state, changeBit(CHANGE_PATTERN) | changeBit(CHANGE_GROOVE) |
+                                         changeBit(CHANGE_CHANCE));
+  if (_songPlaying) {
+    // Every device switches the song's entries on its own
+    changed = 0;
+  }
+  for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
+    if (changed & changeBit(CHANGE_PATTERN)) {
       sendPattern(state, i);
     }
+    if (changed & changeBit(CHANGE_GROOVE)) {
+      sendGroove(state, i);
+    }
+    if (changed & changeBit(CHANGE_CHANCE)) {
+      sendChance(state, i);
+    }
   }
   
   // If we're the leader and just started, send initial patterns
@@ -309,6 +499,8 @@ void WirelessSync::update(MetronomeState &state) {
     initialPatternsSent = true;
     for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
       sendPattern(state, i);
+      sendGroove(state, i);
+      sendChance(state, i);
     }
   }
 }
@@ -325,6 +517,7 @@ bool WirelessSync::isLeader() const {
 
 // Start leader negotiation process
 void WirelessSync::startLeaderNegotiation() {
+  _negotiationStartMs = millis();
   _leaderNegotiationActive = true;
   _highestPrioritySeen = _priority;
   memcpy(_highestPriorityDevice, _deviceID, 6);
@@ -338,11 +531,12 @@ void WirelessSync::startLeaderNegotiation() {
   msg.data.control.param3 = 0;
   msg.data.control.value = _priority; // Send our priority
   
+  // Responses arrive in onDataReceived until the window closes
   sendMessage(msg);
-  
-  // Wait for responses (will be handled in onDataReceived)
-  delay(500); // Give other devices time to respond
-  
+}
+
+// Decide leadership once the negotiation window has closed
+void WirelessSync::finishLeaderNegotiation() {
   // Check if we're the highest priority device
   if (memcmp(_highestPriorityDevice, _deviceID, 6) == 0) {
     // We're the highest priority, become leader
@@ -355,6 +549,7 @@ void WirelessSync::startLeaderNegotiation() {
   }
   
   _leaderNegotiationActive = false;
+  _leaderNegotiated = true;
 }
 
 // Process leader selection from received message
@@ -396,6 +591,15 @@ void WirelessSync::negotiateLeadership() {
 
 // Check leader status and initiate negotiation if needed
 void WirelessSync::checkLeaderStatus() {
+  if (!_initialized) return;
+
+  if (_leaderNegotiationActive) {
+    if (millis() - _negotiationStartMs >= _negotiationWindowMs) {
+      finishLeaderNegotiation();
+    }
+    return;
+  }
+
   if (!_isLeader && isLeaderTimedOut()) {
     Serial.println("Leader timed out, starting negotiation");
     startLeaderNegotiation();
@@ -5,6 +5,8 @@
 #include <WiFi.h>
 #include <uClock.h>
 #include "MetronomeState.h"
+#include "TempoRamp.h"
+#include "SongChain.h"
 
 // Message types for our sync protocol
 typedef enum {
@@ -12,7 +14,12 @@ typedef enum {
   MSG_BEAT = 1,
   MSG_BAR = 2,
   MSG_CONTROL = 3,
-  MSG_PATTERN = 4
+  MSG_PATTERN = 4,
+  MSG_GROOVE = 5,
+  MSG_RAMP = 6,
+  MSG_CHANCE = 7,
+  MSG_SONG = 8,
+  MSG_SONG_ENTRY = 9
 } MessageType;
 
 // Main message structure for ESP-NOW sync
@@ -59,6 +66,48 @@ typedef struct {
       uint8_t reserved[2];    // Reserved (2 bytes)
     } pattern;
     
+    // GROOVE data (swing and step offsets, half a channel per message)
+    struct {
+      uint8_t channelId;      // Channel ID (1 byte)
+      uint8_t swing;          // Swing percent, 50 = straight (1 byte)
+      uint8_t firstStep;      // Step of offsets[0] (1 byte)
+      int8_t offsets[8];      // Step offsets in PPQN ticks (8 bytes)
+      uint8_t reserved[1];    // Reserved (1 byte)
+    } groove;
+    
+    // RAMP data (tempo ramp; no length cancels one)
+    struct {
+      uint32_t startTick;     // PPQN tick the ramp starts on (4 bytes)
+      uint16_t fromBpm;       // Tempo at the start (2 bytes)
+      uint16_t toBpm;         // Tempo at the end (2 bytes)
+      uint16_t lengthPulses;  // Length in SYNC24 pulses (2 bytes)
+      uint8_t shape;          // RampShape (1 byte)
+      uint8_t reserved;       // Reserved (1 byte)
+    } ramp;
+    
+    // CHANCE data (step trigger chances, half a channel per message)
+    struct {
+      uint8_t channelId;      // Channel ID (1 byte)
+      uint8_t firstStep;      // Step of chances[0] (1 byte)
+      uint8_t chances[8];     // Trigger chance in percent (8 bytes)
+      uint8_t reserved[2];    // Reserved (2 bytes)
+    } chance;
+    
+    // SONG data (song header and bar counts, eight entries per message)
+    struct {
+      uint8_t count;          // Entries in the song (1 byte)
+      uint8_t flags;          // Bit 0 loop (1 byte)
+      uint8_t firstEntry;     // Entry of bars[0] (1 byte)
+      uint8_t bars[8];        // Bars each entry plays (8 bytes)
+      uint8_t reserved;       // Reserved (1 byte)
+    } song;
+    
+    // SONG_ENTRY data (one song entry's preset)
+    struct {
+      uint8_t index;          // Entry index (1 byte)
+      uint8_t settings[11];   // Preset after its format byte (11 bytes)
+    } songEntry;
+    
     // CONTROL data
     struct {
       uint8_t command;        // Command code (1 byte)
@@ -72,7 +121,7 @@ typedef struct {
 
 // Control commands
 enum ControlCommand {
-  CMD_START = 1,
+  CMD_START = 1,   // value: session seed for step chances
   CMD_STOP = 2,
   CMD_PAUSE = 3,
   CMD_RESET = 4
@@ -84,19 +133,22 @@ private:
   uint8_t _deviceID[6];
   uint32_t _sequenceNum;
   uint8_t _priority;
-  bool _isLeader;
-  bool _initialized;
+  volatile bool _isLeader;
+  volatile bool _initialized;   // Set by the background boot task
   
   // Track which sync messages have been sent
   uint32_t _lastSync24Tick;
   uint32_t _lastQuarterNote;
   uint32_t _lastBarStart;
-  bool _patternChanged;
+  ChangeTracker _changes;      // Pattern, groove and chance generations already sent
   
   // Leader selection
   uint32_t _lastLeaderHeartbeat;
   uint32_t _leaderTimeoutMs;
-  bool _leaderNegotiationActive;
+  volatile bool _leaderNegotiationActive;
+  volatile bool _leaderNegotiated;      // A negotiation has finished, or setAsLeader()
+  uint32_t _negotiationStartMs;
+  uint32_t _negotiationWindowMs; // Time other devices get to answer
   uint8_t _currentLeaderID[6];
   uint8_t _highestPriorityDevice[6];
   uint8_t _highestPrioritySeen;
@@ -112,9 +164,24 @@ private:
   uint32_t _predictedNextTick;
   float _driftCorrection;
   
-  // State reference for pattern updates
+  // State reference for pattern updates; null until the loop first runs
+  // update(), and receive handlers skip what needs it until then
   MetronomeState* _state;
   
+  // Tempo ramp from the leader, until Timing takes it
+  TempoRamp _receivedRamp;
+  volatile bool _rampReceived;
+  
+  // Song from the leader: assembled here until complete, then Timing
+  // takes it; while a song plays its pattern changes are not sent
+  SongEntry _receivedSong[SONG_MAX_ENTRIES];
+  uint8_t _songCount;
+  bool _songLoop;
+  uint32_t _songEntriesMissing;   // Bit per entry
+  uint8_t _songChunksMissing;     // Bit per SONG message
+  volatile bool _songReceived;
+  bool _songPlaying;
+  
   // Helper functions for pattern length calculations
   uint16_t lcm(uint16_t a, uint16_t b);
   uint16_t gcd(uint16_t a, uint16_t b);
@@ -127,6 +194,7 @@ private:
   
   // Leader selection methods
   void startLeaderNegotiation();
+  void finishLeaderNegotiation();
   void processLeaderSelection(const SyncMessage &msg);
   bool isLeaderTimedOut();
   bool isHigherPriority(const uint8_t *deviceID, uint8_t priority);
@@ -145,10 +213,12 @@ public:
       _lastSync24Tick(0),
       _lastQuarterNote(0),
       _lastBarStart(0),
-      _patternChanged(false),
       _leaderTimeoutMs(3000),
       _lastLeaderHeartbeat(0),
       _leaderNegotiationActive(false),
+      _leaderNegotiated(false),
+      _negotiationStartMs(0),
+      _negotiationWindowMs(500),
       _highestPrioritySeen(0),
       _latencyBufferIndex(0),
       _averageLatency(0),
@@ -156,7 +226,14 @@ public:
       _lastReceivedTick(0),
       _predictedNextTick(0),
       _driftCorrection(1.0f),
-      _state(nullptr)
+      _state(nullptr),
+      _rampReceived(false),
+      _songCount(0),
+      _songLoop(false),
+      _songEntriesMissing(0),
+      _songChunksMissing(0),
+      _songReceived(false),
+      _songPlaying(false)
   {
       memset(_currentLeaderID, 0, sizeof(_currentLeaderID));
       memset(_highestPriorityDevice, 0, sizeof(_highestPriorityDevice));
@@ -178,9 +255,12 @@ public:
   // Check if this device is currently the leader
   bool isLeader() const;
   
-  // Leader negotiation
+  // Leader negotiation. It does not block: replies are collected until
+  // checkLeaderStatus() closes the window from the loop.
   void negotiateLeadership();
   void checkLeaderStatus();
+  bool isNegotiating() const { return _leaderNegotiationActive; }
+  bool hasNegotiated() const { return _leaderNegotiated; }
   
   // uClock callback handlers (to be connected to uClock callbacks)
   void onSync24(uint32_t tick);
@@ -195,12 +275,24 @@ public:
   // Send pattern definition
   void sendPattern(MetronomeState &state, uint8_t channelId);
   
+  // Send swing and step offsets
+  void sendGroove(MetronomeState &state, uint8_t channelId);
+  
+  // Send step trigger chances
+  void sendChance(MetronomeState &state, uint8_t channelId);
+  
+  // Send a tempo ramp (an empty one cancels), and take one received
+  void sendRamp(const TempoRamp &ramp);
+  bool takeRamp(TempoRamp &ramp);
+  
+  // Send a song before starting it, and take one received whole
+  void sendSong(const SongEntry *entries, uint8_t count, bool loop);
+  bool takeSong(SongEntry *entries, uint8_t &count, bool &loop);
+  void setSongPlaying(bool playing) { _songPlaying = playing; }
+  
   // Send control message
   void sendControl(uint8_t command, uint32_t value = 0);
   
-  // Handle pattern changes from the metronome state
-  void notifyPatternChanged(uint8_t channelId);
-  
   // Update function to be called in loop (for pattern change detection)
   void update(MetronomeState &state);
   
@@ -6,6 +6,20 @@
 #define ENCODER_BTN 16
 #define BTN_START 4
 #define BTN_STOP 19
+
+// Rotary encoder, decoded by the pulse counter peripheral
+#define ENCODER_PCNT_UNIT 0
+#define ENCODER_COUNTS_PER_DETENT 4 // Quadrature edges per click
+#define ENCODER_GLITCH_FILTER 1000  // APB cycles (12.5 us); shorter pulses are ignored
+#define ENCODER_ACCEL_SLOW_DPS 8    // Detents per second turned 1:1
+#define ENCODER_ACCEL_FAST_DPS 40   // Rate that gets the full BPM multiplier
+#define ENCODER_ACCEL_MAX 10
+
+// Buttons (ButtonInput)
+#define BUTTON_DEBOUNCE_US 20000    // Edges this soon after an accepted one are bounce
+#define BUTTON_QUEUE_SIZE 16
+#define CONTROL_TASK_PRIORITY 5     // Above the loop, so START/STOP preempt rendering
+#define PIEZO_PIN 35 // Strike sensor for solenoid latency calibration (input only)
 #define SOLENOID_PIN 14
 #define SOLENOID_PIN2 32
 // Remove DAC_PIN
@@ -21,10 +35,36 @@
 #define MAX_GLOBAL_BPM 300
 #define DEFAULT_BPM 120
 #define MAX_BEATS 16
+#define MIN_SWING 50              // Swing percent: 50 is straight,
+#define MAX_SWING 75              // 75 delays odd steps by half a step
+#define MAX_STEP_OFFSET_TICKS 48  // Per-step timing offset, PPQN ticks
 #define SOLENOID_PULSE_MS 5
 #define ACCENT_PULSE_MS 7
+#define SOLENOID_LATENCY_US 4000 // Fire-to-strike travel, fired this much early
+
+// Solenoid drive. GPIO drive fires coincident channels in one register
+// write; LEDC drive plays a velocity envelope (kick, then PWM hold). Both
+// switch the coils through registers from IRAM, so a strike does not wait
+// on the flash cache.
+#define SOLENOID_DRIVE_LEDC 0
+#define SOLENOID_LEDC_CHANNEL 4 // First LEDC channel (the buzzer uses 0 and 1)
+#define SOLENOID_PWM_FREQ 20000
+#define SOLENOID_PWM_RES 8
+#define SOLENOID_PWM_FULL_DUTY (1 << SOLENOID_PWM_RES)
+#define SOLENOID_KICK_MIN_US 2000     // Kick at velocity 0
+#define SOLENOID_KICK_MAX_US 7000     // Kick at velocity 255
+#define SOLENOID_HOLD_VELOCITY 192    // Hits at least this hard get a hold phase
+#define SOLENOID_HOLD_US 4000
+#define SOLENOID_HOLD_DUTY 64         // Hold duty out of SOLENOID_PWM_FULL_DUTY
+#define SOLENOID_SUPPLY_MV 12000      // For the energy report
+#define SOLENOID_COIL_MOHM 8000
+#define BUZZER_LATENCY_US 0
+#define LED_LATENCY_US 0
 #define SOUND_DURATION_MS 25        // Duration of sound on each beat (in ms)
 #define LONG_PRESS_DURATION_MS 1000 // Duration for long press in milliseconds
+#define CALIBRATION_SHOTS 8          // Solenoid strikes measured per channel
+#define CALIBRATION_INTERVAL_MS 300  // Time between calibration strikes
+#define CALIBRATION_TIMEOUT_US 50000 // Strike must be seen within this window
 
 // Multiplier values (in quarters)
 #define MULTIPLIER_COUNT 4
@@ -37,15 +77,56 @@
 
 // UI Constants
 #define FLASH_DURATION_MS 50
+#define FRAME_RATE_HZ 50 // Shared frame clock rate for display and LEDs
 
 // Configuration storage constants
 #define CONFIG_VERSION 1
 #define CONFIG_MAGIC_MARKER 0xCBEF // Magic bytes to verify config integrity
+#define CONFIG_STORE_VERSION 3     // Layout of the single-blob record
+#define CONFIG_DEBOUNCE_MS 2000    // Edits must settle this long before a commit
+
+// Preset bank
+#define PRESET_COUNT 32              // Slots (at most 32, indexed by a bitmask)
+#define PRESET_FORMAT 1              // Layout of a stored preset
+#define PRESET_SWITCH_MARGIN_TICKS 4 // Spare ticks between arming and the switch
+#define SERIAL_CONSOLE_LINE 48       // Longest serial command (SerialConsole)
+
+// Song mode
+#define SONG_MAX_ENTRIES 32 // Steps in a song (at most 32, tracked by a bitmask)
+#define SONG_FORMAT 1       // Layout of the stored song
+
+// Tempo ramps
+#define MAX_RAMP_BARS 64      // Longest ramp, in bars of channel 1
+#define RAMP_STEER_GAIN 0.5f  // Share of the timeline error taken out per loop pass
+#define RAMP_STEER_LIMIT 0.02f // Largest steering, as a share of the tick length
 
 // Fixed number of channels (for now)
 #define FIXED_CHANNEL_COUNT 2
 
 // LED strip configuration
 #define LED_BRIGHTNESS 50
-#define LED_FLASH_DURATION_FRACTION 0.1f // Flash duration as fraction of beat
-#define LED_BEAT_DURATION_MS 100
+#define LED_MAX_REFRESH_HZ 60 // Upper bound on strip pushes per second
+#define LED_OUTPUT_RMT 1      // 1 = non-blocking RMT output, 0 = FastLED.show()
+#define LED_PIN 27
+#define LED_COUNT 33
+#define LED_LAYOUT_STAGE 0       // 0 = single compact strip, 1 = multi-strip stage layout
+#define LED_MAX_OUTPUTS 4        // Parallel strips (one RMT channel each)
+#define LED_MAX_REGIONS 16
+#define LED_FRAME_BUDGET_US 1500 // Render time per frame before regions are deferred
+
+// Timing trace (TraceBuffer), printed over serial from the main loop
+#define TRACE_ENABLED 0
+#define TRACE_CAPACITY 256
+
+// Runtime telemetry (LED output, frame clock, solenoids, controls),
+// printed over serial from the main loop; 0 = off
+#define TELEMETRY_INTERVAL_MS 10000
+
+// Boot profiler
+#define BOOT_TARGET_MS 200 // Power-on to ready-to-play budget
+#define BOOT_MAX_PHASES 12
+
+// NVS stress test: write to flash continuously while playing and report
+// the worst tick delay once a second
+#define NVS_STRESS_TEST 0
+#define NVS_STRESS_INTERVAL_MS 20
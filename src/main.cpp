@@ -12,9 +12,16 @@
 #include "EncoderController.h"
 #include "WirelessSync.h"
 #include "Timing.h"
-#include "ConfigManager.h"
+#include "ConfigStore.h"
+#include "PresetBank.h"
+#include "SongChain.h"
+#include "SerialConsole.h"
+#include "BootProfiler.h"
 #include "LEDController.h"
 #include "BuzzerController.h"
+#include "FrameClock.h"
+#include "TraceBuffer.h"
+#include "PiezoCalibrator.h"
 
 MetronomeState state;
 Display display;
@@ -27,110 +34,245 @@ Timing timing(state, wirelessSync, solenoidController, &buzzerController);
 // Then create encoder controller with timing reference
 EncoderController encoderController(state, timing);
 LEDController ledController;
+FrameClock frameClock;
+ConfigStore configStore;
+PresetBank presetBank;
+SongChain songChain;
+SerialConsole serialConsole(state, timing, presetBank, songChain);
 
-// Global pointer to WirelessSync instance for pattern change notifications
-WirelessSync *globalWirelessSync = &wirelessSync;
+// Song the boot task resolved from flash, for the loop to load
+SongEntry bootSong[SONG_MAX_ENTRIES];
+uint8_t bootSongLength = 0;
+volatile bool bootSongReady = false;
 
-// Timer for periodic config saving
-unsigned long lastConfigSaveTime = 0;
-const unsigned long CONFIG_SAVE_INTERVAL = 60000; // Save every minute
-bool configModified = false;
+// Global pointer to the config store for MetronomeState persistence
+ConfigStore *globalConfigStore = &configStore;
+
+// Fire each solenoid against the piezo pickup and use the measured
+// fire-to-strike time as its latency offset
+void calibrateSolenoids()
+{
+    PiezoCalibrator calibrator(PIEZO_PIN);
+    calibrator.begin();
+
+    for (uint8_t channel = 0; channel < FIXED_CHANNEL_COUNT; channel++)
+    {
+        uint32_t latencyUs = calibrator.measure(solenoidController, channel);
+        if (latencyUs)
+        {
+            timing.setOutputLatency(LatencyOutput(LATENCY_SOLENOID1 + channel), latencyUs);
+            configStore.setSolenoidLatency(channel, latencyUs);
+            Serial.printf("Solenoid %u latency: %lu us\n", channel + 1, (unsigned long)latencyUs);
+        }
+        else
+        {
+            Serial.printf("Solenoid %u: no strike detected, keeping %lu us\n", channel + 1,
+                          (unsigned long)timing.getOutputLatency(LatencyOutput(LATENCY_SOLENOID1 + channel)));
+        }
+    }
+
+    calibrator.end();
+}
+
+#if NVS_STRESS_TEST
+// Hammer NVS while the metronome plays; every write disables the flash
+// cache, so the reported delay is what a commit costs the tick path
+void runNvsStress()
+{
+    static Preferences stressPrefs;
+    static bool opened = false;
+    static uint32_t lastWriteMs = 0;
+    static uint32_t lastReportMs = 0;
+    static uint32_t writes = 0;
+    static uint8_t scratch[64];
+
+    if (!opened)
+    {
+        opened = stressPrefs.begin("nvsstress", false);
+        timing.resetTickDelay();
+    }
+
+    uint32_t now = millis();
+    if (!opened || !state.isRunning || state.isPaused)
+    {
+        lastReportMs = now;
+        return;
+    }
+
+    if (now - lastWriteMs >= NVS_STRESS_INTERVAL_MS)
+    {
+        lastWriteMs = now;
+        scratch[writes % sizeof(scratch)]++;
+        stressPrefs.putBytes("scratch", scratch, sizeof(scratch));
+        writes++;
+    }
+
+    if (now - lastReportMs >= 1000)
+    {
+        lastReportMs = now;
+        Serial.printf("NVS stress: %lu writes, max tick delay %lu us\n",
+                      (unsigned long)writes, (unsigned long)timing.getMaxTickDelayUs());
+        timing.resetTickDelay();
+    }
+}
+#endif
+
+#if TELEMETRY_INTERVAL_MS
+// Counters the controllers keep, printed every TELEMETRY_INTERVAL_MS
+void reportTelemetry()
+{
+    static uint32_t lastReportMs = 0;
+    uint32_t now = millis();
+    if (now - lastReportMs < TELEMETRY_INTERVAL_MS)
+    {
+        return;
+    }
+    lastReportMs = now;
+
+    const LEDTelemetry &led = ledController.getTelemetry();
+    Serial.printf("LED: %u shows/s, %lu shown, %lu unchanged, %lu rate-limited, %lu frames skipped\n",
+                  led.showsPerSecond, (unsigned long)led.totalShows, (unsigned long)led.unchangedFrames,
+                  (unsigned long)led.rateLimitedFrames, (unsigned long)frameClock.getSkippedFrames());
+    Serial.printf("LED frame: push %lu us (max %lu), render %lu us, %lu regions deferred\n",
+                  (unsigned long)led.lastFrameCpuUs, (unsigned long)led.maxFrameCpuUs,
+                  (unsigned long)led.lastRenderUs, (unsigned long)led.deferredRegions);
+
+    for (uint8_t channel = 0; channel < FIXED_CHANNEL_COUNT; channel++)
+    {
+        const SolenoidStats &solenoid = solenoidController.getStats(channel);
+        Serial.printf("Solenoid %u: %lu strikes, duty %u.%u %%, %lu uJ per beat (kick %lu us, hold %lu us)\n",
+                      channel + 1, (unsigned long)solenoid.totalStrikes, solenoid.dutyPermille / 10,
+                      solenoid.dutyPermille % 10, (unsigned long)solenoid.lastEnergyUj,
+                      (unsigned long)solenoid.lastKickUs, (unsigned long)solenoid.lastHoldUs);
+    }
+
+    // START/STOP press to clock action, through the control task
+    Serial.printf("Transport: %lu us press to action (max %lu)\n", (unsigned long)timing.getTransportLatencyUs(),
+                  (unsigned long)timing.getMaxTransportLatencyUs());
+}
+#endif
+
+// Slow steps that nothing on the way to the first beat depends on. Runs
+// on the other core while setup() finishes, then deletes itself.
+void backgroundBootTask(void *)
+{
+    {
+        BootPhase phase("wireless");
+        if (wirelessSync.init())
+        {
+            // Set a random priority based on device ID
+            uint8_t devicePriority = random(1, 100);
+            wirelessSync.setPriority(devicePriority);
+
+            // Leader negotiation completes from the loop; Timing switches
+            // the clock source once it has settled
+            wirelessSync.negotiateLeadership();
+        }
+    }
+    {
+        BootPhase phase("presets");
+        presetBank.begin();
+    }
+    {
+        // Entries are read from the bank once here, so playing the song
+        // never touches flash
+        BootPhase phase("song");
+        songChain.begin();
+        bootSongLength = songChain.resolve(presetBank, bootSong);
+        bootSongReady = bootSongLength > 0;
+    }
+    vTaskDelete(nullptr);
+}
 
 void setup()
 {
+    uint8_t setupPhase = BootProfiler::begin("setup");
     Serial.begin(115200);
     Serial.println("Metronome starting...");
 
-    // Initialize Preferences
-    if (!ConfigManager::init())
+    xTaskCreatePinnedToCore(backgroundBootTask, "boot", 4096, nullptr, 1, nullptr, 0);
+
     {
-        Serial.println("Failed to initialize Preferences storage!");
+        BootPhase phase("config");
+
+        // Open the config store; it stays open for write-behind commits
+        configStore.begin();
+
+        // Try to load saved configuration
+        if (!state.loadFromStorage())
+        {
+            Serial.println("Using default configuration");
+        }
+        else
+        {
+            Serial.println("Loaded configuration from storage");
+        }
+
+        // Latencies from an earlier calibration run
+        for (uint8_t channel = 0; channel < FIXED_CHANNEL_COUNT; channel++)
+        {
+            uint32_t latencyUs = configStore.getSolenoidLatency(channel);
+            if (latencyUs)
+            {
+                timing.setOutputLatency(LatencyOutput(LATENCY_SOLENOID1 + channel), latencyUs);
+            }
+        }
     }
 
-    // Try to load saved configuration
-    if (!state.loadFromStorage())
     {
-        Serial.println("Using default configuration");
+        BootPhase phase("outputs");
+        solenoidController.init();
+        // Remove audioController.init();
+        buzzerController.init(); // Initialize buzzer controller
     }
-    else
     {
-        Serial.println("Loaded configuration from storage");
+        BootPhase phase("display");
+        display.begin();
     }
-
-    // Close preferences to free resources during normal operation
-    ConfigManager::end();
-
-    solenoidController.init();
-    // Remove audioController.init();
-    buzzerController.init(); // Initialize buzzer controller
-    display.begin();
     encoderController.begin();
-    ledController.init();
 
-    // Initialize wireless sync
-    if (wirelessSync.init())
+    // Hold STOP while powering up to calibrate the solenoid latencies
+    if (digitalRead(BTN_STOP) == LOW)
     {
-        // Set a random priority based on device ID
-        uint8_t devicePriority = random(1, 100);
-        wirelessSync.setPriority(devicePriority);
+        BootPhase phase("calibration");
+        calibrateSolenoids();
+    }
 
-        // Start leader negotiation
-        wirelessSync.negotiateLeadership();
+    {
+        // The startup chase plays from the loop, frame by frame
+        BootPhase phase("leds");
+        ledController.init();
     }
 
-    // Set display and LED controller references in timing
-    timing.setDisplay(&display);
+    // Set frame clock and LED controller references in timing
+    timing.setFrameClock(&frameClock);
     timing.setLEDController(&ledController);
 
     // Initialize timing system
     timing.init();
     timing.setTempo(state.bpm);
 
-    // Start animation immediately (even before playback starts)
-    display.startAnimation();
+    BootProfiler::end(setupPhase);
+    BootProfiler::markReady();
 }
 
 void loop()
 {
-    // Update timing system
-    timing.update();
-
-    // Make sure animation is always running
-    if (!display.isAnimationRunning())
+    // The stored song, once the boot task has read it
+    if (bootSongReady && !state.isRunning && !state.isPaused)
     {
-        display.startAnimation();
+        bootSongReady = false;
+        timing.loadSong(bootSong, bootSongLength, songChain.isLooping());
     }
 
-    // Handle user input
-    bool stateChanged = encoderController.handleControls();
-    if (stateChanged)
-    {
-        configModified = true;
-
-        // Save immediately on important changes
-        // Check if we're not in pattern editing mode (which changes frequently)
-        if (!state.isEditing)
-        {
-            // If we're changing BPM, rhythm mode, or channel properties, save right away
-            if (state.isBpmSelected() || state.isRhythmModeSelected() ||
-                state.isMultiplierSelected() || state.isChannelSelected())
-            {
-
-                // Initialize Preferences for saving
-                ConfigManager::init();
+    // Update timing system
+    timing.update();
 
-                if (state.saveToStorage())
-                {
-                    Serial.println("Configuration saved after important change");
-                    configModified = false;
-                    lastConfigSaveTime = millis();
-                }
+    // Handle user input
+    encoderController.handleControls();
 
-                // Close preferences to free resources
-                ConfigManager::end();
-            }
-        }
-    }
+    // Preset and song commands typed over serial
+    serialConsole.update();
 
     // Update state
     state.update();
@@ -141,31 +283,35 @@ void loop()
     // Check leader status periodically
     wirelessSync.checkLeaderStatus();
 
-    display.update(state);
-
-    // Update LED visualization
-    ledController.update(state);
+    // Render display and LEDs from the same beat-locked frame
+    FrameInfo frame;
+    if (frameClock.poll(micros(), frame))
+    {
+        display.update(state, frame);
+        ledController.update(state, frame);
+    }
 
     // Add buzzer update call
     buzzerController.update();
 
-    // Periodically save configuration if modified
-    unsigned long currentTime = millis();
-    if (configModified && (currentTime - lastConfigSaveTime > CONFIG_SAVE_INTERVAL))
-    {
-        // Initialize Preferences for saving
-        ConfigManager::init();
+#if TRACE_ENABLED
+    // Pulse timing records, e.g. solenoid widths measured by their timers
+    TraceBuffer::printPending(8);
+#endif
 
-        if (state.saveToStorage())
-        {
-            Serial.println("Configuration auto-saved");
-            configModified = false;
-            lastConfigSaveTime = currentTime;
-        }
+#if NVS_STRESS_TEST
+    runNvsStress();
+#endif
 
-        // Close preferences to free resources
-        ConfigManager::end();
-    }
+    // Persist settled edits at a quiet point (stopped or just past a bar);
+    // not a song's entries
+    configStore.update(state, millis(), timing.isSongSetup());
+
+    BootProfiler::reportWhenDone();
+
+#if TELEMETRY_INTERVAL_MS
+    reportTelemetry();
+#endif
 
     // Prevent watchdog timeouts
     yield();